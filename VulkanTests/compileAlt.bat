@@ -4,6 +4,22 @@ glslc.exe shaders\g_buffer_shader.vert -o shaders\g_buffer_shader.vert.spv
 glslc.exe shaders\g_buffer_shader.frag -o shaders\g_buffer_shader.frag.spv
 glslc.exe shaders\light_shader.vert -o shaders\light_shader.vert.spv
 glslc.exe shaders\light_shader.frag -o shaders\light_shader.frag.spv
+glslc.exe -DINPUT_ATTACHMENTS shaders\light_shader.frag -o shaders\light_shader_subpass.frag.spv
 glslc.exe shaders\reflection_shader.vert -o shaders\reflection_shader.vert.spv
 glslc.exe shaders\reflection_shader.frag -o shaders\reflection_shader.frag.spv
+glslc.exe shaders\hiz_reduce.comp -o shaders\hiz_reduce.comp.spv
+glslc.exe shaders\occlusion_cull.comp -o shaders\occlusion_cull.comp.spv
+glslc.exe shaders\light_cluster.comp -o shaders\light_cluster.comp.spv
+glslc.exe shaders\depth_prepass.vert -o shaders\depth_prepass.vert.spv
+glslc.exe shaders\depth_prepass_masked.vert -o shaders\depth_prepass_masked.vert.spv
+glslc.exe shaders\depth_prepass_masked.frag -o shaders\depth_prepass_masked.frag.spv
+glslc.exe shaders\light_volume.vert -o shaders\light_volume.vert.spv
+glslc.exe -DLIGHT_VOLUMES shaders\light_shader.frag -o shaders\light_volume.frag.spv
+glslc.exe -DLIGHT_VOLUMES -DINPUT_ATTACHMENTS shaders\light_shader.frag -o shaders\light_volume_subpass.frag.spv
+glslc.exe -DREDUCE_MIN shaders\hiz_reduce.comp -o shaders\hiz_reduce_min.comp.spv
+glslc.exe -DLINEAR_MARCH shaders\ssr_shader.frag -o shaders\ssr_linear_shader.frag.spv
+glslc.exe shaders\ssr_trace.comp -o shaders\ssr_trace.comp.spv
+glslc.exe shaders\ssr_temporal.comp -o shaders\ssr_temporal.comp.spv
+glslc.exe -DUPSAMPLE shaders\ssr_shader.frag -o shaders\ssr_upsample_shader.frag.spv
+glslc.exe shaders\ssr_classify.comp -o shaders\ssr_classify.comp.spv
 pause
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Position only version of g_buffer_shader.vert, gl_Position has to be computed the exact same way for the EQUAL depth test of the G-buffer pass
+layout (location = 0) in vec3 position;
+
+invariant gl_Position;
+
+#include "global_ubo.glsl"
+
+struct ObjectData
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+};
+
+// Frame ring buffer, the draw's first instance is the object slot
+layout (set = 0, binding = 2) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+} objectBuffer;
+
+void main() {
+	vec4 positionWorld = objectBuffer.objects[gl_InstanceIndex].modelMatrix * vec4(position, 1.0);
+
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+}
@@ -0,0 +1,14 @@
+#version 450
+
+layout (location = 0) in vec2 fragUV;
+
+layout(set = 1, binding = 0) uniform sampler2D albedoMap;
+
+void main() 
+{
+	// Same alpha test as the G-buffer pass, so both passes agree on which fragments exist
+	if(texture(albedoMap, fragUV).a < 0.5)
+	{
+		discard;
+	}
+}
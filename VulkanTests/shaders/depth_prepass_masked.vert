@@ -0,0 +1,32 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Depth pre-pass for alpha masked materials, only the uv is passed on for the alpha test
+layout (location = 0) in vec3 position;
+layout (location = 3) in vec2 uv;
+
+layout (location = 0) out vec2 fragUV;
+
+invariant gl_Position;
+
+#include "global_ubo.glsl"
+
+struct ObjectData
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+};
+
+// Frame ring buffer, the draw's first instance is the object slot
+layout (set = 0, binding = 2) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+} objectBuffer;
+
+void main() {
+	vec4 positionWorld = objectBuffer.objects[gl_InstanceIndex].modelMatrix * vec4(position, 1.0);
+
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+
+	fragUV = uv;
+}
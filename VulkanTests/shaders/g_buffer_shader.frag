@@ -1,5 +1,6 @@
 #version 450
 #extension GL_KHR_vulkan_glsl: enable
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 fragPosition;
 layout (location = 1) in vec2 fragUV;
@@ -8,27 +9,12 @@ layout (location = 3) in vec4 fragTangent;
 layout (location = 4) in mat3 TBN;
 
 layout (location = 0) out vec4 outAlbedo;
-layout (location = 1) out vec4 outPosition;
-layout (location = 2) out vec4 outNormal;
+layout (location = 1) out vec4 outMaterial; // metallic, roughness, ambient occlusion
+layout (location = 2) out vec2 outNormal; // octahedral encoded, view space
 
 const float PI = 3.14159265359;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	mat4 inverseProjection;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
 
 layout(set = 0, binding = 1) uniform sampler2D image;
 
@@ -54,11 +40,6 @@ layout(set = 1, binding = 5) uniform PBRParameters {
     int has_emissive_texture;
 } pbrParameters;
 
-layout (push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
-
 // Calculate the surface normal
 vec3 getSurfaceNormal() {
     vec3 tangentNormal = 2.0 * normalize(texture(normalMap, fragUV).xyz) - 1.0;
@@ -68,6 +49,16 @@ vec3 getSurfaceNormal() {
     return normalize(TBN * tangentNormal);
 }
 
+// Maps a unit vector on the octahedron unfolded in [-1, 1]^2
+vec2 octahedralEncode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0) {
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return n.xy;
+}
+
 // Convert Srgb to Linear
 vec4 SRGBtoLINEAR(vec4 srgbIn) {
 	vec3 linOut = pow(srgbIn.xyz, vec3(2.2));
@@ -79,7 +70,8 @@ void main()
 {
 	// Retrieve material properties from textures and parameters
 	vec4 albedo = texture(albedoMap, fragUV);
-	if(albedo.a < 0.5)
+	// glTF OPAQUE ignores the alpha, its depth pre-pass writes every fragment
+	if(pbrParameters.alpha_mode > 0.5 && albedo.a < 0.5)
 	{
 		discard;
 	}
@@ -87,7 +79,13 @@ void main()
 	float metallic = normalize(texture(metallicRoughnessMap, fragUV)).b;
 	float roughness = normalize(texture(metallicRoughnessMap, fragUV)).g;
 
-	outAlbedo = vec4(albedo.rgb, roughness);
-    outPosition = vec4(mat3(ubo.view) * fragPosition, 1.0);
-    outNormal = vec4(normalize(mat3(ubo.view)*fragNormal), metallic);
+	float ao = 1.0;
+	if (pbrParameters.has_occlusion_texture == 1) {
+		ao = 1.0 + pbrParameters.strength * (texture(occlusionMap, fragUV).r - 1.0);
+	}
+
+	// The position is rebuilt from the depth by the passes reading the G-buffer
+	outAlbedo = vec4(albedo.rgb, 1.0);
+	outMaterial = vec4(metallic, roughness, ao, 0.0);
+	outNormal = octahedralEncode(normalize(mat3(ubo.view)*fragNormal));
 }
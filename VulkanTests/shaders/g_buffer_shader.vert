@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
@@ -11,40 +12,36 @@ layout (location = 2) out vec3 fragNormal;
 layout (location = 3) out vec4 fragTangent;
 layout (location = 4) out mat3 TBN;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
+// Must match the depth pre-pass bit for bit for the EQUAL depth test
+invariant gl_Position;
+
+#include "global_ubo.glsl"
 
-layout (set = 0, binding = 0) uniform GlobalUbo 
+struct ObjectData
 {
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	mat4 inverseProjection;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
-
-layout (push_constant) uniform Push {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+};
+
+// Frame ring buffer, the draw's first instance is the object slot
+layout (set = 0, binding = 2) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+} objectBuffer;
 
 void main() {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+	ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+	vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
 
 	gl_Position = ubo.projection * ubo.view * positionWorld;
 
-	mat3 m3_model = mat3(push.modelMatrix);
+	mat3 m3_model = mat3(object.modelMatrix);
 
 	// Set the TBN matrix in world space
-	fragNormal = normalize((push.modelMatrix * vec4(normal, 0.0)).xyz);
+	fragNormal = normalize((object.modelMatrix * vec4(normal, 0.0)).xyz);
 
 	vec4 tangents = vec4(normalize(m3_model * tangent.xyz), tangent.w);
-	vec3 N = normalize(mat3(push.normalMatrix) * normal);
+	vec3 N = normalize(mat3(object.normalMatrix) * normal);
 	vec3 T = tangents.xyz;
 	vec3 B = cross(N, T) * tangents.w;
 	TBN = mat3(T, B, N);
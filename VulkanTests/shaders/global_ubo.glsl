@@ -0,0 +1,12 @@
+// Per frame camera data, matches GlobalUbo in vt_frame_info.hpp
+layout(set = 0, binding = 0) uniform GlobalUbo
+{
+	mat4 projection;
+	mat4 view;
+	mat4 inverseView;
+	mat4 inverseProjection;
+	vec4 ambientLightColor; // w is intensity
+	float nearPlane;
+	float farPlane;
+	uint lightCount;
+} ubo;
@@ -1,36 +1,83 @@
 #version 450
 #extension GL_KHR_vulkan_glsl: enable
-
+#extension GL_GOOGLE_include_directive : require
+
+#ifdef LIGHT_VOLUMES
+// One instance per light, drawn over the screen rectangle of its range sphere
+layout(location = 0) flat in uint lightIndex;
+// In the lighting subpass the depth bounds of the light reject fragments before any G-buffer read, the shader writes no depth
+layout(early_fragment_tests) in;
+#else
 layout(location = 0) in vec2 UV;
+#endif
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	mat4 inverseProjection;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
+#include "point_lights.glsl"
+#include "light_clusters.glsl"
 
+// Lists written by light_cluster.comp
+layout(std430, set = 0, binding = 4) readonly buffer Clusters {
+	uint clusterLightCounts[CLUSTER_COUNT];
+	uint clusterLightIndices[];
+};
 
+#ifdef INPUT_ATTACHMENTS
+// Lighting subpass of the G-buffer render pass, only the pixel being shaded can be read
+layout(input_attachment_index = 0, set = 2, binding = 0) uniform subpassInput albedoInput;
+layout(input_attachment_index = 1, set = 2, binding = 1) uniform subpassInput materialInput;
+layout(input_attachment_index = 2, set = 2, binding = 2) uniform subpassInput normalInput;
+layout(input_attachment_index = 3, set = 2, binding = 3) uniform subpassInput depthInput;
+#else
 layout(set = 2, binding = 0) uniform sampler2D albedoTexture;
-layout(set = 2, binding = 1) uniform sampler2D positionTexture;
+layout(set = 2, binding = 1) uniform sampler2D materialTexture;
 layout(set = 2, binding = 2) uniform sampler2D normalTexture;
 layout(set = 2, binding = 3) uniform sampler2D depthTexture;
+#endif
 
 layout(location = 0) out vec4 outColor;
 
+layout(push_constant) uniform Push {
+	vec2 inverseScreenSize;
+	uint shadeLights; // 0 when the lights are added by light volumes, only the ambient term is written
+} push;
+
 
 const float PI = 3.14159265359;
 
+//view space position from UV coordinates and depth. Reconstructing the view position.
+vec3 positionFromDepth(vec2 texturePos, float depth) {
+	vec4 ndc = vec4((texturePos - 0.5) * 2, depth, 1.f); //converting UVs to screen space coordinates
+	vec4 inversed = ubo.inverseProjection * ndc;// going back to view space
+	inversed /= inversed.w; //normalization
+	return inversed.xyz;
+}
+
+// Inverse of the G-buffer octahedral encoding
+vec3 octahedralDecode(vec2 encoded) {
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (n.z < 0.0) {
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return normalize(n);
+}
+
+// Cluster of a pixel, from its screen position and its distance along the view axis
+uint clusterIndex(vec2 texturePos, float viewDepth) {
+	uvec2 tile = min(uvec2(texturePos * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y)), uvec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+	float slice = log(max(viewDepth, ubo.nearPlane) / ubo.nearPlane) * float(CLUSTER_COUNT_Z) / log(ubo.farPlane / ubo.nearPlane);
+	uint sliceIndex = min(uint(slice), CLUSTER_COUNT_Z - 1);
+	return tile.x + tile.y * CLUSTER_COUNT_X + sliceIndex * CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+}
+
+// Inverse square falloff windowed to reach exactly zero at the light range
+float rangeAttenuation(float distance, float range) {
+	float ratio = distance / range;
+	float ratio2 = ratio * ratio;
+	float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+	return (window * window) / (distance * distance + 1.0);
+}
+
 // Convert Srgb to Linear
 vec4 SRGBtoLINEAR(vec4 srgbIn) {
 	vec3 linOut = pow(srgbIn.xyz, vec3(2.2));
@@ -83,18 +130,59 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
 }
 
 
-void main() {
-    vec4 albedoRoughness = texture(albedoTexture, UV);
-    vec3 position = texture(positionTexture, UV).rgb;
-    vec4 normalMetallic = texture(normalTexture, UV);
-    float depth = texture(depthTexture, UV).r;
+// Light reflected toward the viewer by one point light
+vec3 pointLightContribution(PointLight light, vec3 position, vec3 normal, vec3 viewVector, vec3 albedo, vec3 F0, float metallic, float roughness) {
+	vec3 lightPosition = (ubo.view * vec4(light.position.xyz, 1.0)).xyz;
+
+	vec3 lightDirection = normalize(lightPosition - position);	// Calculate the direction from the surface point to the light source
+	vec3 H = normalize(viewVector + lightDirection);					// Calculate the halfway vector between the view vector and the light vector
+	float distance = length(lightPosition - position);			// Calculate the distance between the light source and the surface point
+	float attenuation = rangeAttenuation(distance, light.position.w);	// Calculate the attenuation factor based on the distance, zero past the range
+	vec3 radiance = light.color.rgb * light.color.w * attenuation;		// Calculate the radiance of the light source
 
-    vec3 albedo = albedoRoughness.rgb;
-    float roughness = albedoRoughness.a;
-    vec3 normal = normalMetallic.rgb;
-    float metallic = normalMetallic.a;
+	float NDF = DistributionGGX(normal, H, roughness);						// Calculate the Normal Distribution Function (NDF) term
+	float G = GeometrySmith(normal, viewVector, lightDirection, roughness);	// Calculate the Geometry Function (G) term
+	vec3 F = fresnelSchlick(max(dot(H, viewVector), 0.0), F0);						// Calculate the Fresnel term (F)
 
-    float ao = 1; //unsupported
+	vec3 numerator = NDF * G * F;																								// Calculate the numerator for the specular reflection
+	float denominator = 4.0 * max(dot(normal, viewVector), 0.0) * max(dot(normal, lightDirection), 0.0) + 0.0001;	// Calculate the denominator for the specular reflection
+	vec3 specular = numerator / denominator;																					// Calculate the specular reflection contribution
+
+	// Calculate the diffuse reflection (kD) and specular reflection (kS) components
+	vec3 kS = F;
+	vec3 kD = vec3(1.0) - kS;
+	kD *= 1.0 - metallic;
+
+	// Calculate the dot product between the surface normal and the light vector
+	float NdotL = max(dot(normal, lightDirection), 0.0);
+
+	// Calculate the final output color by combining the diffuse and specular reflections
+	return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
+void main() {
+#ifdef LIGHT_VOLUMES
+    vec2 texturePos = gl_FragCoord.xy * push.inverseScreenSize;
+#else
+    vec2 texturePos = UV;
+#endif
+#ifdef INPUT_ATTACHMENTS
+    vec3 albedo = subpassLoad(albedoInput).rgb;
+    vec4 material = subpassLoad(materialInput);
+    vec2 encodedNormal = subpassLoad(normalInput).rg;
+    float depth = subpassLoad(depthInput).r;
+#else
+    vec3 albedo = texture(albedoTexture, texturePos).rgb;
+    vec4 material = texture(materialTexture, texturePos);
+    vec2 encodedNormal = texture(normalTexture, texturePos).rg;
+    float depth = texture(depthTexture, texturePos).r;
+#endif
+
+    vec3 position = positionFromDepth(texturePos, depth); //View space
+    vec3 normal = octahedralDecode(encodedNormal);
+    float metallic = material.r;
+    float roughness = material.g;
+    float ao = material.b;
 
     // Fake ambient light
 	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
@@ -112,38 +200,24 @@ void main() {
 	// Initialize the outgoing light color
 	vec3 Lo = vec3(0.0);
 
-	// TODO: Calculate the lighting contribution here
-	for (int i = 0; i < ubo.numLights; i++) {
-		// Reference to the current point light
-		PointLight light = ubo.pointLights[i];	
-		vec3 lightPosition = mat3(ubo.view) * light.position.xyz;
-
-
-		vec3 lightDirection = normalize(lightPosition - position);	// Calculate the direction from the surface point to the light source
-		vec3 H = normalize(viewVector + lightDirection);					// Calculate the halfway vector between the view vector and the light vector
-		float distance = length(lightPosition - position);			// Calculate the distance between the light source and the surface point
-		float attenuation = 1.0 / (distance * distance);					// Calculate the attenuation factor based on the distance
-		vec3 intensity = light.color.xyz * light.color.w * attenuation;		// Calculate the intensity of the light
-		vec3 radiance = light.color.rgb * attenuation * intensity;			// Calculate the radiance of the light source
-
-		float NDF = DistributionGGX(normal, H, roughness);						// Calculate the Normal Distribution Function (NDF) term
-		float G = GeometrySmith(normal, viewVector, lightDirection, roughness);	// Calculate the Geometry Function (G) term
-		vec3 F = fresnelSchlick(max(dot(H, viewVector), 0.0), F0);						// Calculate the Fresnel term (F)
-
-		vec3 numerator = NDF * G * F;																								// Calculate the numerator for the specular reflection
-		float denominator = 4.0 * max(dot(normal, viewVector), 0.0) * max(dot(normal, lightDirection), 0.0) + 0.0001;	// Calculate the denominator for the specular reflection
-		vec3 specular = numerator / denominator;																					// Calculate the specular reflection contribution
-
-		// Calculate the diffuse reflection (kD) and specular reflection (kS) components
-		vec3 kS = F;
-		vec3 kD = vec3(1.0) - kS;
-		kD *= 1.0 - metallic;
-
-		// Calculate the dot product between the surface normal and the light vector
-		float NdotL = max(dot(normal, lightDirection), 0.0);
+#ifdef LIGHT_VOLUMES
+	// Pixels of the rectangle whose surface is outside the light range are rejected before any shading. The depth bounds
+	// (lighting subpass) already removed those in front of or behind the sphere, this catches the corners of the rectangle
+	PointLight light = lights[lightIndex];
+	vec3 lightPosition = (ubo.view * vec4(light.position.xyz, 1.0)).xyz;
+	if (length(lightPosition - position) >= light.position.w) {
+		discard;
+	}
 
-		// Calculate the final output color by combining the diffuse and specular reflections
-		Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+	// Added to the ambient term by blending
+	outColor = vec4(pointLightContribution(light, position, normal, viewVector, albedo, F0, metallic, roughness), 1.0);
+#else
+	// Only the lights whose range reaches the cluster of this pixel
+	uint cluster = clusterIndex(texturePos, abs(position.z));
+	uint clusterLightCount = push.shadeLights != 0 ? clusterLightCounts[cluster] : 0;
+	for (uint i = 0; i < clusterLightCount; i++) {
+		PointLight light = lights[clusterLightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+		Lo += pointLightContribution(light, position, normal, viewVector, albedo, F0, metallic, roughness);
 	}
 
 	// Calculate the specular reflection component
@@ -165,5 +239,6 @@ void main() {
 	}*/
 
 	outColor = vec4(color, 1.0);
+#endif
 
 }
@@ -0,0 +1,49 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Screen rectangle covering the range sphere of one light, drawn instanced with one instance per light.
+// The fragment shader (light_shader.frag built with LIGHT_VOLUMES) only shades the pixels of that rectangle.
+
+#include "global_ubo.glsl"
+#include "point_lights.glsl"
+
+const vec2 quadCorners[6] = { vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0) };
+
+layout(location = 0) flat out uint lightIndex;
+
+void main()
+{
+	PointLight light = lights[gl_InstanceIndex];
+	vec3 center = (ubo.view * vec4(light.position.xyz, 1.0)).xyz;
+	float range = light.position.w;
+	lightIndex = gl_InstanceIndex;
+
+	// w of a perspective projection is the distance in front of the camera, whatever the handedness of the view space
+	float viewDepth = (ubo.projection * vec4(center, 1.0)).w;
+
+	vec2 rectMin = vec2(-1.0);
+	vec2 rectMax = vec2(1.0);
+	if (viewDepth + range < ubo.nearPlane)
+	{
+		// Behind the camera, the rectangle collapses and no fragment is produced
+		rectMax = rectMin;
+	}
+	else if (viewDepth - range > ubo.nearPlane)
+	{
+		// Projected corners of the view space box around the sphere, the camera being outside of it
+		rectMin = vec2(1.0);
+		rectMax = vec2(-1.0);
+		for (int i = 0; i < 8; i++)
+		{
+			vec3 corner = center + range * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+			vec4 clip = ubo.projection * vec4(corner, 1.0);
+			rectMin = min(rectMin, clip.xy / clip.w);
+			rectMax = max(rectMax, clip.xy / clip.w);
+		}
+		rectMin = clamp(rectMin, vec2(-1.0), vec2(1.0));
+		rectMax = clamp(rectMax, vec2(-1.0), vec2(1.0));
+	}
+	// Otherwise the sphere crosses the near plane and covers the whole screen
+
+	gl_Position = vec4(mix(rectMin, rectMax, quadCorners[gl_VertexIndex]), 0.0, 1.0);
+}
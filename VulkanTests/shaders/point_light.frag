@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec2 fragOffset;
 
@@ -6,21 +7,7 @@ layout (location = 0) out vec4 outAlbedo;
 layout (location = 1) out vec4 outPosition;
 layout (location = 2) out vec4 outNormal;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
 
 layout (push_constant) uniform Push 
 {
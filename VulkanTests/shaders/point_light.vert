@@ -1,5 +1,6 @@
 #version 450
 #extension GL_KHR_vulkan_glsl: enable
+#extension GL_GOOGLE_include_directive : require
 
 const vec2 OFFSETS[6] = vec2[](
   vec2(-1.0, -1.0),
@@ -12,21 +13,7 @@ const vec2 OFFSETS[6] = vec2[](
 
 layout (location = 0) out vec2 fragOffset;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
 
 layout (push_constant) uniform Push 
 {
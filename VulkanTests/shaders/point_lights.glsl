@@ -0,0 +1,10 @@
+// Every point light of the scene, written by VtLightBuffer. ubo.lightCount of them are valid
+struct PointLight
+{
+	vec4 position; // world space, w is the range
+	vec4 color; // w is intensity
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer Lights {
+	PointLight lights[];
+};
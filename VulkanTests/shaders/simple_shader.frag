@@ -1,5 +1,6 @@
 #version 450
 #extension GL_KHR_vulkan_glsl: enable
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 fragPosition;
 layout (location = 1) in vec2 fragUV;
@@ -11,21 +12,8 @@ layout (location = 0) out vec4 outColor;
 
 const float PI = 3.14159265359;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
+#include "point_lights.glsl"
 
 layout(set = 0, binding = 1) uniform sampler2D image;
 
@@ -147,8 +135,8 @@ void main()
 	vec3 Lo = vec3(0.0);
 
 	// TODO: Calculate the lighting contribution here
-	for (int i = 0; i < ubo.numLights; i++) {
-		PointLight light = ubo.pointLights[i];								// Reference to the current point light
+	for (uint i = 0; i < ubo.lightCount; i++) {
+		PointLight light = lights[i];								// Reference to the current point light
 		vec3 lightDirection = normalize(light.position.xyz - fragPosition);	// Calculate the direction from the surface point to the light source
 		vec3 H = normalize(viewVector + lightDirection);					// Calculate the halfway vector between the view vector and the light vector
 		float distance = length(light.position.xyz - fragPosition);			// Calculate the distance between the light source and the surface point
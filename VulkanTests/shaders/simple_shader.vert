@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
@@ -11,21 +12,7 @@ layout (location = 2) out vec3 fragNormal;
 layout (location = 3) out vec4 fragTangent;
 layout (location = 4) out mat3 TBN;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
 
 layout (push_constant) uniform Push {
 	mat4 modelMatrix;
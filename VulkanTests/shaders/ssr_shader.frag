@@ -1,110 +1,100 @@
 #version 450
 #extension GL_KHR_vulkan_glsl: enable
+#extension GL_GOOGLE_include_directive : require
 
 layout(location = 0) in vec2 UV;
 
-struct PointLight 
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
-layout (set = 0, binding = 0) uniform GlobalUbo 
-{
-	mat4 projection;
-	mat4 view;
-	mat4 inverseView;
-	mat4 inverseProjection;
-	vec4 ambientLightColor;	// w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+#include "global_ubo.glsl"
 
 layout(set = 2, binding = 0) uniform sampler2D lightingOutputTexture;
-layout(set = 2, binding = 1) uniform sampler2D albedoTexture;
-layout(set = 2, binding = 2) uniform sampler2D positionTexture;
-layout(set = 2, binding = 3) uniform sampler2D normalTexture;
-layout(set = 2, binding = 4) uniform sampler2D depthTexture;
+layout(set = 2, binding = 1) uniform sampler2D materialTexture;
+layout(set = 2, binding = 2) uniform sampler2D normalTexture;
+layout(set = 2, binding = 3) uniform sampler2D depthTexture;
+// Closest depth of every texel footprint, level 0 is a copy of depthTexture (ssr_depth_pyramid_system)
+layout(set = 2, binding = 4) uniform sampler2D depthPyramid;
 
 layout(location = 0) out vec4 outColor;
 layout(location = 1) out vec4 outDebugResult;
 
 
 const float PI = 3.14159265359;
-const int iterationCount = 100; //Max iterations per ray
-const float rayStep = 0.2f;
-const float distanceBias = 0.05f; //distance at which a ray validates a hit
 const float reflectionBlendingFactor = 25; //0: mirror like surfaces 5: roughness = 0.2 => no reflection 
 
-//view space position to screen space to UV coordinates
-vec2 projectedPosition(vec3 pos){
-	vec4 samplePosition = ubo.projection * vec4(pos, 1.f);
-	samplePosition.xy = (samplePosition.xy / samplePosition.w) * 0.5 + 0.5;
-	return samplePosition.xy;
-}
-
-//view space position from UV coordinates and depth. Reconstructing the view position.
-vec3 positionFromDepth(vec2 texturePos, float depth) {
-	vec4 ndc = vec4((texturePos - 0.5) * 2, depth, 1.f); //converting UVs to screen space coordinates
-	vec4 inversed = ubo.inverseProjection * ndc;// going back to view space
-	inversed /= inversed.w; //normalization
-	return inversed.xyz;
-}
-
-vec3 SSR(vec3 position, vec3 reflection)
-{
-	vec3 step = rayStep * reflection;
-	vec3 marchingPosition = position + step; //view space position between incremented to build the ray
-	float delta;
-	float screenPosDepth;
-	vec2 screenPosition;
-
-	int i = 0;
-	for(; i < iterationCount; i++)
-	{
-		screenPosition = projectedPosition(marchingPosition);
-		screenPosDepth = abs(positionFromDepth(screenPosition,  texture(depthTexture, screenPosition).r).z);
-		delta = abs(marchingPosition.z) - screenPosDepth;
-		if (abs(delta) < distanceBias) {
-			vec3 color = vec3(1);
-			return texture(lightingOutputTexture, screenPosition).xyz;
-		}
-		else {
-			//Adapts step length
-			float directionSign = sign(abs(marchingPosition.z) - screenPosDepth);
-			step = step * (1.0 - rayStep * max(directionSign, 0.0));
-			marchingPosition += step * (-directionSign);
+#include "ssr_trace.glsl"
+
+#ifdef UPSAMPLE
+// Reduced resolution reflections of ssr_trace.comp accumulated by ssr_temporal.comp, alpha is the hit rate
+layout(set = 2, binding = 5) uniform sampler2D reflectionTexture;
+
+layout(push_constant) uniform Push {
+	ivec2 traceSize;
+	int traceScale; // trace texel t traced the pixel t * traceScale
+} push;
+
+const float depthTolerance = 0.02; //relative view depth difference that divides a tap weight by e
+const float normalSharpness = 16.0;
+
+// The 4 closest trace texels weighted by their bilinear weight, by how close the surface they traced is to the one of this pixel
+// and by whether they traced a ray at all, so reflections do not leak across edges or from rough surfaces
+vec4 upsampleReflection(vec3 position, vec3 normal) {
+	ivec2 fullSize = textureSize(depthTexture, 0);
+	vec2 traceCoord = (gl_FragCoord.xy - 0.5) / float(push.traceScale);
+	ivec2 base = ivec2(floor(traceCoord));
+	vec2 fraction = traceCoord - vec2(base);
+
+	vec4 reflection = vec4(0.0);
+	float totalWeight = 0.0;
+	for (int i = 0; i < 4; i++) {
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), push.traceSize - 1);
+		ivec2 tracedPixel = min(texel * push.traceScale, fullSize - 1);
+
+		vec3 tapPosition = positionFromDepth((vec2(tracedPixel) + 0.5) / vec2(fullSize), texelFetch(depthTexture, tracedPixel, 0).r);
+		vec3 tapNormal = octahedralDecode(texelFetch(normalTexture, tracedPixel, 0).rg);
+		bool tapReflective = texelFetch(materialTexture, tracedPixel, 0).g < maxReflectiveRoughness;
+
+		vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+		float weight = bilinear.x * bilinear.y;
+		weight *= exp(-abs(tapPosition.z - position.z) / (depthTolerance * abs(position.z)));
+		weight *= pow(max(dot(normal, tapNormal), 0.0), normalSharpness);
+		weight *= tapReflective ? 1.0 : 0.0;
+
+		reflection += texelFetch(reflectionTexture, texel, 0) * weight;
+		totalWeight += weight;
+	}
 
-			// marchingPosition += step;
-			// step *= 1.05;
-		}
+	//No tap traced the same surface (thinner than the trace spacing), the closest one is still better than nothing
+	if (totalWeight < 1e-4) {
+		return texelFetch(reflectionTexture, clamp(ivec2(round(traceCoord)), ivec2(0), push.traceSize - 1), 0);
 	}
-	return vec3(0.0);
+	return reflection / totalWeight;
 }
-
+#endif
 
 void main() {
 	vec4 lightingOutput = texture(lightingOutputTexture, UV);
-    vec4 albedoRoughness = texture(albedoTexture, UV);
+    vec4 material = texture(materialTexture, UV);
 	float depth = texture(depthTexture, UV).r;
     vec3 position =  positionFromDepth(UV, depth); //View space
-    vec4 normalMetallic = texture(normalTexture, UV); //View space
-
-    vec3 albedo = albedoRoughness.rgb;
-    float roughness = albedoRoughness.a;
-    vec4 normal = vec4(normalMetallic.rgb, 0.0);
-    float metallic = normalMetallic.a;
+    vec4 normal = vec4(octahedralDecode(texture(normalTexture, UV).rg), 0.0); //View space
 
-    float ao = 1; //unsupported
+    float roughness = material.g;
 
 
 	outColor = vec4(lightingOutput.rgb, 1.0);
 	//This is one possible use of SSR
-	if(roughness < 0.1)
+	if(roughness < maxReflectiveRoughness)
 	{
+#ifdef UPSAMPLE
+		vec4 reflection = upsampleReflection(position, normal.xyz);
+		vec4 reflectionColor = vec4(reflection.rgb, 1.f);
+		bool hit = reflection.a > 0.5;
+#else
 		vec3 reflectionDirection = normalize(reflect( normalize(position), normalize(normal.xyz))); // Instead of position it should have position - cameraPosition, but cameraPosition is zero in view space. :/
 		vec4 reflectionColor = vec4(SSR(position, normalize(reflectionDirection)), 1.f); 
-		if (reflectionColor.rgb != vec3(0.f)){
+		bool hit = reflectionColor.rgb != vec3(0.f);
+#endif
+		if (hit){
 			outDebugResult = vec4(0.0, 1.0, 0.0, 1.0);
 		}
 		else {
@@ -0,0 +1,17 @@
+// Tiles of 8x8 trace texels holding at least one glossy surface, listed by ssr_classify.comp.
+// The header is the VkDispatchIndirectCommand of the trace and temporal passes, one workgroup per listed tile.
+
+const uint tileSize = 8; // workgroup size of the reduced resolution passes
+
+layout(std430, set = 1, binding = 8) buffer GlossyTiles {
+	uint dispatchX;
+	uint dispatchY;
+	uint dispatchZ;
+	uint glossyTiles[]; // x | y << 16
+};
+
+// Trace texel of the invocation, the workgroup being a listed tile
+ivec2 glossyTileTexel() {
+	uint tile = glossyTiles[gl_WorkGroupID.x];
+	return ivec2(tile & 0xFFFFu, tile >> 16) * int(tileSize) + ivec2(gl_LocalInvocationID.xy);
+}
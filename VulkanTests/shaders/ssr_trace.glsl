@@ -0,0 +1,144 @@
+// Screen space reflection trace shared by the fullscreen reflection shader and the reduced resolution compute trace.
+// The including shader declares the global UBO and the lightingOutputTexture, depthTexture and depthPyramid samplers.
+
+const float maxReflectiveRoughness = 0.1; //Only smoother surfaces trace rays
+const int iterationCount = 100; //Max iterations per ray
+const float rayStep = 0.2f;
+const float distanceBias = 0.05f; //distance at which a ray validates a hit
+const int hiZIterationCount = 64; //Max pyramid texels visited per ray
+const float maxRayDistance = iterationCount * rayStep; //Farthest the linear march can get, both traces search the same segment
+
+//view space position to screen space to UV coordinates
+vec2 projectedPosition(vec3 pos){
+	vec4 samplePosition = ubo.projection * vec4(pos, 1.f);
+	samplePosition.xy = (samplePosition.xy / samplePosition.w) * 0.5 + 0.5;
+	return samplePosition.xy;
+}
+
+//view space position from UV coordinates and depth. Reconstructing the view position.
+vec3 positionFromDepth(vec2 texturePos, float depth) {
+	vec4 ndc = vec4((texturePos - 0.5) * 2, depth, 1.f); //converting UVs to screen space coordinates
+	vec4 inversed = ubo.inverseProjection * ndc;// going back to view space
+	inversed /= inversed.w; //normalization
+	return inversed.xyz;
+}
+
+// Inverse of the G-buffer octahedral encoding
+vec3 octahedralDecode(vec2 encoded) {
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (n.z < 0.0) {
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return normalize(n);
+}
+
+#ifdef LINEAR_MARCH
+// Reference trace, fixed view space steps refined around the depth crossing
+vec3 SSR(vec3 position, vec3 reflection)
+{
+	vec3 step = rayStep * reflection;
+	vec3 marchingPosition = position + step; //view space position between incremented to build the ray
+	float delta;
+	float screenPosDepth;
+	vec2 screenPosition;
+
+	int i = 0;
+	for(; i < iterationCount; i++)
+	{
+		screenPosition = projectedPosition(marchingPosition);
+		screenPosDepth = abs(positionFromDepth(screenPosition,  texture(depthTexture, screenPosition).r).z);
+		delta = abs(marchingPosition.z) - screenPosDepth;
+		if (abs(delta) < distanceBias) {
+			vec3 color = vec3(1);
+			return texture(lightingOutputTexture, screenPosition).xyz;
+		}
+		else {
+			//Adapts step length
+			float directionSign = sign(abs(marchingPosition.z) - screenPosDepth);
+			step = step * (1.0 - rayStep * max(directionSign, 0.0));
+			marchingPosition += step * (-directionSign);
+
+			// marchingPosition += step;
+			// step *= 1.05;
+		}
+	}
+	return vec3(0.0);
+}
+#else
+//view space position to UV coordinates and depth. Depth is linear along a screen space segment, unlike view space depth
+vec3 screenPosition(vec3 pos) {
+	vec4 samplePosition = ubo.projection * vec4(pos, 1.f);
+	return vec3((samplePosition.xy / samplePosition.w) * 0.5 + 0.5, samplePosition.z / samplePosition.w);
+}
+
+// Ray parameter at which the ray leaves the texel of the given level containing it, a fraction of a texel past the boundary
+float cellExit(vec3 origin, vec3 direction, vec2 directionSign, vec2 point, vec2 levelSize) {
+	vec2 cell = floor(point * levelSize);
+	vec2 boundary = (cell + max(directionSign, 0.0) + directionSign * 0.01) / levelSize;
+	// A ray without motion along an axis never crosses the boundaries of that axis
+	vec2 safeDirection = directionSign * max(abs(direction.xy), vec2(1e-7));
+	vec2 t = (boundary - origin.xy) / safeDirection;
+	return min(t.x, t.y);
+}
+
+// Hierarchical trace in screen space over the closest depth pyramid. A ray in front of the closest depth of a texel cannot hit
+// anything under it, so it skips the whole texel and climbs a level. Otherwise it descends until it reaches the depth buffer itself.
+// The first crossing is validated with the same distance test as the linear march
+vec3 SSR(vec3 position, vec3 reflection)
+{
+	//The segment stops at the near plane, w of the projection is the distance in front of the camera
+	float rayLength = maxRayDistance;
+	float startW = (ubo.projection * vec4(position, 1.0)).w;
+	float directionW = (ubo.projection * vec4(reflection, 0.0)).w;
+	if (startW + directionW * rayLength < ubo.nearPlane) {
+		rayLength = (ubo.nearPlane - startW) / directionW;
+	}
+
+	vec3 origin = screenPosition(position);
+	vec3 direction = screenPosition(position + reflection * rayLength) - origin; //t in [0, 1] covers the segment
+	vec2 directionSign = vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+	int maxLevel = textureQueryLevels(depthPyramid) - 1;
+
+	//Starts outside of the pixel being shaded
+	int level = 0;
+	float t = cellExit(origin, direction, directionSign, origin.xy, vec2(textureSize(depthPyramid, 0)));
+
+	for (int i = 0; i < hiZIterationCount; i++)
+	{
+		vec3 ray = origin + direction * t;
+		if (t > 1.0 || any(lessThan(ray.xy, vec2(0.0))) || any(greaterThan(ray.xy, vec2(1.0)))) {
+			break;
+		}
+
+		vec2 levelSize = vec2(textureSize(depthPyramid, level));
+		float closestDepth = texelFetch(depthPyramid, ivec2(floor(ray.xy * levelSize)), level).r;
+		float exitT = cellExit(origin, direction, directionSign, ray.xy, levelSize);
+
+		if (ray.z < closestDepth) {
+			//In front of the texel, the ray can go as far as the closest depth or the texel boundary
+			float surfaceT = direction.z > 0.0 ? (closestDepth - origin.z) / direction.z : exitT;
+			if (surfaceT >= exitT) {
+				t = exitT;
+				level = min(level + 1, maxLevel);
+				continue;
+			}
+			t = max(surfaceT, t);
+			ray = origin + direction * t;
+		}
+		if (level > 0) {
+			level--;
+			continue;
+		}
+
+		//Depth buffer crossed at this pixel, only a continuous surface is a hit (not the edge of an object in front of the ray)
+		float rayDepth = abs(positionFromDepth(ray.xy, ray.z).z);
+		float screenPosDepth = abs(positionFromDepth(ray.xy, texture(depthTexture, ray.xy).r).z);
+		if (abs(rayDepth - screenPosDepth) < distanceBias) {
+			return texture(lightingOutputTexture, ray.xy).xyz;
+		}
+		return vec3(0.0);
+	}
+	return vec3(0.0);
+}
+#endif
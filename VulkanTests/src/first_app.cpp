@@ -4,7 +4,18 @@
 
 #include "keyboard_movement_controller.hpp"
 #include "vt_buffer.hpp"
+#include "vt_bvh.hpp"
 #include "vt_camera.hpp"
+#include "vt_frame_ring_buffer.hpp"
+#include "vt_frustum_culler.hpp"
+#include "vt_gpu_timer.hpp"
+#include "vt_light_buffer.hpp"
+#include "vt_render_queue.hpp"
+#include "vt_scene_bvh.hpp"
+#include "vt_secondary_command_recorder.hpp"
+#include "vt_thread_pool.hpp"
+#include "systems/light_cluster_system.hpp"
+#include "systems/occlusion_culling_system.hpp"
 #include "systems/point_light_system.hpp"
 #include "systems/simple_render_system.hpp"
 
@@ -15,20 +26,82 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
 #include <stdexcept>
 
 //#define RENDER_INDICATORS
+//#define RUN_CULLING_BENCHMARK
+//#define RUN_BVH_BENCHMARK
+#define OCCLUSION_CULLING
+//#define PRINT_RENDER_QUEUE_STATS
+//#define DEPTH_PREPASS
+//#define PRINT_GBUFFER_TIMINGS
+#define PARALLEL_GBUFFER_RECORDING
+//#define PRINT_MEMORY_STATS
+#define RENDER_GRAPH
+//#define PRINT_FRAME_TIMINGS
+//#define GBUFFER_LIGHTING_SUBPASSES
+
+#if defined(RENDER_GRAPH) && defined(PRINT_GBUFFER_TIMINGS)
+#error "PRINT_GBUFFER_TIMINGS times the fixed pass chain, use PRINT_FRAME_TIMINGS to time the render graph"
+#endif
+#if defined(GBUFFER_LIGHTING_SUBPASSES) && !defined(RENDER_GRAPH)
+#error "GBUFFER_LIGHTING_SUBPASSES needs the render graph to declare the input attachments and transient G-buffer images"
+#endif
 
 namespace vt
 {
-	FirstApp::FirstApp()
+	namespace
+	{
+		//In the order of the benchmark, from the most latency to the least
+		std::vector<VkPresentModeKHR> getSupportedPresentModes(VtDevice& device)
+		{
+			std::vector<VkPresentModeKHR> availableModes = device.getSwapChainSupport().presentModes;
+			std::vector<VkPresentModeKHR> modes;
+			for (VkPresentModeKHR mode : { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR })
+			{
+				if (std::find(availableModes.begin(), availableModes.end(), mode) != availableModes.end())
+				{
+					modes.push_back(mode);
+				}
+			}
+			return modes;
+		}
+
+		//Ray from the camera through the cursor, the window and the projection both have y pointing down
+		VtRay getCursorRay(GLFWwindow* window, const VtCamera& camera)
+		{
+			double cursorX, cursorY;
+			glfwGetCursorPos(window, &cursorX, &cursorY);
+			int width, height;
+			glfwGetWindowSize(window, &width, &height);
+			glm::vec2 ndc{
+				2.f * static_cast<float>(cursorX) / static_cast<float>(std::max(width, 1)) - 1.f,
+				2.f * static_cast<float>(cursorY) / static_cast<float>(std::max(height, 1)) - 1.f };
+
+			//Any depth inside the frustum is in front of the camera, whatever the depth convention
+			glm::vec4 viewPoint = camera.getInverseProjection() * glm::vec4(ndc, 0.5f, 1.f);
+			glm::vec3 worldPoint = glm::vec3(camera.getInverseView() * glm::vec4(glm::vec3(viewPoint) / viewPoint.w, 1.f));
+
+			VtRay ray{};
+			ray.origin = glm::vec3(camera.getInverseView()[3]);
+			ray.direction = glm::normalize(worldPoint - ray.origin);
+			return ray;
+		}
+	}
+
+	FirstApp::FirstApp(const Settings& settings) : settings{ settings }
 	{
 		globalPool = VtDescriptorPool::Builder(vtDevice)
 			.setMaxSets(1000)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VtSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, vtDevice.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * vtDevice.getFramesInFlight())
 			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000)
 			.build();
 		loadGameObjects();
@@ -38,7 +111,14 @@ namespace vt
 
 	void FirstApp::run()
 	{
-		std::vector<std::unique_ptr<VtBuffer>> uboBuffers(VtSwapChain::MAX_FRAMES_IN_FLIGHT);
+#ifdef RUN_CULLING_BENCHMARK
+		VtFrustumCuller::runBenchmark();
+#endif
+#ifdef RUN_BVH_BENCHMARK
+		VtBvh::runBenchmark();
+#endif
+
+		std::vector<std::unique_ptr<VtBuffer>> uboBuffers(vtDevice.getFramesInFlight());
 		for (int i = 0; i < uboBuffers.size(); i++)
 		{
 			uboBuffers[i] = std::make_unique<VtBuffer>(
@@ -51,11 +131,21 @@ namespace vt
 			uboBuffers[i]->map();
 		}
 
+		//Per frame object data, each global descriptor set sees the partition of its frame
+		VtFrameRingBuffer frameRingBuffer{ vtDevice, sizeof(ObjectData) * MAX_OBJECTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+
 		auto globalSetLayout = VtDescriptorSetLayout::Builder(vtDevice)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
 			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
 			.build();
 
+		//Point lights are binned into view space clusters, the lighting pass only evaluates the list of its pixel's cluster
+		VtLightBuffer lightBuffer{ vtDevice };
+		LightClusterSystem lightClusterSystem{ vtDevice, globalSetLayout->getDescriptorSetLayout() };
+
 		auto pbrMaterialSetLayout =
 			VtDescriptorSetLayout::Builder(vtDevice)
 			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
@@ -69,16 +159,45 @@ namespace vt
 		std::vector<VkDescriptorSetLayout> layouts = { globalSetLayout->getDescriptorSetLayout(), pbrMaterialSetLayout->getDescriptorSetLayout()};
 
 		//Initializing render passes
-		gBufferPass = std::make_shared<GBufferPass>(vtDevice, vtRenderer.getSwapchain(), layouts);
-		lightingPass = std::make_shared<LightingPass>(vtDevice, vtRenderer.getSwapchain(), layouts, gBufferPass);
-		reflectionPass = std::make_shared<ReflectionPass>(vtDevice, vtRenderer.getSwapchain(), layouts, gBufferPass, lightingPass);
+#ifdef DEPTH_PREPASS
+		bool depthPrepass = true;
+#else
+		bool depthPrepass = false;
+#endif
+#ifdef GBUFFER_LIGHTING_SUBPASSES
+		bool lightingSubpass = true;
+#else
+		bool lightingSubpass = false;
+#endif
+#ifdef RENDER_GRAPH
+		//The passes only declare their targets, the graph creates them when compiled below
+		renderGraph = std::make_unique<VtRenderGraph>(vtDevice, vtRenderer.getSwapchain());
+		gBufferPass = std::make_shared<GBufferPass>(vtDevice, vtRenderer.getSwapchain(), *renderGraph, layouts, depthPrepass, lightingSubpass);
+		lightingPass = std::make_shared<LightingPass>(vtDevice, vtRenderer.getSwapchain(), *renderGraph, layouts, gBufferPass);
+		//Outside of the graph like the occlusion pyramids, it only tracks attachments and sampled images
+		ssrDepthPyramid = std::make_shared<SsrDepthPyramidSystem>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, gBufferPass);
+		ssrTrace = std::make_shared<SsrTraceSystem>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, globalSetLayout->getDescriptorSetLayout(), gBufferPass, lightingPass, ssrDepthPyramid);
+		reflectionPass = std::make_shared<ReflectionPass>(vtDevice, vtRenderer.getSwapchain(), *renderGraph, layouts, gBufferPass, lightingPass, ssrDepthPyramid, ssrTrace);
+#else
+		gBufferPass = std::make_shared<GBufferPass>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, layouts, depthPrepass);
+		lightingPass = std::make_shared<LightingPass>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, layouts, gBufferPass);
+		ssrDepthPyramid = std::make_shared<SsrDepthPyramidSystem>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, gBufferPass);
+		ssrTrace = std::make_shared<SsrTraceSystem>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, globalSetLayout->getDescriptorSetLayout(), gBufferPass, lightingPass, ssrDepthPyramid);
+		reflectionPass = std::make_shared<ReflectionPass>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, layouts, gBufferPass, lightingPass, ssrDepthPyramid, ssrTrace);
+#endif
 
-		std::vector<VkDescriptorSet> globalDescriptorSets(VtSwapChain::MAX_FRAMES_IN_FLIGHT);
+		std::vector<VkDescriptorSet> globalDescriptorSets(vtDevice.getFramesInFlight());
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
 		{
 			auto bufferInfo = uboBuffers[i]->getDescriptorInfo();
+			auto objectBufferInfo = frameRingBuffer.getDescriptorInfo(i);
+			auto lightBufferInfo = lightBuffer.getDescriptorInfo(i);
+			auto clusterBufferInfo = lightClusterSystem.getClusterBufferInfo(i);
 			VtDescriptorWriter(*globalSetLayout, *globalPool)
 				.writeBuffer(0, &bufferInfo)
+				.writeBuffer(2, &objectBufferInfo)
+				.writeBuffer(3, &lightBufferInfo)
+				.writeBuffer(4, &clusterBufferInfo)
 				.build(globalDescriptorSets[i]);
 
 		}
@@ -88,6 +207,7 @@ namespace vt
 			gBufferPass->getRenderPass(), // Workaround to make the light position indicator appear. A better way would be to add another render pass and write indicators on top of the final image.
 			globalSetLayout->getDescriptorSetLayout()
 		};
+		pointLightSystem.addLights(gameObjects, lightBuffer);
 
 		std::shared_ptr<VtModel> lveModel = std::make_shared<VtModel>(vtDevice, "models/Sponza/Sponza.gltf", *pbrMaterialSetLayout, *globalPool);
 		auto floor = VtGameObject::createGameObject();
@@ -97,6 +217,11 @@ namespace vt
 		floor.transform.rotation = { 0.0f, 0.0f, 0.0f };// 3.14159265f};
 		gameObjects.emplace(floor.getId(), std::move(floor));
 
+		//Every primitive and light of the scene, refit each frame once the lights have moved. Used for picking
+		VtSceneBvh sceneBvh{};
+		sceneBvh.build(gameObjects);
+		std::vector<uint32_t> pickOverlaps;
+
         VtCamera camera{};
 
         //camera.setViewTarget(glm::vec3(-1.f, -2.f, -2.f), glm::vec3(0.f, 0.f, 2.5f));
@@ -106,6 +231,290 @@ namespace vt
 		viewerObject.transform.translation.z = -2.5f;
         KeyboardMovementController cameraController{};
 
+		// One entry per model primitive, in the same order as the boxes given to the culler
+		struct PrimitiveDraw
+		{
+			VtGameObject* gameObject;
+			uint32_t primitiveIndex;
+			uint32_t objectIndex; // ObjectData slot of the game object this frame
+		};
+		std::vector<PrimitiveDraw> primitiveDraws;
+		std::vector<VtAabb> primitiveBounds; // world space
+		std::vector<uint32_t> visiblePrimitives;
+		VtFrustumCuller frustumCuller{};
+
+#ifdef OCCLUSION_CULLING
+		uint32_t primitiveCount = 0;
+		for (auto& kv : gameObjects)
+		{
+			if (kv.second.model != nullptr)
+			{
+				primitiveCount += static_cast<uint32_t>(kv.second.model->getPrimitives().size());
+			}
+		}
+		//Created once the G-buffer depth exists, after the render graph is compiled
+		std::unique_ptr<OcclusionCullingSystem> occlusionCullingSystem;
+		std::vector<OcclusionDrawRecord> occlusionRecords;
+#endif
+		glm::mat4 viewProjection{ 1.f }; //Of the frame being recorded, the reflection history is reprojected with it
+
+		VtRenderQueue renderQueue{};
+		VtRenderQueue depthPrepassQueue{};
+#ifdef PRINT_RENDER_QUEUE_STATS
+		float statsTimer = 0.f;
+#endif
+
+#ifdef PARALLEL_GBUFFER_RECORDING
+		//Depth pre-pass and G-buffer draws are recorded into secondary command buffers on every core
+		VtThreadPool recordingThreadPool{};
+		VtSecondaryCommandRecorder secondaryRecorder{ vtDevice, recordingThreadPool };
+		gBufferPass->setSecondaryCommandBuffers(true);
+		std::vector<VkCommandBuffer> indicatorCommandBuffers;
+#endif
+
+#ifdef PRINT_GBUFFER_TIMINGS
+		//Timestamps around the depth pre-pass, the occlusion culling and the G-buffer pass
+		VtGpuTimer gpuTimer{ vtDevice, 2 };
+		float timingsTimer = 0.f;
+		float gBufferMilliseconds = 0.f;
+		float recordMilliseconds = 0.f;
+		uint32_t timedFrames = 0;
+		uint32_t recordedFrames = 0;
+#endif
+
+#ifdef PRINT_FRAME_TIMINGS
+		//Timestamps around the whole pass chain, to compare the render graph with the fixed chain
+#ifdef RENDER_GRAPH
+		const char* passChainName = "Render graph: ";
+#else
+		const char* passChainName = "Fixed pass chain: ";
+#endif
+		VtGpuTimer frameTimer{ vtDevice, 2 };
+		float frameTimingsTimer = 0.f;
+		float passChainMilliseconds = 0.f;
+		float passChainRecordMilliseconds = 0.f;
+		uint32_t passChainTimedFrames = 0;
+		uint32_t passChainRecordedFrames = 0;
+#endif
+
+#ifdef OCCLUSION_CULLING
+		std::function<VkDeviceSize(uint32_t)> earlyDrawOffset = [&](uint32_t drawIndex) { return occlusionCullingSystem->getDrawCommandOffset(OcclusionCullingSystem::Phase::Early, drawIndex); };
+		std::function<VkDeviceSize(uint32_t)> lateDrawOffset = [&](uint32_t drawIndex) { return occlusionCullingSystem->getDrawCommandOffset(OcclusionCullingSystem::Phase::Late, drawIndex); };
+#else
+		std::function<VkDeviceSize(uint32_t)> earlyDrawOffset{};
+#endif
+
+		//Draws a queue in the current G-buffer or pre-pass render pass
+		auto submitQueue = [&](VtRenderQueue& queue, VkCommandBuffer commandBuffer, int frameIndex, const VtSecondaryInheritance& inheritance, const std::function<VkDeviceSize(uint32_t)>& drawOffset)
+		{
+#ifdef OCCLUSION_CULLING
+			VkBuffer drawCommandBuffer = occlusionCullingSystem->getDrawCommandBuffer(frameIndex);
+#else
+			VkBuffer drawCommandBuffer = VK_NULL_HANDLE;
+#endif
+#ifdef PARALLEL_GBUFFER_RECORDING
+			queue.submitParallel(commandBuffer, secondaryRecorder, frameIndex, inheritance, globalDescriptorSets[frameIndex], drawCommandBuffer, drawOffset);
+#else
+			queue.submit(commandBuffer, globalDescriptorSets[frameIndex], drawCommandBuffer, drawOffset);
+#endif
+		};
+
+#ifdef RENDER_INDICATORS
+		//Light position indicators, drawn at the end of the G-buffer pass
+		auto renderIndicators = [&](FrameInfo& frameInfo, const VtSecondaryInheritance& inheritance)
+		{
+#ifdef PARALLEL_GBUFFER_RECORDING
+			//The pass only accepts secondary command buffers
+			secondaryRecorder.record(frameInfo.frameIndex, inheritance, 1,
+				[&](VkCommandBuffer secondaryCommandBuffer, uint32_t)
+				{
+					FrameInfo indicatorFrameInfo = frameInfo;
+					indicatorFrameInfo.commandBuffer = secondaryCommandBuffer;
+					pointLightSystem.render(indicatorFrameInfo);
+				},
+				indicatorCommandBuffers);
+			vkCmdExecuteCommands(frameInfo.commandBuffer, 1, indicatorCommandBuffers.data());
+#else
+			pointLightSystem.render(frameInfo);
+#endif
+		};
+#endif
+
+#ifdef RENDER_GRAPH
+		//Frame passes declared once in execution order, the graph derives barriers, render passes and transient memory from them
+		auto drawGBufferQueue = [&](const VtRenderGraph::PassContext& context, VtRenderQueue& queue, const std::function<VkDeviceSize(uint32_t)>& drawOffset)
+		{
+			submitQueue(queue, context.commandBuffer, context.frameIndex, { context.renderPass, context.subpass, context.framebuffer, context.extent }, drawOffset);
+		};
+		//Last draws of the G-buffer pass
+		auto drawGBufferEnd = [&](const VtRenderGraph::PassContext& context, const std::function<VkDeviceSize(uint32_t)>& drawOffset)
+		{
+			drawGBufferQueue(context, renderQueue, drawOffset);
+#ifdef RENDER_INDICATORS
+			FrameInfo indicatorFrameInfo{ context.frameIndex, context.imageIndex, 0.f, context.commandBuffer, camera, globalDescriptorSets[context.frameIndex], gameObjects };
+			renderIndicators(indicatorFrameInfo, { context.renderPass, context.subpass, context.framebuffer, context.extent });
+#endif
+		};
+		auto drawLighting = [&](const VtRenderGraph::PassContext& context)
+		{
+			lightingPass->draw(context.commandBuffer, context.frameIndex, globalDescriptorSets[context.frameIndex], lightBuffer, camera);
+		};
+		//Pass completing the G-buffer. With GBUFFER_LIGHTING_SUBPASSES the lighting is its second subpass and reads the G-buffer from tile memory
+		auto addLastGBufferPass = [&](const std::string& name, VtGraphLoad load, VtRenderGraph::ExecuteCallback drawGBuffer)
+		{
+			renderGraph->addGraphicsPass(name,
+				[&](VtRenderGraph::PassBuilder& builder)
+				{
+					gBufferPass->declareGBufferWrites(builder, load);
+					if (lightingPass->isGBufferSubpass()) lightingPass->declareGraphPass(builder);
+				},
+				[&, drawGBuffer](const VtRenderGraph::PassContext& context)
+				{
+					if (context.subpass == 0) drawGBuffer(context);
+					else drawLighting(context);
+				});
+		};
+#ifdef OCCLUSION_CULLING
+		//Second phase of the occlusion culling, on the depth of the first one. The draw commands it writes are synchronized by the system
+		auto addOcclusionCullingPass = [&]()
+		{
+			renderGraph->addComputePass("Occlusion culling",
+				[&](VtRenderGraph::PassBuilder& builder)
+				{
+					gBufferPass->declareDepthRead(builder, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+					builder.setSideEffect();
+				},
+				[&](const VtRenderGraph::PassContext& context)
+				{
+					occlusionCullingSystem->buildDepthPyramid(context.commandBuffer, context.frameIndex);
+					occlusionCullingSystem->cullLate(context.commandBuffer, context.frameIndex, viewProjection);
+				});
+		};
+#endif
+
+		//Only the lighting reads the cluster lists, their barrier is recorded by the system. Light volumes do not need them
+		renderGraph->addComputePass("Light culling",
+			[&](VtRenderGraph::PassBuilder& builder) { builder.setSideEffect(); },
+			[&](const VtRenderGraph::PassContext& context)
+			{
+				if (!lightingPass->usesLightVolumes()) lightClusterSystem.cullLights(context.commandBuffer, context.frameIndex, globalDescriptorSets[context.frameIndex]);
+			});
+
+		if (gBufferPass->hasDepthPrepass())
+		{
+			//Depth only first, the occlusion phases run on the pre-pass so the G-buffer pass draws everything at once
+			renderGraph->addGraphicsPass("Depth pre-pass",
+				[&](VtRenderGraph::PassBuilder& builder) { gBufferPass->declareDepthPrepassWrites(builder, VtGraphLoad::Clear); },
+				[&](const VtRenderGraph::PassContext& context) { drawGBufferQueue(context, depthPrepassQueue, earlyDrawOffset); });
+#ifdef OCCLUSION_CULLING
+			addOcclusionCullingPass();
+			renderGraph->addGraphicsPass("Depth pre-pass late",
+				[&](VtRenderGraph::PassBuilder& builder) { gBufferPass->declareDepthPrepassWrites(builder, VtGraphLoad::Load); },
+				[&](const VtRenderGraph::PassContext& context) { drawGBufferQueue(context, depthPrepassQueue, lateDrawOffset); });
+#endif
+			addLastGBufferPass("G-buffer", VtGraphLoad::Clear,
+				[&](const VtRenderGraph::PassContext& context)
+				{
+#ifdef OCCLUSION_CULLING
+					drawGBufferQueue(context, renderQueue, earlyDrawOffset);
+					drawGBufferEnd(context, lateDrawOffset);
+#else
+					drawGBufferEnd(context, earlyDrawOffset);
+#endif
+				});
+		}
+		else
+		{
+#ifdef OCCLUSION_CULLING
+			renderGraph->addGraphicsPass("G-buffer early",
+				[&](VtRenderGraph::PassBuilder& builder) { gBufferPass->declareGBufferWrites(builder, VtGraphLoad::Clear); },
+				[&](const VtRenderGraph::PassContext& context) { drawGBufferQueue(context, renderQueue, earlyDrawOffset); });
+			addOcclusionCullingPass();
+			//The early half stores the G-buffer, so with the lighting subpass only the late half reads it in place
+			addLastGBufferPass("G-buffer late", VtGraphLoad::Load,
+				[&](const VtRenderGraph::PassContext& context) { drawGBufferEnd(context, lateDrawOffset); });
+#else
+			addLastGBufferPass("G-buffer", VtGraphLoad::Clear,
+				[&](const VtRenderGraph::PassContext& context) { drawGBufferEnd(context, earlyDrawOffset); });
+#endif
+		}
+
+		//Closest depth pyramid of the reflections, the system records its barrier toward the reflection pass
+		renderGraph->addComputePass("SSR depth pyramid",
+			[&](VtRenderGraph::PassBuilder& builder)
+			{
+				gBufferPass->declareDepthRead(builder, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+				builder.setSideEffect();
+			},
+			[&](const VtRenderGraph::PassContext& context) { ssrDepthPyramid->buildPyramid(context.commandBuffer, context.frameIndex); });
+
+		if (!lightingPass->isGBufferSubpass())
+		{
+			renderGraph->addGraphicsPass("Lighting",
+				[&](VtRenderGraph::PassBuilder& builder) { lightingPass->declareGraphPass(builder); },
+				drawLighting);
+		}
+
+		//Reduced resolution reflections and their history, the system records its barrier toward the reflection pass
+		renderGraph->addComputePass("SSR trace",
+			[&](VtRenderGraph::PassBuilder& builder)
+			{
+				builder.sample(lightingPass->getLightingResource(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+				gBufferPass->declareScreenSpaceReads(builder, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+				builder.setSideEffect();
+			},
+			[&](const VtRenderGraph::PassContext& context)
+			{
+				ssrTrace->trace(context.commandBuffer, context.frameIndex, globalDescriptorSets[context.frameIndex], viewProjection);
+			});
+
+		renderGraph->addGraphicsPass("Reflection",
+			[&](VtRenderGraph::PassBuilder& builder) { reflectionPass->declareGraphPass(builder); },
+			[&](const VtRenderGraph::PassContext& context)
+			{
+				reflectionPass->draw(context.commandBuffer, context.frameIndex, globalDescriptorSets[context.frameIndex]);
+			});
+
+		renderGraph->compile();
+		//The texture descriptors need the views created by the compilation
+		ssrDepthPyramid->createPipelineRessources();
+		lightingPass->createPipelineRessources();
+		ssrTrace->createPipelineRessources();
+		reflectionPass->createPipelineRessources();
+#if defined(PRINT_FRAME_TIMINGS) || defined(PRINT_MEMORY_STATS)
+		renderGraph->printStats(std::cout);
+#endif
+#ifdef PRINT_FRAME_TIMINGS
+		renderGraph->enablePassTimings();
+#endif
+#endif
+
+#ifdef OCCLUSION_CULLING
+		occlusionCullingSystem = std::make_unique<OcclusionCullingSystem>(vtDevice, vtRenderer.getSwapchain(), attachmentPool, gBufferPass, primitiveCount);
+#endif
+
+#ifdef PRINT_MEMORY_STATS
+		vtDevice.getMemoryAllocator().printStats(std::cout);
+		attachmentPool.printStats(std::cout);
+#endif
+		vtDevice.getMemoryAllocator().warnIfNearBudget(std::cout);
+		//The startup pipelines compile in the background, their stats are printed once the compiler is idle
+		bool pipelineStatsPrinted = false;
+		float memoryReportTimer = 0.f;
+		bool lightVolumeKeyWasDown = false;
+		bool hierarchicalTraceKeyWasDown = false;
+		bool reflectionResolutionKeyWasDown = false;
+		bool presentModeKeyWasDown = false;
+		bool pickKeyWasDown = false;
+		const std::vector<VkPresentModeKHR> presentModes = getSupportedPresentModes(vtDevice);
+		size_t benchmarkModeIndex = 0;
+		float benchmarkTimer = 0.f;
+		bool benchmarkMeasuring = false;
+		if (settings.framePacingBenchmark)
+		{
+			vtRenderer.setPresentMode(presentModes[benchmarkModeIndex]);
+		}
+
         auto currentTime = std::chrono::high_resolution_clock::now();
 
 		while (!vtWindow.shouldClose())
@@ -116,16 +525,176 @@ namespace vt
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
+			//Budgets move with other applications too, not only with our allocations
+			memoryReportTimer += frameTime;
+			if (memoryReportTimer >= MEMORY_REPORT_INTERVAL)
+			{
+				memoryReportTimer = 0.f;
+#ifdef PRINT_MEMORY_STATS
+				vtDevice.getMemoryAllocator().printStats(std::cout);
+#endif
+				vtDevice.getMemoryAllocator().warnIfNearBudget(std::cout);
+			}
+
+			if (!pipelineStatsPrinted && vtDevice.getPipelineCompiler().isIdle())
+			{
+				//A warm start only pays for the cache lookups
+				vtDevice.getPipelineCache().printStats(std::cout);
+				pipelineStatsPrinted = true;
+			}
+
             cameraController.moveInPlaneXZ(vtWindow.getGLFWwindow(), frameTime, viewerObject);
+
+			//Clustered shading and light volumes can be compared live, with PRINT_FRAME_TIMINGS for the cost of the "Lighting" pass
+			bool lightVolumeKeyDown = glfwGetKey(vtWindow.getGLFWwindow(), cameraController.keys.toggleLightVolumes) == GLFW_PRESS;
+			if (lightVolumeKeyDown && !lightVolumeKeyWasDown)
+			{
+				lightingPass->setLightVolumes(!lightingPass->requestsLightVolumes());
+				std::cout << "Lighting: " << (lightingPass->requestsLightVolumes() ? "light volumes" : "clustered") << std::endl;
+			}
+			lightVolumeKeyWasDown = lightVolumeKeyDown;
+
+			//Same comparison for the reflections, outDebugResult shows the hits of the active trace
+			bool hierarchicalTraceKeyDown = glfwGetKey(vtWindow.getGLFWwindow(), cameraController.keys.toggleHierarchicalTrace) == GLFW_PRESS;
+			if (hierarchicalTraceKeyDown && !hierarchicalTraceKeyWasDown)
+			{
+				reflectionPass->setHierarchicalTrace(!reflectionPass->usesHierarchicalTrace());
+				std::cout << "Reflections: " << (reflectionPass->usesHierarchicalTrace() ? "Hi-Z trace" : "linear march") << std::endl;
+			}
+			hierarchicalTraceKeyWasDown = hierarchicalTraceKeyDown;
+
+			//Full, half then quarter resolution reflections, the "SSR trace" and "Reflection" passes share the cost below full resolution
+			bool reflectionResolutionKeyDown = glfwGetKey(vtWindow.getGLFWwindow(), cameraController.keys.cycleReflectionResolution) == GLFW_PRESS;
+			if (reflectionResolutionKeyDown && !reflectionResolutionKeyWasDown)
+			{
+				SsrResolution resolution = ssrTrace->getResolution() == SsrResolution::Full ? SsrResolution::Half
+					: ssrTrace->getResolution() == SsrResolution::Half ? SsrResolution::Quarter : SsrResolution::Full;
+				ssrTrace->setResolution(resolution);
+				std::cout << "Reflections: 1/" << ssrTrace->getTraceScale() << " resolution" << std::endl;
+			}
+			reflectionResolutionKeyWasDown = reflectionResolutionKeyDown;
+
+			//The swapchain is recreated at the end of the frame, with PRINT_FRAME_TIMINGS or the benchmark for the effect on the frame rate
+			bool presentModeKeyDown = glfwGetKey(vtWindow.getGLFWwindow(), cameraController.keys.cyclePresentMode) == GLFW_PRESS;
+			if (presentModeKeyDown && !presentModeKeyWasDown && !settings.framePacingBenchmark)
+			{
+				auto current = std::find(presentModes.begin(), presentModes.end(), vtRenderer.getPresentMode());
+				size_t next = current == presentModes.end() ? 0 : (current - presentModes.begin() + 1) % presentModes.size();
+				vtRenderer.setPresentMode(presentModes[next]);
+			}
+			presentModeKeyWasDown = presentModeKeyDown;
+
+			//Each present mode is measured once the queue of frames has settled (and the startup pipelines are compiled)
+			if (settings.framePacingBenchmark)
+			{
+				benchmarkTimer += frameTime;
+				if (!benchmarkMeasuring && benchmarkTimer >= PACING_WARMUP_SECONDS && vtDevice.getPipelineCompiler().isIdle())
+				{
+					vtRenderer.resetFramePacingStats();
+					benchmarkMeasuring = true;
+					benchmarkTimer = 0.f;
+				}
+				else if (benchmarkMeasuring && benchmarkTimer >= PACING_MEASURE_SECONDS)
+				{
+					framePacingResults.push_back({ vtDevice.getFramesInFlight(), vtRenderer.getPresentMode(), vtRenderer.getFramePacingStats() });
+					if (++benchmarkModeIndex == presentModes.size())
+					{
+						break;
+					}
+					vtRenderer.setPresentMode(presentModes[benchmarkModeIndex]);
+					benchmarkMeasuring = false;
+					benchmarkTimer = 0.f;
+				}
+			}
 			camera.setView(viewerObject.transform.mat4());
 
             float aspect = vtRenderer.getAspectRatio();
-            camera.setPerspectiveProjection(glm::radians(50.f), WIDTH, HEIGHT, 0.1f, 1000.f);
+            camera.setPerspectiveProjection(glm::radians(50.f), WIDTH, HEIGHT, NEAR_PLANE, FAR_PLANE);
+
+			//Closest primitive or light under the cursor, for a light also how much of the scene its range reaches
+			bool pickKeyDown = glfwGetMouseButton(vtWindow.getGLFWwindow(), cameraController.keys.pickObject) == GLFW_PRESS;
+			if (pickKeyDown && !pickKeyWasDown)
+			{
+				VtSceneBvh::Hit hit = sceneBvh.raycast(getCursorRay(vtWindow.getGLFWwindow(), camera));
+				if (!hit.hit())
+				{
+					std::cout << "Picking: nothing under the cursor" << std::endl;
+				}
+				else if (hit.item.primitiveIndex != VtSceneBvh::NO_PRIMITIVE)
+				{
+					std::cout << "Picking: object " << hit.item.objectId << " primitive " << hit.item.primitiveIndex << " at " << hit.distance << std::endl;
+				}
+				else
+				{
+					VtGameObject& obj = *hit.item.gameObject;
+					std::cout << "Picking: object " << hit.item.objectId << " at " << hit.distance;
+					if (obj.pointLight != nullptr)
+					{
+						pickOverlaps.clear();
+						sceneBvh.querySphere({ obj.transform.translation, obj.pointLight->range }, pickOverlaps);
+						size_t primitiveCount = std::count_if(pickOverlaps.begin(), pickOverlaps.end(),
+							[&](uint32_t item) { return sceneBvh.getItem(item).primitiveIndex != VtSceneBvh::NO_PRIMITIVE; });
+						std::cout << ", point light reaching " << primitiveCount << " primitives";
+					}
+					std::cout << std::endl;
+				}
+			}
+			pickKeyWasDown = pickKeyDown;
 			
 			if (auto commandBuffer = vtRenderer.beginFrame())
 			{
 				int frameIndex = vtRenderer.getFrameIndex();
 				int imageIndex = vtRenderer.getImageIndex();
+
+#ifdef PRINT_GBUFFER_TIMINGS
+				float elapsed = gpuTimer.getElapsedMilliseconds(frameIndex, 0, 1);
+				if (elapsed >= 0.f)
+				{
+					gBufferMilliseconds += elapsed;
+					timedFrames++;
+				}
+				timingsTimer += frameTime;
+				if (timingsTimer > 1.f && timedFrames > 0)
+				{
+					std::cout << (gBufferPass->hasDepthPrepass() ? "Depth pre-pass + G-buffer: " : "G-buffer: ")
+						<< gBufferMilliseconds / timedFrames << " ms GPU | "
+						<< recordMilliseconds / recordedFrames << " ms CPU recording (average of " << timedFrames << " frames)" << std::endl;
+					timingsTimer = 0.f;
+					gBufferMilliseconds = 0.f;
+					recordMilliseconds = 0.f;
+					timedFrames = 0;
+					recordedFrames = 0;
+				}
+				gpuTimer.reset(commandBuffer, frameIndex);
+#endif
+#ifdef PRINT_FRAME_TIMINGS
+				float passChainElapsed = frameTimer.getElapsedMilliseconds(frameIndex, 0, 1);
+				if (passChainElapsed >= 0.f)
+				{
+					passChainMilliseconds += passChainElapsed;
+					passChainTimedFrames++;
+				}
+				frameTimingsTimer += frameTime;
+				if (frameTimingsTimer > 1.f && passChainTimedFrames > 0)
+				{
+					std::cout << passChainName
+						<< passChainMilliseconds / passChainTimedFrames << " ms GPU | "
+						<< passChainRecordMilliseconds / passChainRecordedFrames << " ms CPU recording (average of " << passChainTimedFrames << " frames)" << std::endl;
+#ifdef RENDER_GRAPH
+					renderGraph->printPassTimings(std::cout, frameIndex);
+#endif
+					frameTimingsTimer = 0.f;
+					passChainMilliseconds = 0.f;
+					passChainRecordMilliseconds = 0.f;
+					passChainTimedFrames = 0;
+					passChainRecordedFrames = 0;
+				}
+				frameTimer.reset(commandBuffer, frameIndex);
+#endif
+#ifdef PARALLEL_GBUFFER_RECORDING
+				secondaryRecorder.beginFrame(frameIndex);
+#endif
+
 				FrameInfo frameInfo{
 					frameIndex,
 					imageIndex,
@@ -142,69 +711,296 @@ namespace vt
 				ubo.view = camera.getView();
 				ubo.inverseView = camera.getInverseView();
 				ubo.inverseProjection = camera.getInverseProjection();
-				pointLightSystem.update(frameInfo, ubo);
+				ubo.nearPlane = NEAR_PLANE;
+				ubo.farPlane = FAR_PLANE;
+
+				//Only the lights that moved are uploaded, a grown light buffer is bound again
+				pointLightSystem.update(frameInfo, lightBuffer);
+				sceneBvh.update(gameObjects);
+				if (lightBuffer.upload(frameIndex))
+				{
+					auto lightBufferInfo = lightBuffer.getDescriptorInfo(frameIndex);
+					VtDescriptorWriter(*globalSetLayout, *globalPool)
+						.writeBuffer(3, &lightBufferInfo)
+						.overwrite(globalDescriptorSets[frameIndex]);
+				}
+				ubo.lightCount = lightBuffer.getLightCount();
+
 				uboBuffers[frameIndex]->writeToBuffer(&ubo);
 				uboBuffers[frameIndex]->flush();
 
-				// render
-				gBufferPass->startRenderPass(commandBuffer, imageIndex);
-				gBufferPass->bindDefaultPipeline(commandBuffer);
+				//Object transforms are written once per frame in bulk, draws read them through their first instance
+				frameRingBuffer.beginFrame(frameIndex);
+				uint32_t modelObjectCount = 0;
+				for (auto& kv : frameInfo.gameObjects)
+				{
+					if (kv.second.model != nullptr) modelObjectCount++;
+				}
+				uint32_t objectIndex = 0;
+				ObjectData* objectData = frameRingBuffer.allocateArray<ObjectData>(modelObjectCount, objectIndex);
 
-				//Game object rendering //This drawing step could be abstracted as an abstract member function in VtRenderPass
+				//Frustum culling every model primitive before building the draw list
+				frustumCuller.clear();
+				primitiveDraws.clear();
+				primitiveBounds.clear();
 				for (auto& kv : frameInfo.gameObjects)
 				{
 					auto& obj = kv.second;
 					if (obj.model == nullptr) continue;
 
-					SimplePushConstantData push{};
-					push.modelMatrix = obj.transform.mat4();
-					push.normalMatrix = obj.transform.normalMatrix();
-					
-					vkCmdPushConstants(
-						frameInfo.commandBuffer,
-						gBufferPass->getPipelineLayout(),
-						VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					glm::mat4 modelMatrix = obj.transform.mat4();
+					objectData->modelMatrix = modelMatrix;
+					objectData->normalMatrix = obj.transform.normalMatrix();
+					objectData++;
+
+					const auto& primitives = obj.model->getPrimitives();
+					for (uint32_t i = 0; i < primitives.size(); i++)
+					{
+						primitiveBounds.push_back(primitives[i].bounds.transformed(modelMatrix));
+						frustumCuller.addBox(primitiveBounds.back());
+						primitiveDraws.push_back({ &obj, i, objectIndex });
+					}
+					objectIndex++;
+				}
+				frameRingBuffer.flush();
+				frustumCuller.cull(camera.getFrustum(), visiblePrimitives);
+
+				//Sorting the visible draws by pipeline, material then front to back distance
+				renderQueue.clear();
+				depthPrepassQueue.clear();
+				VtPipeline* gBufferPipeline = gBufferPass->getDefaultPipeline();
+				uint32_t gBufferPipelineId = renderQueue.getPipelineId(gBufferPipeline);
+				glm::vec3 cameraPosition = glm::vec3(camera.getInverseView()[3]);
+				for (uint32_t drawIndex : visiblePrimitives)
+				{
+					const auto& draw = primitiveDraws[drawIndex];
+					const auto& primitive = draw.gameObject->model->getPrimitives()[draw.primitiveIndex];
+					glm::vec3 center = (primitiveBounds[drawIndex].min + primitiveBounds[drawIndex].max) * 0.5f;
+
+					VtDrawPacket packet{};
+					packet.sortKey = VtRenderQueue::makeSortKey(
 						0,
-						sizeof(SimplePushConstantData),
-						&push);
-					obj.model->bind(frameInfo.commandBuffer);
-					obj.model->draw(frameInfo.commandBuffer, frameInfo.globalDescriptorSet, gBufferPass->getPipelineLayout());
+						gBufferPipelineId,
+						renderQueue.getMaterialId(primitive.material.descriptor_set),
+						glm::length(center - cameraPosition) / FAR_PLANE,
+						static_cast<uint32_t>(draw.gameObject->getId()));
+					packet.pipeline = gBufferPipeline;
+					packet.pipelineLayout = gBufferPass->getPipelineLayout();
+					packet.gameObject = draw.gameObject;
+					packet.primitiveIndex = draw.primitiveIndex;
+					packet.drawIndex = drawIndex;
+					packet.objectIndex = draw.objectIndex;
+					renderQueue.add(packet);
+
+					if (gBufferPass->hasDepthPrepass())
+					{
+						//Opaque primitives all share one material-less pipeline and end up sorted front to back
+						bool alphaMasked = primitive.material.alpha_masked;
+						VtPipeline* depthPipeline = gBufferPass->getDepthPrepassPipeline(alphaMasked);
+						packet.sortKey = VtRenderQueue::makeSortKey(
+							0,
+							depthPrepassQueue.getPipelineId(depthPipeline),
+							alphaMasked ? depthPrepassQueue.getMaterialId(primitive.material.descriptor_set) : 0,
+							glm::length(center - cameraPosition) / FAR_PLANE,
+							static_cast<uint32_t>(draw.gameObject->getId()));
+						packet.pipeline = depthPipeline;
+						packet.bindMaterial = alphaMasked;
+						depthPrepassQueue.add(packet);
+					}
+				}
+				renderQueue.sort();
+				depthPrepassQueue.sort();
+				viewProjection = camera.getProjection() * camera.getView();
+
+#ifdef OCCLUSION_CULLING
+				//Every primitive gets a record so that its visibility is kept while it is outside of the frustum
+				occlusionRecords.resize(primitiveDraws.size());
+				for (uint32_t i = 0; i < primitiveDraws.size(); i++)
+				{
+					const auto& primitive = primitiveDraws[i].gameObject->model->getPrimitives()[primitiveDraws[i].primitiveIndex];
+
+					auto& record = occlusionRecords[i];
+					record.boundsMin = glm::vec4(primitiveBounds[i].min, 0.f);
+					record.boundsMax = glm::vec4(primitiveBounds[i].max, 0.f);
+					record.indexCount = primitive.indexCount;
+					record.firstIndex = primitive.firstIndex;
+					record.vertexOffset = static_cast<int32_t>(primitive.firstVertex);
+					record.firstInstance = primitiveDraws[i].objectIndex;
+				}
+				for (uint32_t drawIndex : visiblePrimitives)
+				{
+					occlusionRecords[drawIndex].boundsMin.w = 1.f;
+				}
+
+				occlusionCullingSystem->updateRecords(frameIndex, occlusionRecords);
+				occlusionCullingSystem->cullEarly(commandBuffer, frameIndex, viewProjection);
+#endif
+
+				// render
+#ifdef PRINT_GBUFFER_TIMINGS
+				gpuTimer.writeTimestamp(commandBuffer, frameIndex, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+				auto recordStart = std::chrono::high_resolution_clock::now();
+#endif
+#ifdef PRINT_FRAME_TIMINGS
+				frameTimer.writeTimestamp(commandBuffer, frameIndex, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+				auto passChainRecordStart = std::chrono::high_resolution_clock::now();
+#endif
+
+#ifdef RENDER_GRAPH
+				renderGraph->execute(commandBuffer, frameIndex, imageIndex);
+#else
+				if (!lightingPass->usesLightVolumes()) lightClusterSystem.cullLights(commandBuffer, frameIndex, globalDescriptorSets[frameIndex]);
+
+				if (gBufferPass->hasDepthPrepass())
+				{
+					//Depth only first, the occlusion phases run on the pre-pass so the G-buffer pass draws everything at once
+					VtSecondaryInheritance prepassInheritance = gBufferPass->getDepthPrepassSecondaryInheritance(frameIndex);
+					gBufferPass->startDepthPrepass(commandBuffer, frameIndex);
+					submitQueue(depthPrepassQueue, commandBuffer, frameIndex, prepassInheritance, earlyDrawOffset);
+#ifdef OCCLUSION_CULLING
+					gBufferPass->endDepthPrepass(commandBuffer, frameIndex);
+					occlusionCullingSystem->buildDepthPyramid(commandBuffer, frameIndex);
+					occlusionCullingSystem->cullLate(commandBuffer, frameIndex, viewProjection);
+
+					gBufferPass->continueDepthPrepass(commandBuffer, frameIndex);
+					submitQueue(depthPrepassQueue, commandBuffer, frameIndex, prepassInheritance, lateDrawOffset);
+#endif
+					gBufferPass->endDepthPrepass(commandBuffer, frameIndex);
+
+					gBufferPass->startRenderPass(commandBuffer, frameIndex, imageIndex);
+					submitQueue(renderQueue, commandBuffer, frameIndex, gBufferPass->getSecondaryInheritance(frameIndex), earlyDrawOffset);
+#ifdef OCCLUSION_CULLING
+					submitQueue(renderQueue, commandBuffer, frameIndex, gBufferPass->getSecondaryInheritance(frameIndex), lateDrawOffset);
+#endif
 				}
+				else
+				{
+					gBufferPass->startRenderPass(commandBuffer, frameIndex, imageIndex);
+
+					//Game object rendering, with occlusion culling the GPU decides which draws of the queue are done in each phase
+					submitQueue(renderQueue, commandBuffer, frameIndex, gBufferPass->getSecondaryInheritance(frameIndex), earlyDrawOffset);
+
+#ifdef OCCLUSION_CULLING
+					//Second phase: test against the depth of the first one and draw what was missing
+					gBufferPass->endRenderPass(commandBuffer, frameIndex, imageIndex);
+					occlusionCullingSystem->buildDepthPyramid(commandBuffer, frameIndex);
+					occlusionCullingSystem->cullLate(commandBuffer, frameIndex, viewProjection);
+
+					gBufferPass->continueRenderPass(commandBuffer, frameIndex);
+					submitQueue(renderQueue, commandBuffer, frameIndex, gBufferPass->getSecondaryInheritance(frameIndex), lateDrawOffset);
+#endif
+				}
+
+#ifdef PRINT_GBUFFER_TIMINGS
+				recordMilliseconds += std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - recordStart).count();
+				recordedFrames++;
+#endif
 
 #ifdef RENDER_INDICATORS
+				renderIndicators(frameInfo, gBufferPass->getSecondaryInheritance(frameIndex));
+#endif
 
-				pointLightSystem.render(frameInfo);
+				gBufferPass->endRenderPass(commandBuffer, frameIndex, imageIndex);
+#ifdef PRINT_GBUFFER_TIMINGS
+				gpuTimer.writeTimestamp(commandBuffer, frameIndex, 1, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 #endif
+				ssrDepthPyramid->buildPyramid(commandBuffer, frameIndex);
+
+				lightingPass->startRenderPass(commandBuffer, frameIndex, imageIndex);
+				lightingPass->draw(commandBuffer, frameIndex, frameInfo.globalDescriptorSet, lightBuffer, frameInfo.camera);
+				lightingPass->endRenderPass(commandBuffer, frameIndex, imageIndex);
+				ssrTrace->trace(commandBuffer, frameIndex, frameInfo.globalDescriptorSet, viewProjection);
 
-				gBufferPass->endRenderPass(commandBuffer, imageIndex);
+				reflectionPass->startRenderPass(commandBuffer, frameIndex, imageIndex);
+				reflectionPass->draw(commandBuffer, frameIndex, frameInfo.globalDescriptorSet);
+				reflectionPass->endRenderPass(commandBuffer, frameIndex, imageIndex);
+#endif
 
-				lightingPass->startRenderPass(commandBuffer, imageIndex);
-				lightingPass->bindDefaultPipeline(commandBuffer);
-				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass->getPipelineLayout(), 0,
-					1, &frameInfo.globalDescriptorSet, 0, nullptr);
-				vkCmdDraw(commandBuffer, 6, 1, 0, 0); //Drawing the lit Texture
-				lightingPass->endRenderPass(commandBuffer, imageIndex);
+#ifdef PRINT_RENDER_QUEUE_STATS
+				statsTimer += frameTime;
+				if (statsTimer > 1.f)
+				{
+					statsTimer = 0.f;
+					const auto& sorted = renderQueue.getStats();
+					const auto& unsorted = renderQueue.getUnsortedStats();
+					std::cout << "G-buffer draws " << sorted.draws
+						<< " | pipeline binds " << sorted.pipelineBinds << " (unsorted " << unsorted.pipelineBinds << ")"
+						<< " | material binds " << sorted.materialBinds << " (unsorted " << unsorted.materialBinds << ")"
+						<< " | buffer binds " << sorted.bufferBinds << " (unsorted " << unsorted.bufferBinds << ")" << std::endl;
+				}
+#endif
 
-				reflectionPass->startRenderPass(commandBuffer, imageIndex);
-				reflectionPass->bindDefaultPipeline(commandBuffer);
-				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reflectionPass->getPipelineLayout(), 0,
-					1, &frameInfo.globalDescriptorSet, 0, nullptr);
-				vkCmdDraw(commandBuffer, 6, 1, 0, 0); //Drawing the lit Texture + reflections
-				reflectionPass->endRenderPass(commandBuffer, imageIndex);
+#ifdef PRINT_FRAME_TIMINGS
+				frameTimer.writeTimestamp(commandBuffer, frameIndex, 1, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+				passChainRecordMilliseconds += std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - passChainRecordStart).count();
+				passChainRecordedFrames++;
+#endif
 
-				//Recreating swapchain sized objects
+				//Recreating swapchain sized objects. Pipelines and render passes are kept, the replaced targets go to the deletion
+				//queue of the device instead of waiting for the GPU to be idle
 				if (!vtRenderer.endFrame())
 				{
+#ifdef RENDER_GRAPH
+					//Resize is handled by the graph, the passes only rewrite their descriptors on its new views
+					renderGraph->recreateSwapchain(vtRenderer.getSwapchain());
+#endif
 					gBufferPass->recreateSwapchain(vtRenderer.getSwapchain());
 
 					lightingPass->recreateSwapchain(vtRenderer.getSwapchain());
 
+					ssrDepthPyramid->recreateSwapchain(vtRenderer.getSwapchain());
+
+					ssrTrace->recreateSwapchain(vtRenderer.getSwapchain());
+
 					reflectionPass->recreateSwapchain(vtRenderer.getSwapchain());
+#ifdef OCCLUSION_CULLING
+					//After the reflection pass so the pyramids alias its new targets instead of the old ones
+					occlusionCullingSystem->recreateSwapchain(vtRenderer.getSwapchain());
+#endif
+#ifdef PRINT_MEMORY_STATS
+					attachmentPool.printStats(std::cout);
+#endif
+#if defined(RENDER_GRAPH) && (defined(PRINT_FRAME_TIMINGS) || defined(PRINT_MEMORY_STATS))
+					renderGraph->printStats(std::cout);
+#endif
 				}
 			}
 		}
 
+		//Pipelines still compiling use layouts and render passes destroyed with the app
+		vtDevice.getPipelineCompiler().waitIdle();
 		vkDeviceWaitIdle(vtDevice.device());
+		//Retired targets still point into the attachment pool, destroyed with the app
+		vtDevice.getDeletionQueue().flush();
+	}
+
+	void FirstApp::runFramePacingBenchmark(Settings settings)
+	{
+		settings.framePacingBenchmark = true;
+		std::vector<FramePacingResult> results;
+		for (uint32_t framesInFlight = 1; framesInFlight <= VtDevice::MAX_FRAMES_IN_FLIGHT; framesInFlight++)
+		{
+			settings.framesInFlight = framesInFlight;
+			FirstApp app{ settings };
+			app.run();
+			results.insert(results.end(), app.framePacingResults.begin(), app.framePacingResults.end());
+
+			//Closing the window stops the benchmark
+			if (app.vtWindow.shouldClose()) break;
+		}
+
+		std::cout << "Frame pacing benchmark (" << PACING_MEASURE_SECONDS << " s per combination)" << std::endl;
+		std::cout << std::left << std::setw(8) << "Frames" << std::setw(16) << "Present mode"
+			<< std::right << std::setw(10) << "FPS" << std::setw(16) << "Latency (ms)" << std::setw(12) << "Max (ms)" << std::endl;
+		std::cout << std::fixed << std::setprecision(2);
+		for (const auto& result : results)
+		{
+			std::cout << std::left << std::setw(8) << result.framesInFlight << std::setw(16) << VtSwapChain::getPresentModeName(result.presentMode)
+				<< std::right << std::setw(10) << result.stats.framesPerSecond()
+				<< std::setw(16) << result.stats.averageLatencyMilliseconds
+				<< std::setw(12) << result.stats.maxLatencyMilliseconds << std::endl;
+		}
+		std::cout << std::defaultfloat << std::setprecision(6);
 	}
 
 	void FirstApp::loadGameObjects()
@@ -6,7 +6,9 @@
 #include "vt_game_object.hpp"
 #include "vt_window.hpp"
 #include "vt_renderer.hpp"
+#include "vt_render_graph.hpp"
 #include "vt_texture.hpp"
+#include "vt_transient_attachment_pool.hpp"
 #include "render_passes\gbuffer_pass.hpp"
 #include "render_passes\lighting_pass.hpp"
 #include "render_passes\reflection_pass.hpp"
@@ -22,8 +24,29 @@ namespace vt
 	public:
 		static constexpr int WIDTH = 1920;
 		static constexpr int HEIGHT = 1080;
+		static constexpr float NEAR_PLANE = 0.1f;
+		static constexpr float FAR_PLANE = 1000.f;
+		static constexpr uint32_t MAX_OBJECTS = 1024; // ObjectData slots per frame
+		static constexpr float MEMORY_REPORT_INTERVAL = 10.f; // seconds between memory budget checks
+		static constexpr float PACING_WARMUP_SECONDS = 2.f; // frame pacing benchmark, before measuring each present mode
+		static constexpr float PACING_MEASURE_SECONDS = 5.f;
 
-		FirstApp();
+		struct Settings
+		{
+			uint32_t framesInFlight = 2; // 1 to VtDevice::MAX_FRAMES_IN_FLIGHT
+			VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR; // can be cycled while running
+			// Measures every present mode of the surface in turn, then returns from run() instead of waiting for the window to close
+			bool framePacingBenchmark = false;
+		};
+
+		struct FramePacingResult
+		{
+			uint32_t framesInFlight;
+			VkPresentModeKHR presentMode;
+			VtRenderer::FramePacingStats stats;
+		};
+
+		FirstApp(const Settings& settings = Settings{});
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete;
@@ -31,12 +54,21 @@ namespace vt
 
 		void run();
 
+		// The frames in flight are fixed for the life of the device: one application per count, each measuring every
+		// present mode, then the throughput and latency of all the combinations are printed side by side
+		static void runFramePacingBenchmark(Settings settings);
+
 	private:
 		void loadGameObjects();
 
+		Settings settings;
+		std::vector<FramePacingResult> framePacingResults;
+
 		VtWindow vtWindow{ WIDTH , HEIGHT, "Hello Vulkan!" };
-		VtDevice vtDevice{ vtWindow };
-		VtRenderer vtRenderer{ vtWindow, vtDevice };
+		VtDevice vtDevice{ vtWindow, settings.framesInFlight };
+		VtRenderer vtRenderer{ vtWindow, vtDevice, settings.presentMode };
+		VtTransientAttachmentPool attachmentPool{ vtDevice };
+		std::unique_ptr<VtRenderGraph> renderGraph; // RENDER_GRAPH only, outlives the passes declaring its resources
 
 		// Order of declarations matters! :(
 		std::unique_ptr<VtDescriptorPool> globalPool{};
@@ -44,6 +76,8 @@ namespace vt
 		VtGameObject::Map gameObjects;
 		std::shared_ptr<GBufferPass> gBufferPass;
 		std::shared_ptr<LightingPass> lightingPass;
+		std::shared_ptr<SsrDepthPyramidSystem> ssrDepthPyramid;
+		std::shared_ptr<SsrTraceSystem> ssrTrace;
 		std::shared_ptr<ReflectionPass> reflectionPass;
 	};
 }
\ No newline at end of file
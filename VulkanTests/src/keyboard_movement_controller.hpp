@@ -21,6 +21,11 @@ namespace vt
             int lookUp = GLFW_KEY_UP;
             int lookDown = GLFW_KEY_DOWN;
             int mouseLook = GLFW_MOUSE_BUTTON_RIGHT;
+            int pickObject = GLFW_MOUSE_BUTTON_LEFT;
+            int toggleLightVolumes = GLFW_KEY_L;
+            int toggleHierarchicalTrace = GLFW_KEY_H;
+            int cycleReflectionResolution = GLFW_KEY_R;
+            int cyclePresentMode = GLFW_KEY_P;
         };
 
         void moveInPlaneXZ(GLFWwindow* window, float dt, VtGameObject& gameObject);
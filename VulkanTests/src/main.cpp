@@ -2,15 +2,62 @@
 
 //std
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main()
+namespace
 {
-    vt::FirstApp app{};
+    VkPresentModeKHR parsePresentMode(const std::string& name)
+    {
+        if (name == "fifo") return VK_PRESENT_MODE_FIFO_KHR;
+        if (name == "fifo-relaxed") return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        if (name == "mailbox") return VK_PRESENT_MODE_MAILBOX_KHR;
+        if (name == "immediate") return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        throw std::runtime_error("unknown present mode " + name + ", expected fifo, fifo-relaxed, mailbox or immediate!");
+    }
 
+    // --frames-in-flight <1..3> --present-mode <fifo|fifo-relaxed|mailbox|immediate> --frame-pacing-benchmark
+    vt::FirstApp::Settings parseSettings(int argc, char* argv[])
+    {
+        vt::FirstApp::Settings settings{};
+        for (int i = 1; i < argc; i++)
+        {
+            bool hasValue = i + 1 < argc;
+            if (std::strcmp(argv[i], "--frames-in-flight") == 0 && hasValue)
+            {
+                settings.framesInFlight = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (std::strcmp(argv[i], "--present-mode") == 0 && hasValue)
+            {
+                settings.presentMode = parsePresentMode(argv[++i]);
+            }
+            else if (std::strcmp(argv[i], "--frame-pacing-benchmark") == 0)
+            {
+                settings.framePacingBenchmark = true;
+            }
+            else
+            {
+                throw std::runtime_error(std::string("unknown argument ") + argv[i] + "!");
+            }
+        }
+        return settings;
+    }
+}
+
+int main(int argc, char* argv[])
+{
     try
     {
+        vt::FirstApp::Settings settings = parseSettings(argc, argv);
+        if (settings.framePacingBenchmark)
+        {
+            vt::FirstApp::runFramePacingBenchmark(settings);
+            return EXIT_SUCCESS;
+        }
+
+        vt::FirstApp app{ settings };
         app.run();
     }
     catch (const std::exception &e) {
@@ -19,4 +66,4 @@ int main()
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
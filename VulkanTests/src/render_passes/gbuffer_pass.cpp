@@ -1,10 +1,13 @@
 #include "gbuffer_pass.hpp"
+#include "../vt_model.hpp"
 #include <array>
+#include <cassert>
 
 namespace vt
 {
-	GBufferPass::GBufferPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts) : VtRenderPass(deviceRef, swapchainRef)
+	GBufferPass::GBufferPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, bool depthPrepass) : VtRenderPass(deviceRef, swapchainRef, attachmentPoolRef), depthPrepassEnabled{ depthPrepass }
 	{
+		depthFormat = swapchain->findDepthFormat();
 		createPipelineLayout(descriptorSetLayouts);
 		createAttachments();
 		createRenderPass();
@@ -12,28 +15,43 @@ namespace vt
 		createDefaultPipeline();
 	}
 
+	GBufferPass::GBufferPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, bool depthPrepass, bool lightingSubpass) : VtRenderPass(deviceRef, swapchainRef, renderGraphRef), depthPrepassEnabled{ depthPrepass }, lightingSubpassEnabled{ lightingSubpass }
+	{
+		depthFormat = swapchain->findDepthFormat();
+		createPipelineLayout(descriptorSetLayouts);
+
+		//Written by the G-buffer passes and read until the reflection pass, the graph allocates them when compiling
+		albedoResource = renderGraphRef.createTexture("G-buffer albedo", { ALBEDO_FORMAT });
+		materialResource = renderGraphRef.createTexture("G-buffer material", { MATERIAL_FORMAT });
+		normalResource = renderGraphRef.createTexture("G-buffer normal", { NORMAL_FORMAT });
+		depthResource = renderGraphRef.createTexture("G-buffer depth", { depthFormat });
+
+		createRenderPass();
+		createDefaultPipeline();
+	}
+
 	GBufferPass::~GBufferPass()
 	{
 		//virtual desctructor ! VtRenderPassDestructor is called so no need to destroy framebuffer
 		cleanAttachments();
+		cleanDepthPrepassFramebuffers();
+		vkDestroyRenderPass(device.device(), loadRenderPass, nullptr);
+		vkDestroyRenderPass(device.device(), depthPrepassRenderPass, nullptr);
+		vkDestroyRenderPass(device.device(), depthPrepassLoadRenderPass, nullptr);
 	}
 
 	void GBufferPass::cleanAttachments() {
-		VkDevice vkDevice = device.device();
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
-		{
-			albedoRoughnessAttachments[i].cleanAttachment(vkDevice);
-			positionAttachments[i].cleanAttachment(vkDevice);
-			normalMetallicAttachments[i].cleanAttachment(vkDevice);
-			depthAttachments[i].cleanAttachment(vkDevice);
-		}
+		attachmentPool.cleanAttachments(albedoAttachments);
+		attachmentPool.cleanAttachments(materialAttachments);
+		attachmentPool.cleanAttachments(normalAttachments);
+		attachmentPool.cleanAttachments(depthAttachments);
 	}
 
 	void GBufferPass::createRenderPass()
 	{
 		//Attachments Descriptions
 		VkAttachmentDescription depthAttachment{};
-		depthAttachment.format = depthAttachments[0].format;
+		depthAttachment.format = depthFormat;
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -41,10 +59,16 @@ namespace vt
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		if (depthPrepassEnabled)
+		{
+			//Depth comes from the pre-pass, which leaves it ready for sampling
+			depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			depthAttachment.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
 
 
 		VkAttachmentDescription albedoAttachment = {};
-		albedoAttachment.format = albedoRoughnessAttachments[0].format;
+		albedoAttachment.format = ALBEDO_FORMAT;
 		albedoAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		albedoAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		albedoAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -54,7 +78,7 @@ namespace vt
 		albedoAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentDescription normalAttachment = {};
-		normalAttachment.format = normalMetallicAttachments[0].format;
+		normalAttachment.format = NORMAL_FORMAT;
 		normalAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		normalAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		normalAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -63,17 +87,17 @@ namespace vt
 		normalAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		normalAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-		VkAttachmentDescription positionAttachment = {};
-		positionAttachment.format = positionAttachments[0].format;
-		positionAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		positionAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		positionAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		positionAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		positionAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		positionAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		positionAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkAttachmentDescription materialAttachment = {};
+		materialAttachment.format = MATERIAL_FORMAT;
+		materialAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		materialAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		materialAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		materialAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		materialAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		materialAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		materialAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-		std::array<VkAttachmentDescription, 4> attachmentDescs = { albedoAttachment, positionAttachment, normalAttachment, depthAttachment };
+		std::vector<VkAttachmentDescription> attachmentDescs = { albedoAttachment, materialAttachment, normalAttachment, depthAttachment };
 
 
 		//Attachment References
@@ -91,9 +115,10 @@ namespace vt
 		subpass.colorAttachmentCount = 3;
 		subpass.pColorAttachments = colorReferences.data();
 		subpass.pDepthStencilAttachment = &depthReference;
+		std::vector<VkSubpassDescription> subpasses = { subpass };
 
 		//Dependencies
-		std::array<VkSubpassDependency, 2> dependencies;
+		std::vector<VkSubpassDependency> dependencies(2);
 		//Waiting for previous frame to be completely finished before reading the attachments
 		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependencies[0].dstSubpass = 0;
@@ -102,6 +127,14 @@ namespace vt
 		dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+		if (depthPrepassEnabled)
+		{
+			//The pre-pass depth may still be read by the depth pyramid build
+			dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			dependencies[0].dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			dependencies[0].srcAccessMask |= VK_ACCESS_SHADER_READ_BIT;
+			dependencies[0].dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		}
 
 		dependencies[1].srcSubpass = 0;
 		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
@@ -111,27 +144,157 @@ namespace vt
 		dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+		//Lighting subpass, same layout as the render graph pass: the lighting attachment comes last and the G-buffer is read in place
+		std::vector<VkAttachmentReference> inputReferences;
+		VkAttachmentReference lightingReference = {};
+		VkAttachmentReference lightingDepthReference = {};
+		if (lightingSubpassEnabled)
+		{
+			VkAttachmentDescription lightingAttachment = {};
+			lightingAttachment.format = swapchain->getSwapChainImageFormat();
+			lightingAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			lightingAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			lightingAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			lightingAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			lightingAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			lightingAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			lightingAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachmentDescs.push_back(lightingAttachment);
+
+			inputReferences.push_back({ 0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			inputReferences.push_back({ 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			inputReferences.push_back({ 2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			inputReferences.push_back({ 3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			lightingReference = { 4, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+			if (hasLightingDepthBounds())
+			{
+				//Both references to the depth in the subpass share the read-only depth layout, which allows input reads
+				inputReferences[3].layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+				lightingDepthReference = { 3, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+			}
+
+			VkSubpassDescription lightingSubpass = {};
+			lightingSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			lightingSubpass.inputAttachmentCount = static_cast<uint32_t>(inputReferences.size());
+			lightingSubpass.pInputAttachments = inputReferences.data();
+			lightingSubpass.colorAttachmentCount = 1;
+			lightingSubpass.pColorAttachments = &lightingReference;
+			lightingSubpass.pDepthStencilAttachment = hasLightingDepthBounds() ? &lightingDepthReference : nullptr;
+			subpasses.push_back(lightingSubpass);
+
+			//Each fragment only reads its own pixel, the G-buffer stays in tile memory between the subpasses
+			VkSubpassDependency inputDependency = {};
+			inputDependency.srcSubpass = 0;
+			inputDependency.dstSubpass = 1;
+			inputDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			inputDependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			inputDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			inputDependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			inputDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+			if (hasLightingDepthBounds())
+			{
+				inputDependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				inputDependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			}
+			dependencies.push_back(inputDependency);
+
+			dependencies[1].srcSubpass = 1;
+		}
 
 		VkRenderPassCreateInfo renderPassInfo = {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 		renderPassInfo.pAttachments = attachmentDescs.data();
 		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
+		renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+		renderPassInfo.pSubpasses = subpasses.data();
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		VK_CHECK_RESULT(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass));
+
+		//Compatible pass that keeps the content, used to resume drawing after the depth pyramid has been built from the first half of the draws
+		for (auto& attachmentDesc : attachmentDescs)
+		{
+			attachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			attachmentDesc.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		VK_CHECK_RESULT(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &loadRenderPass));
+
+		if (depthPrepassEnabled)
+		{
+			createDepthPrepassRenderPasses();
+		}
+	}
+
+	void GBufferPass::createDepthPrepassRenderPasses()
+	{
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthReference = {};
+		depthReference.attachment = 0;
+		depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 0;
+		subpass.pDepthStencilAttachment = &depthReference;
+
+		//Depth of this frame may still be read by the lighting and reflection passes of its previous use
+		std::array<VkSubpassDependency, 2> dependencies;
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.pAttachments = &depthAttachment;
+		renderPassInfo.attachmentCount = 1;
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 2;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
 		renderPassInfo.pDependencies = dependencies.data();
 
-		VK_CHECK_RESULT(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass));
+		VK_CHECK_RESULT(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &depthPrepassRenderPass));
 
+		//Resumes the pre-pass after the depth pyramid was built, same as loadRenderPass
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
+		VK_CHECK_RESULT(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &depthPrepassLoadRenderPass));
 	}
 
 	void GBufferPass::createFramebuffer()
 	{
-		framebuffers.resize(swapchain->imageCount());
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
+		framebuffers.resize(device.getFramesInFlight());
+		for (size_t i = 0; i < device.getFramesInFlight(); i++)
 		{
-			std::array<VkImageView, 4> attachments = { albedoRoughnessAttachments[i].imageView, positionAttachments[i].imageView, normalMetallicAttachments[i].imageView, depthAttachments[i].imageView };
+			std::array<VkImageView, 4> attachments = { albedoAttachments[i].imageView, materialAttachments[i].imageView, normalAttachments[i].imageView, depthAttachments[i].imageView };
 
 			VkExtent2D swapChainExtent = swapchain->getSwapChainExtent();
 			VkFramebufferCreateInfo framebufferInfo = {};
@@ -152,12 +315,47 @@ namespace vt
 				throw std::runtime_error("failed to create framebuffer!");
 			}
 		}
+
+		if (!depthPrepassEnabled) return;
+
+		depthPrepassFramebuffers.resize(device.getFramesInFlight());
+		for (size_t i = 0; i < device.getFramesInFlight(); i++)
+		{
+			VkExtent2D swapChainExtent = swapchain->getSwapChainExtent();
+			VkFramebufferCreateInfo framebufferInfo = {};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = depthPrepassRenderPass;
+			framebufferInfo.attachmentCount = 1;
+			framebufferInfo.pAttachments = &depthAttachments[i].imageView;
+			framebufferInfo.width = swapChainExtent.width;
+			framebufferInfo.height = swapChainExtent.height;
+			framebufferInfo.layers = 1;
+
+			if (vkCreateFramebuffer(
+				device.device(),
+				&framebufferInfo,
+				nullptr,
+				&depthPrepassFramebuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create framebuffer!");
+			}
+		}
+	}
+
+	void GBufferPass::cleanDepthPrepassFramebuffers()
+	{
+		for (auto framebuffer : depthPrepassFramebuffers)
+		{
+			vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+		}
+		depthPrepassFramebuffers.clear();
 	}
 
 	void GBufferPass::createAttachments()
 	{
 		//Images
 		VkExtent2D extent = swapchain->getSwapChainExtent();
+		attachmentExtent = extent;
 
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -172,78 +370,30 @@ namespace vt
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
+		//Written by this pass and read until the reflection pass
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; //Sampled for further use as a texture
+		imageInfo.format = MATERIAL_FORMAT;
+		attachmentPool.createAttachments(imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VtFramePass::GBuffer, VtFramePass::Reflection, materialAttachments);
+		imageInfo.format = NORMAL_FORMAT;
+		attachmentPool.createAttachments(imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VtFramePass::GBuffer, VtFramePass::Reflection, normalAttachments);
 
+		imageInfo.format = ALBEDO_FORMAT;
+		attachmentPool.createAttachments(imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VtFramePass::GBuffer, VtFramePass::Reflection, albedoAttachments);
 
-		albedoRoughnessAttachments.resize(swapchain->imageCount());
-		positionAttachments.resize(swapchain->imageCount());
-		normalMetallicAttachments.resize(swapchain->imageCount());
-		depthAttachments.resize(swapchain->imageCount());
-
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
-		{
-			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; //Sampled for further use as a texture
-			positionAttachments[i].format = VK_FORMAT_R16G16B16A16_SFLOAT; //Higher precision for position and normal data
-			normalMetallicAttachments[i].format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			imageInfo.format = positionAttachments[i].format;
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, positionAttachments[i].image, positionAttachments[i].deviceMemory);
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, normalMetallicAttachments[i].image, normalMetallicAttachments[i].deviceMemory);
-
-			albedoRoughnessAttachments[i].format = VK_FORMAT_R8G8B8A8_UNORM; //Linear color until frame presenting pass
-			imageInfo.format = albedoRoughnessAttachments[i].format;
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, albedoRoughnessAttachments[i].image, albedoRoughnessAttachments[i].deviceMemory);
-
-			depthAttachments[i].format = swapchain->findDepthFormat();
-			imageInfo.format = depthAttachments[i].format;
-			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthAttachments[i].image, depthAttachments[i].deviceMemory);
-		}
-
-		//Image Views
-		VkImageViewCreateInfo viewInfo{};
-		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
-		viewInfo.subresourceRange.layerCount = 1;
-
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
-		{
-			viewInfo.image = albedoRoughnessAttachments[i].image;
-			viewInfo.format = albedoRoughnessAttachments[i].format;
-			viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &albedoRoughnessAttachments[i].imageView));
-
-			viewInfo.image = positionAttachments[i].image;
-			viewInfo.format = positionAttachments[i].format;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &positionAttachments[i].imageView));
-
-			viewInfo.image = normalMetallicAttachments[i].image;
-			viewInfo.format = normalMetallicAttachments[i].format;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &normalMetallicAttachments[i].imageView));
-
-			viewInfo.image = depthAttachments[i].image;
-			viewInfo.format = depthAttachments[i].format;
-			viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &depthAttachments[i].imageView));
-		}
-
-
+		imageInfo.format = depthFormat;
+		imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		attachmentPool.createAttachments(imageInfo, VK_IMAGE_ASPECT_DEPTH_BIT, VtFramePass::GBuffer, VtFramePass::Reflection, depthAttachments);
 	}
 
 	void GBufferPass::createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
 	{
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
+		//Object transforms are read from the frame ring buffer of the global set, no push constants
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -257,12 +407,62 @@ namespace vt
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
 		pipelineConfig.attachmentCount = 3;
+		if (depthPrepassEnabled)
+		{
+			//Depth is already final, only the closest fragment of each pixel is shaded
+			pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+			pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		}
 
 		vtPipeline = std::make_unique<VtPipeline>(
 			device,
 			G_BUFFER_PASS_VERTEX_SHADER_PATH,
 			G_BUFFER_PASS_FRAGMENT_SHADER_PATH,
 			pipelineConfig);
+
+		if (depthPrepassEnabled)
+		{
+			createDepthPrepassPipelines();
+		}
+	}
+
+	void GBufferPass::createDepthPrepassPipelines()
+	{
+		auto vertexAttributes = VtModel::Vertex::getAttributeDescriptions();
+
+		//Opaque materials: position only vertex fetch and no fragment shader
+		PipelineConfigInfo opaqueConfig{};
+		VtPipeline::defaultPipelineConfigInfo(opaqueConfig);
+		opaqueConfig.renderPass = depthPrepassRenderPass;
+		opaqueConfig.pipelineLayout = pipelineLayout;
+		opaqueConfig.attachmentCount = 0;
+		opaqueConfig.attributeDescriptions = { vertexAttributes[0] };
+
+		depthPrepassPipeline = std::make_unique<VtPipeline>(
+			device,
+			DEPTH_PREPASS_VERTEX_SHADER_PATH,
+			"",
+			opaqueConfig);
+
+		//Masked materials also need the uv for the alpha test
+		PipelineConfigInfo maskedConfig{};
+		VtPipeline::defaultPipelineConfigInfo(maskedConfig);
+		maskedConfig.renderPass = depthPrepassRenderPass;
+		maskedConfig.pipelineLayout = pipelineLayout;
+		maskedConfig.attachmentCount = 0;
+		maskedConfig.attributeDescriptions = { vertexAttributes[0], vertexAttributes[3] };
+
+		depthPrepassMaskedPipeline = std::make_unique<VtPipeline>(
+			device,
+			DEPTH_PREPASS_MASKED_VERTEX_SHADER_PATH,
+			DEPTH_PREPASS_MASKED_FRAGMENT_SHADER_PATH,
+			maskedConfig);
+	}
+
+	VtPipeline* GBufferPass::getDepthPrepassPipeline(bool alphaMasked)
+	{
+		assert(depthPrepassEnabled && "GBufferPass created without depth pre-pass");
+		return alphaMasked ? depthPrepassMaskedPipeline.get() : depthPrepassPipeline.get();
 	}
 
 	void GBufferPass::updatePipelineRessources()
@@ -275,26 +475,85 @@ namespace vt
 		//No render pass specific ressource to create (Uniform buffers, images...)
 	}
 
-	void GBufferPass::startRenderPass(VkCommandBuffer commandBuffer, int currentImageIndex)
+	void GBufferPass::startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
+	{
+		std::vector<VkClearValue> clearValues(4);
+		clearValues[0].color = { 0.f, 0.f, 0.f, 1.0f };
+		clearValues[1].color = { 0.f, 0.f, 0.f, 1.0f };
+		clearValues[2].color = { 0.f, 0.f, 0.f, 1.0f };
+		clearValues[3].depthStencil = { 1.0f, 0 };
+
+		beginRenderPass(commandBuffer, renderPass, framebuffers[frameIndex], clearValues);
+	}
+
+	void GBufferPass::continueRenderPass(VkCommandBuffer commandBuffer, int frameIndex)
 	{
+		beginRenderPass(commandBuffer, loadRenderPass, framebuffers[frameIndex], {});
+	}
+
+	void GBufferPass::startDepthPrepass(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		std::vector<VkClearValue> clearValues(1);
+		clearValues[0].depthStencil = { 1.0f, 0 };
+
+		beginRenderPass(commandBuffer, depthPrepassRenderPass, depthPrepassFramebuffers[frameIndex], clearValues);
+	}
+
+	void GBufferPass::continueDepthPrepass(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		beginRenderPass(commandBuffer, depthPrepassLoadRenderPass, depthPrepassFramebuffers[frameIndex], {});
+	}
+
+	void GBufferPass::endDepthPrepass(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		vkCmdEndRenderPass(commandBuffer);
+
+		transitionDepthForSampling(commandBuffer, frameIndex);
+	}
+
+	void GBufferPass::beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass pass, VkFramebuffer framebuffer, const std::vector<VkClearValue>& clearValues)
+	{
+		assert(!usesRenderGraph() && "The render graph begins the G-buffer passes");
+
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = renderPass;
-		renderPassInfo.framebuffer = framebuffers[currentImageIndex];
+		renderPassInfo.renderPass = pass;
+		renderPassInfo.framebuffer = framebuffer;
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
 		renderPassInfo.renderArea.extent = swapchain->getSwapChainExtent();
 
-		std::array<VkClearValue, 4> clearValues{};
-		clearValues[0].color = { 0.f, 0.f, 0.f, 1.0f };
-		clearValues[1].color = { 0.f, 0.f, 0.f, 1.0f };
-		clearValues[2].color = { 0.f, 0.f, 0.f, 1.0f };
-		clearValues[3].depthStencil = { 1.0f, 0 };
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, subpassContents);
+
+		//Only secondary command buffers can be recorded in the pass, they set the viewport themselves
+		if (subpassContents == VK_SUBPASS_CONTENTS_INLINE)
+		{
+			setViewportAndScissor(commandBuffer);
+		}
+	}
+
+	void GBufferPass::setSecondaryCommandBuffers(bool enabled)
+	{
+		subpassContents = enabled ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+	}
 
+	VtSecondaryInheritance GBufferPass::getSecondaryInheritance(int frameIndex)
+	{
+		//loadRenderPass is compatible, the same inheritance works for both halves of the pass
+		return { renderPass, 0, framebuffers[frameIndex], swapchain->getSwapChainExtent() };
+	}
+
+	VtSecondaryInheritance GBufferPass::getDepthPrepassSecondaryInheritance(int frameIndex)
+	{
+		assert(depthPrepassEnabled && "GBufferPass created without depth pre-pass");
+		return { depthPrepassRenderPass, 0, depthPrepassFramebuffers[frameIndex], swapchain->getSwapChainExtent() };
+	}
+
+	void GBufferPass::setViewportAndScissor(VkCommandBuffer commandBuffer)
+	{
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
@@ -308,7 +567,7 @@ namespace vt
 	}
 
 
-	void GBufferPass::endRenderPass(VkCommandBuffer commandBuffer, int imageIndex)
+	void GBufferPass::endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
 	{
 
 		vkCmdEndRenderPass(commandBuffer);
@@ -328,63 +587,141 @@ namespace vt
 
 
 		std::vector<VkImageMemoryBarrier> gBufferColorBarriers{};
-		colorMemoryBarrier.image = albedoRoughnessAttachments[imageIndex].image;
+		colorMemoryBarrier.image = albedoAttachments[frameIndex].image;
 		gBufferColorBarriers.push_back(colorMemoryBarrier);
-		colorMemoryBarrier.image = positionAttachments[imageIndex].image;
+		colorMemoryBarrier.image = materialAttachments[frameIndex].image;
 		gBufferColorBarriers.push_back(colorMemoryBarrier);
-		colorMemoryBarrier.image = normalMetallicAttachments[imageIndex].image;
+		colorMemoryBarrier.image = normalAttachments[frameIndex].image;
 		gBufferColorBarriers.push_back(colorMemoryBarrier);
 
 		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, gBufferColorBarriers.size(), gBufferColorBarriers.data());
 
+		transitionDepthForSampling(commandBuffer, frameIndex);
+	}
+
+	void GBufferPass::transitionDepthForSampling(VkCommandBuffer commandBuffer, int frameIndex)
+	{
 		//Transitionning Depth needs other stage masks
-		VkImageMemoryBarrier depthMemoryBarrier = colorMemoryBarrier;
+		VkImageMemoryBarrier depthMemoryBarrier{};
+		depthMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		depthMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		depthMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+		depthMemoryBarrier.subresourceRange.layerCount = 1;
+		depthMemoryBarrier.subresourceRange.baseMipLevel = 0;
+		depthMemoryBarrier.subresourceRange.levelCount = 1;
 		depthMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 		depthMemoryBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		depthMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 		depthMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-		depthMemoryBarrier.image = depthAttachments[imageIndex].image;
+		depthMemoryBarrier.image = depthAttachments[frameIndex].image;
+
+		//Depth is also read by the compute shader building the depth pyramid
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &depthMemoryBarrier);
+
+
+	}
 
-		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &depthMemoryBarrier);
+	void GBufferPass::declareGBufferWrites(VtRenderGraph::PassBuilder& builder, VtGraphLoad load)
+	{
+		assert(usesRenderGraph() && "GBufferPass created without render graph");
+
+		VkClearColorValue clearColor = { 0.f, 0.f, 0.f, 1.0f };
+		builder.writeColor(albedoResource, load, clearColor);
+		builder.writeColor(materialResource, load, clearColor);
+		builder.writeColor(normalResource, load, clearColor);
+		//The pipeline tests EQUAL against the pre-pass depth, which must be kept
+		builder.writeDepth(depthResource, depthPrepassEnabled ? VtGraphLoad::Load : load);
+		builder.setSecondaryCommandBuffers(subpassContents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	}
 
+	void GBufferPass::declareDepthPrepassWrites(VtRenderGraph::PassBuilder& builder, VtGraphLoad load)
+	{
+		assert(usesRenderGraph() && "GBufferPass created without render graph");
+		assert(depthPrepassEnabled && "GBufferPass created without depth pre-pass");
 
+		builder.writeDepth(depthResource, load);
+		builder.setSecondaryCommandBuffers(subpassContents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 	}
 
-	VkImageView GBufferPass::getAlbedoAttachment(uint32_t imageIndex)
+	void GBufferPass::declareGBufferReads(VtRenderGraph::PassBuilder& builder, VkPipelineStageFlags stages)
 	{
+		builder.sample(albedoResource, stages);
+		builder.sample(materialResource, stages);
+		builder.sample(normalResource, stages);
+		builder.sample(depthResource, stages);
+	}
 
-		assert(imageIndex < swapchain->imageCount() && "imageIndex out of range");
-		return albedoRoughnessAttachments[imageIndex].imageView;
+	void GBufferPass::declareScreenSpaceReads(VtRenderGraph::PassBuilder& builder, VkPipelineStageFlags stages)
+	{
+		builder.sample(materialResource, stages);
+		builder.sample(normalResource, stages);
+		builder.sample(depthResource, stages);
 	}
 
-	VkImageView GBufferPass::getPositionAttachment(uint32_t imageIndex)
+	void GBufferPass::declareDepthRead(VtRenderGraph::PassBuilder& builder, VkPipelineStageFlags stages)
 	{
-		assert(imageIndex < swapchain->imageCount() && "imageIndex out of range");
-		return positionAttachments[imageIndex].imageView;
+		builder.sample(depthResource, stages);
 	}
 
-	VkImageView GBufferPass::getNormalAttachment(uint32_t imageIndex)
+	void GBufferPass::declareGBufferInputs(VtRenderGraph::PassBuilder& builder)
 	{
-		assert(imageIndex < swapchain->imageCount() && "imageIndex out of range");
-		return normalMetallicAttachments[imageIndex].imageView;
+		assert(lightingSubpassEnabled && "GBufferPass created without lighting subpass");
+
+		//The depth is read to rebuild the position
+		builder.readInput(albedoResource);
+		builder.readInput(materialResource);
+		builder.readInput(normalResource);
+		if (hasLightingDepthBounds()) builder.readDepthInput(depthResource);
+		else builder.readInput(depthResource);
 	}
 
-	VkImageView GBufferPass::getDepthAttachment(uint32_t imageIndex)
+	VkImageView GBufferPass::getAlbedoAttachment(uint32_t frameIndex)
 	{
-		assert(imageIndex < swapchain->imageCount() && "imageIndex out of range");
-		return depthAttachments[imageIndex].imageView;
+		assert(frameIndex < device.getFramesInFlight() && "frameIndex out of range");
+		if (usesRenderGraph()) return renderGraph->getImageView(albedoResource, frameIndex);
+		return albedoAttachments[frameIndex].imageView;
 	}
 
-	void GBufferPass::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
+	VkImageView GBufferPass::getMaterialAttachment(uint32_t frameIndex)
 	{
-		swapchain = newSwapchain;
-		vtPipeline.reset(nullptr);
+		assert(frameIndex < device.getFramesInFlight() && "frameIndex out of range");
+		if (usesRenderGraph()) return renderGraph->getImageView(materialResource, frameIndex);
+		return materialAttachments[frameIndex].imageView;
+	}
 
-		cleanAttachments();
-		cleanFramebuffer();
+	VkImageView GBufferPass::getNormalAttachment(uint32_t frameIndex)
+	{
+		assert(frameIndex < device.getFramesInFlight() && "frameIndex out of range");
+		if (usesRenderGraph()) return renderGraph->getImageView(normalResource, frameIndex);
+		return normalAttachments[frameIndex].imageView;
+	}
 
-		createAttachments();
-		createFramebuffer();
-		createDefaultPipeline();
+	VkImageView GBufferPass::getDepthAttachment(uint32_t frameIndex)
+	{
+		assert(frameIndex < device.getFramesInFlight() && "frameIndex out of range");
+		if (usesRenderGraph()) return renderGraph->getImageView(depthResource, frameIndex);
+		return depthAttachments[frameIndex].imageView;
+	}
+
+	void GBufferPass::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
+	{
+		swapchain = newSwapchain;
+		//Pipelines and render passes are kept, viewport and scissor are dynamic state
+		if (keepsAttachments(*newSwapchain)) return;
+
+		//Frames in flight may still render to the old targets
+		attachmentPool.retireAttachments(albedoAttachments);
+		attachmentPool.retireAttachments(materialAttachments);
+		attachmentPool.retireAttachments(normalAttachments);
+		attachmentPool.retireAttachments(depthAttachments);
+		retireFramebuffers(framebuffers);
+		retireFramebuffers(depthPrepassFramebuffers);
+
+		//In render graph mode the graph recreates its images and framebuffers itself
+		if (!usesRenderGraph())
+		{
+			createAttachments();
+			createFramebuffer();
+		}
 	}
 }
\ No newline at end of file
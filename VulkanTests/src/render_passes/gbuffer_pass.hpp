@@ -2,20 +2,18 @@
 #include "../vt_device.hpp"
 #include "../vt_render_pass.hpp"
 #include "../vt_descriptors.hpp"
+#include "../vt_secondary_command_recorder.hpp"
 #include "glm\glm.hpp"
 
 namespace vt {
-	struct SimplePushConstantData
-	{
-		glm::mat4 modelMatrix{ 1.0f };
-		glm::mat4 normalMatrix{ 1.0f };
-	};
-
 	class GBufferPass :
 		public VtRenderPass
 	{
 	public:
-		GBufferPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+		//With depthPrepass the depth is filled by a depth only pass first and the G-buffer pipeline tests EQUAL without writing depth
+		GBufferPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, bool depthPrepass = false);
+		//With lightingSubpass the render pass gets a second subpass, where the lighting pass reads the whole G-buffer as input attachments
+		GBufferPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, bool depthPrepass = false, bool lightingSubpass = false);
 		virtual ~GBufferPass()override;
 
 		GBufferPass(const GBufferPass&) = delete;
@@ -29,21 +27,76 @@ namespace vt {
 		virtual void createDefaultPipeline()override;
 		virtual void updatePipelineRessources()override;
 		virtual void createPipelineRessources()override;
-		virtual void startRenderPass(VkCommandBuffer commandBuffer, int currentImageIndex)override;
-		virtual void endRenderPass(VkCommandBuffer commandBuffer, int imageIndex)override;
-		VkImageView getAlbedoAttachment(uint32_t imageIndex);
-		VkImageView getPositionAttachment(uint32_t imageIndex);
-		VkImageView getNormalAttachment(uint32_t imageIndex);
-		VkImageView getDepthAttachment(uint32_t imageIndex);
+		virtual void startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)override;
+		virtual void endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)override;
+		//Resumes the pass without clearing, the attachments must have been ended with endRenderPass
+		void continueRenderPass(VkCommandBuffer commandBuffer, int frameIndex);
+		bool hasDepthPrepass() const { return depthPrepassEnabled; }
+		bool hasLightingSubpass() const { return lightingSubpassEnabled; }
+		//The lighting subpass also binds the depth read-only as its depth attachment, for the depth bounds test of the light volumes
+		bool hasLightingDepthBounds() const { return lightingSubpassEnabled && device.isDepthBoundsSupported(); }
+		//Depth pre-pass, uses the G-buffer pipeline layout. endDepthPrepass leaves the depth ready for sampling like endRenderPass
+		void startDepthPrepass(VkCommandBuffer commandBuffer, int frameIndex);
+		void continueDepthPrepass(VkCommandBuffer commandBuffer, int frameIndex);
+		void endDepthPrepass(VkCommandBuffer commandBuffer, int frameIndex);
+		VtPipeline* getDepthPrepassPipeline(bool alphaMasked);
+		//When enabled every start/continue begins its render pass for secondary command buffers only, which set their own viewport and scissor
+		void setSecondaryCommandBuffers(bool enabled);
+		VtSecondaryInheritance getSecondaryInheritance(int frameIndex);
+		VtSecondaryInheritance getDepthPrepassSecondaryInheritance(int frameIndex);
+		//Render graph mode: the attachments are graph resources, declared in the same order as in renderPass so the pipelines are compatible with the graph passes
+		void declareGBufferWrites(VtRenderGraph::PassBuilder& builder, VtGraphLoad load);
+		void declareDepthPrepassWrites(VtRenderGraph::PassBuilder& builder, VtGraphLoad load);
+		void declareGBufferReads(VtRenderGraph::PassBuilder& builder, VkPipelineStageFlags stages);
+		void declareDepthRead(VtRenderGraph::PassBuilder& builder, VkPipelineStageFlags stages);
+		//Material, normal and depth, what the reflections need
+		void declareScreenSpaceReads(VtRenderGraph::PassBuilder& builder, VkPipelineStageFlags stages);
+		//Lighting subpass, in input attachment index order
+		void declareGBufferInputs(VtRenderGraph::PassBuilder& builder);
+		VkImageView getAlbedoAttachment(uint32_t frameIndex);
+		VkImageView getMaterialAttachment(uint32_t frameIndex);
+		VkImageView getNormalAttachment(uint32_t frameIndex);
+		VkImageView getDepthAttachment(uint32_t frameIndex);
 		virtual void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
 	private:
 		const std::string G_BUFFER_PASS_VERTEX_SHADER_PATH = "shaders/g_buffer_shader.vert.spv";
 		const std::string G_BUFFER_PASS_FRAGMENT_SHADER_PATH = "shaders/g_buffer_shader.frag.spv";
+		const std::string DEPTH_PREPASS_VERTEX_SHADER_PATH = "shaders/depth_prepass.vert.spv";
+		const std::string DEPTH_PREPASS_MASKED_VERTEX_SHADER_PATH = "shaders/depth_prepass_masked.vert.spv";
+		const std::string DEPTH_PREPASS_MASKED_FRAGMENT_SHADER_PATH = "shaders/depth_prepass_masked.frag.spv";
+		//12 bytes of color per pixel, the position is rebuilt from the depth
+		const VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM; //Linear color until frame presenting pass
+		const VkFormat MATERIAL_FORMAT = VK_FORMAT_R8G8B8A8_UNORM; //Metallic, roughness, ambient occlusion
+		const VkFormat NORMAL_FORMAT = VK_FORMAT_R16G16_SFLOAT; //Octahedral encoded view space normal
+
+		void beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass pass, VkFramebuffer framebuffer, const std::vector<VkClearValue>& clearValues);
+		void setViewportAndScissor(VkCommandBuffer commandBuffer);
+		void transitionDepthForSampling(VkCommandBuffer commandBuffer, int frameIndex);
+		void createDepthPrepassRenderPasses();
+		void createDepthPrepassPipelines();
+		void cleanDepthPrepassFramebuffers();
 
-		std::vector<VtRenderPassAttachment> albedoRoughnessAttachments;
-		std::vector<VtRenderPassAttachment> normalMetallicAttachments;
-		std::vector<VtRenderPassAttachment> positionAttachments;
+		VkRenderPass loadRenderPass = VK_NULL_HANDLE;
+		VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+
+		bool depthPrepassEnabled = false;
+		bool lightingSubpassEnabled = false;
+		VkRenderPass depthPrepassRenderPass = VK_NULL_HANDLE;
+		VkRenderPass depthPrepassLoadRenderPass = VK_NULL_HANDLE;
+		std::vector<VkFramebuffer> depthPrepassFramebuffers;
+		std::unique_ptr<VtPipeline> depthPrepassPipeline;
+		std::unique_ptr<VtPipeline> depthPrepassMaskedPipeline;
+
+		std::vector<VtRenderPassAttachment> albedoAttachments;
+		std::vector<VtRenderPassAttachment> materialAttachments;
+		std::vector<VtRenderPassAttachment> normalAttachments;
 		std::vector<VtRenderPassAttachment> depthAttachments;
+		VkFormat depthFormat;
+
+		VtGraphResource albedoResource = 0;
+		VtGraphResource materialResource = 0;
+		VtGraphResource normalResource = 0;
+		VtGraphResource depthResource = 0;
 	};
 }
 
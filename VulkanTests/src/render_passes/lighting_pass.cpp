@@ -1,17 +1,69 @@
 #include "lighting_pass.hpp"
+#include <algorithm>
 #include <array>
+#include <cassert>
 
 namespace vt
 {
-	LightingPass::LightingPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass) : VtRenderPass(deviceRef, swapchainRef)
+	struct LightingPushConstants
+	{
+		glm::vec2 inverseScreenSize;
+		uint32_t shadeLights;
+	};
+
+	namespace
+	{
+		//Depth buffer value at a distance in front of the camera, for either handedness and depth convention
+		float depthAt(const glm::mat4& projection, float distance)
+		{
+			//w of a perspective projection is the distance, the view axis is +z or -z
+			glm::vec4 clip = projection * glm::vec4(0.f, 0.f, distance * projection[2][3], 1.f);
+			return clip.z / clip.w;
+		}
+
+		//Range of depth values the sphere of a light covers, false when the whole sphere is behind the camera.
+		//A sphere crossing the near plane starts at the depth of the near plane once clamped
+		bool lightDepthBounds(const PointLight& light, const VtCamera& camera, float& minDepth, float& maxDepth)
+		{
+			const float MIN_DISTANCE = 1e-4f;
+			const glm::mat4& projection = camera.getProjection();
+			glm::vec4 center = camera.getView() * glm::vec4(glm::vec3(light.position), 1.f);
+			float distance = (projection * center).w;
+			float range = light.position.w;
+			if (distance + range <= MIN_DISTANCE) return false;
+
+			float nearDepth = depthAt(projection, std::max(distance - range, MIN_DISTANCE));
+			float farDepth = depthAt(projection, distance + range);
+			minDepth = std::clamp(std::min(nearDepth, farDepth), 0.f, 1.f);
+			maxDepth = std::clamp(std::max(nearDepth, farDepth), 0.f, 1.f);
+			return true;
+		}
+	}
+
+	LightingPass::LightingPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass) : VtRenderPass(deviceRef, swapchainRef, attachmentPoolRef)
 	{
 		this->gBufferPass = gBufferPass;
-		createGBufferTexturesDescriptorSet();
+		createGBufferTexturesDescriptorSetLayout();
 		createPipelineLayout(descriptorSetLayouts);
 		createAttachments();
 		createRenderPass();
 		createFramebuffer();
 		createDefaultPipeline();
+		createPipelineRessources();
+	}
+
+	LightingPass::LightingPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass) : VtRenderPass(deviceRef, swapchainRef, renderGraphRef)
+	{
+		this->gBufferPass = gBufferPass;
+		createGBufferTexturesDescriptorSetLayout();
+		createPipelineLayout(descriptorSetLayouts);
+		lightingResource = renderGraphRef.createTexture("Lighting", { swapchain->getSwapChainImageFormat() });
+		//As a subpass the pipeline is built against the G-buffer render pass
+		if (!isGBufferSubpass())
+		{
+			createRenderPass();
+		}
+		createDefaultPipeline();
 	}
 
 	LightingPass::~LightingPass()
@@ -73,8 +125,8 @@ namespace vt
 
 	void LightingPass::createFramebuffer()
 	{
-		framebuffers.resize(swapchain->imageCount());
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
+		framebuffers.resize(device.getFramesInFlight());
+		for (size_t i = 0; i < device.getFramesInFlight(); i++)
 		{
 			std::vector<VkImageView> attachments = { outLightingAttachment[i].imageView };
 
@@ -103,7 +155,7 @@ namespace vt
 	{
 		//Images
 		VkExtent2D extent = swapchain->getSwapChainExtent();
-		outLightingAttachment.resize(swapchain->imageCount());
+		attachmentExtent = extent;
 
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -120,37 +172,13 @@ namespace vt
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; //Sampled for further use as a texture
 
-
-
-		for (size_t i = 0; i < swapchain->imageCount(); i++) {
-			outLightingAttachment[0].format = imageInfo.format;
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, outLightingAttachment[i].image, outLightingAttachment[i].deviceMemory);
-		}
-
-		VkImageViewCreateInfo viewInfo{};
-		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
-		viewInfo.subresourceRange.layerCount = 1;
-		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		viewInfo.format = outLightingAttachment[0].format;
-
-		for (size_t i = 0; i < swapchain->imageCount(); i++) {
-			viewInfo.image = outLightingAttachment[i].image;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &outLightingAttachment[i].imageView));
-		}
-
+		//Read by the reflection pass
+		attachmentPool.createAttachments(imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VtFramePass::Lighting, VtFramePass::Reflection, outLightingAttachment);
 	}
 
 	void LightingPass::cleanAttachments()
 	{
-		VkDevice vkDevice = device.device();
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
-		{
-			outLightingAttachment[i].cleanAttachment(vkDevice);
-		}
+		attachmentPool.cleanAttachments(outLightingAttachment);
 	}
 
 	void LightingPass::createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
@@ -158,10 +186,17 @@ namespace vt
 		std::vector<VkDescriptorSetLayout> layouts = descriptorSetLayouts;
 		layouts.push_back(gBufferTexturesDescriptorSetLayout->getDescriptorSetLayout());
 
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(LightingPushConstants);
+
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
 		pipelineLayoutInfo.pSetLayouts = layouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -175,27 +210,108 @@ namespace vt
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
 		pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+		pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
 		pipelineConfig.attributeDescriptions = {}; //No vertex attribute is expected in the shader (optimization)
+		if (isGBufferSubpass())
+		{
+			pipelineConfig.renderPass = gBufferPass->getRenderPass();
+			pipelineConfig.subpass = LIGHTING_SUBPASS;
+		}
 
 		vtPipeline = std::make_unique<VtPipeline>(
 			device,
 			LIGHTING_PASS_VERTEX_SHADER_PATH,
-			LIGHTING_PASS_FRAGMENT_SHADER_PATH,
+			pipelineConfig.subpass == LIGHTING_SUBPASS ? LIGHTING_SUBPASS_FRAGMENT_SHADER_PATH : LIGHTING_PASS_FRAGMENT_SHADER_PATH,
+			pipelineConfig);
+
+		//Light volumes are added on top of the ambient term written by the default pipeline
+		pipelineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+		pipelineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		pipelineConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		pipelineConfig.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		pipelineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		pipelineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		pipelineConfig.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		if (usesDepthBounds())
+		{
+			//The G-buffer depth is bound read-only, only tested against the bounds of each light
+			pipelineConfig.depthStencilInfo.depthBoundsTestEnable = VK_TRUE;
+			pipelineConfig.dynamicStateEnables.push_back(VK_DYNAMIC_STATE_DEPTH_BOUNDS);
+			pipelineConfig.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(pipelineConfig.dynamicStateEnables.size());
+		}
+
+		lightVolumePipeline = std::make_unique<VtPipeline>(
+			device,
+			LIGHT_VOLUME_VERTEX_SHADER_PATH,
+			pipelineConfig.subpass == LIGHTING_SUBPASS ? LIGHT_VOLUME_SUBPASS_FRAGMENT_SHADER_PATH : LIGHT_VOLUME_FRAGMENT_SHADER_PATH,
 			pipelineConfig);
 	}
 
 
 	void LightingPass::createPipelineRessources()
 	{
-		createGBufferTexturesDescriptorSet();
+		//The G-buffer views change with the swapchain, the sets are written again from an empty pool. The previous sets may
+		//still be bound by frames in flight, their pool is retired rather than reset
+		gBufferTexturesDescriptorPool->retirePool();
+
+		gBufferTexturesDescriptorSets.resize(device.getFramesInFlight());
+		for (int i = 0; i < device.getFramesInFlight(); i++)
+		{
+			if (isGBufferSubpass())
+			{
+				//Input attachments are read at the fragment position, without sampler
+				VkDescriptorImageInfo albedoInputInfo = { VK_NULL_HANDLE, gBufferPass->getAlbedoAttachment(i), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+				VkDescriptorImageInfo materialInputInfo = { VK_NULL_HANDLE, gBufferPass->getMaterialAttachment(i), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+				VkDescriptorImageInfo normalInputInfo = { VK_NULL_HANDLE, gBufferPass->getNormalAttachment(i), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+				//Layout of the depth in the lighting subpass, read-only depth when it is also its depth attachment
+				VkImageLayout depthLayout = usesDepthBounds() ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				VkDescriptorImageInfo depthInputInfo = { VK_NULL_HANDLE, gBufferPass->getDepthAttachment(i), depthLayout };
+
+				VtDescriptorWriter(*gBufferTexturesDescriptorSetLayout, *gBufferTexturesDescriptorPool)
+					.writeImage(0, &albedoInputInfo)
+					.writeImage(1, &materialInputInfo)
+					.writeImage(2, &normalInputInfo)
+					.writeImage(3, &depthInputInfo)
+					.build(gBufferTexturesDescriptorSets[i]);
+				continue;
+			}
+
+			VkDescriptorImageInfo albedoImageInfo = {};
+			albedoImageInfo.sampler = gBufferSampler;
+			albedoImageInfo.imageView = gBufferPass->getAlbedoAttachment(i);
+			albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo materialImageInfo = {};
+			materialImageInfo.sampler = gBufferSampler;
+			materialImageInfo.imageView = gBufferPass->getMaterialAttachment(i);
+			materialImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo normalImageInfo = {};
+			normalImageInfo.sampler = gBufferSampler;
+			normalImageInfo.imageView = gBufferPass->getNormalAttachment(i);
+			normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo depthImageInfo = {};
+			depthImageInfo.sampler = gBufferSampler;
+			depthImageInfo.imageView = gBufferPass->getDepthAttachment(i);
+			depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VtDescriptorWriter(*gBufferTexturesDescriptorSetLayout, *gBufferTexturesDescriptorPool)
+				.writeImage(0, &albedoImageInfo)
+				.writeImage(1, &materialImageInfo)
+				.writeImage(2, &normalImageInfo)
+				.writeImage(3, &depthImageInfo)
+				.build(gBufferTexturesDescriptorSets[i]);
+
+		}
 	}
 
-	void LightingPass::startRenderPass(VkCommandBuffer commandBuffer, int currentImageIndex)
+	void LightingPass::startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
 	{
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = renderPass;
-		renderPassInfo.framebuffer = framebuffers[currentImageIndex];
+		renderPassInfo.framebuffer = framebuffers[frameIndex];
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
 		renderPassInfo.renderArea.extent = swapchain->getSwapChainExtent();
@@ -214,11 +330,72 @@ namespace vt
 		VkRect2D scissor{ {0, 0}, swapchain->getSwapChainExtent() };
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-		//This render pass is expected to do only one thing so we can bind the owned descriptor sets when starting the pass. Note that it is bound at index 2 only so that other descriptors (global) can be bound before without issues
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, &gBufferTexturesDescriptorSets[currentImageIndex], 0, nullptr);
+		//This render pass is expected to do only one thing so we can bind the owned descriptor sets when starting the pass
+		bindGBufferTextures(commandBuffer, frameIndex);
+	}
+
+	void LightingPass::bindGBufferTextures(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		//Bound at index 2 only so that other descriptors (global) can be bound before without issues
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, &gBufferTexturesDescriptorSets[frameIndex], 0, nullptr);
+	}
+
+	void LightingPass::draw(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet, const VtLightBuffer& lightBuffer, const VtCamera& camera)
+	{
+		uint32_t lightCount = lightBuffer.getLightCount();
+		VkExtent2D extent = swapchain->getSwapChainExtent();
+		LightingPushConstants push{};
+		push.inverseScreenSize = glm::vec2(1.f / extent.width, 1.f / extent.height);
+		//Read once, the pipeline may finish compiling while this is recorded
+		bool volumes = usesLightVolumes();
+		push.shadeLights = volumes ? 0 : 1;
+
+		vtPipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+		bindGBufferTextures(commandBuffer, frameIndex);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(LightingPushConstants), &push);
+		vkCmdDraw(commandBuffer, 6, 1, 0, 0); //Drawing the lit Texture
+
+		if (!volumes || lightCount == 0) return;
+
+		//Same layout, the bound sets and push constants stay valid
+		lightVolumePipeline->bind(commandBuffer);
+		if (!usesDepthBounds())
+		{
+			vkCmdDraw(commandBuffer, 6, lightCount, 0, 0);
+			return;
+		}
+
+		//The bounds reject the pixels in front of or behind the light sphere before the fragment shader reads the G-buffer,
+		//the cost follows the lit area instead of the screen rectangle. The first instance keeps indexing the light
+		for (uint32_t i = 0; i < lightCount; i++)
+		{
+			float minDepth, maxDepth;
+			if (!lightDepthBounds(lightBuffer.getLight(i), camera, minDepth, maxDepth)) continue;
+			vkCmdSetDepthBounds(commandBuffer, minDepth, maxDepth);
+			vkCmdDraw(commandBuffer, 6, 1, 0, i);
+		}
+	}
+
+	void LightingPass::declareGraphPass(VtRenderGraph::PassBuilder& builder)
+	{
+		assert(usesRenderGraph() && "LightingPass created without render graph");
+
+		if (isGBufferSubpass())
+		{
+			//Declared right after the G-buffer writes, in the same graph pass
+			builder.nextSubpass();
+			gBufferPass->declareGBufferInputs(builder);
+			builder.writeColor(lightingResource, VtGraphLoad::DontCare);
+			return;
+		}
+
+		gBufferPass->declareGBufferReads(builder, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		//No need to clear if we fill the screen with a quad
+		builder.writeColor(lightingResource, VtGraphLoad::DontCare);
 	}
 
-	void LightingPass::endRenderPass(VkCommandBuffer commandBuffer, int imageIndex)
+	void LightingPass::endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
 	{
 		vkCmdEndRenderPass(commandBuffer);
 
@@ -234,35 +411,59 @@ namespace vt
 		lightingMemoryBarrier.subresourceRange.layerCount = 1;
 		lightingMemoryBarrier.subresourceRange.baseMipLevel = 0;
 		lightingMemoryBarrier.subresourceRange.levelCount = 1;
-		lightingMemoryBarrier.image = outLightingAttachment[imageIndex].image;
+		lightingMemoryBarrier.image = outLightingAttachment[frameIndex].image;
 
 		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &lightingMemoryBarrier);
 	}
 
-	VkImageView LightingPass::getLightingAttachment(int imageIndex)
+	VkImageView LightingPass::getLightingAttachment(int frameIndex)
 	{
-		return outLightingAttachment[imageIndex].imageView;
+		if (usesRenderGraph()) return renderGraph->getImageView(lightingResource, frameIndex);
+		return outLightingAttachment[frameIndex].imageView;
 	}
 
 	void LightingPass::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
 	{
 		this->swapchain = newSwapchain;
-		vtPipeline.reset(nullptr);
-		vkDestroySampler(device.device(), gBufferSampler, nullptr);
-		cleanAttachments();
-		cleanFramebuffer();
+		//Pipelines and render passes are kept, viewport and scissor are dynamic state
+		if (!keepsAttachments(*newSwapchain))
+		{
+			attachmentPool.retireAttachments(outLightingAttachment);
+			retireFramebuffers(framebuffers);
 
-		createAttachments();
-		createFramebuffer();
-		createDefaultPipeline();
+			//In render graph mode the graph recreates its images and framebuffers itself
+			if (!usesRenderGraph())
+			{
+				createAttachments();
+				createFramebuffer();
+			}
+		}
+		//The G-buffer views may have changed
 		createPipelineRessources();
 	}
 
-	void LightingPass::createGBufferTexturesDescriptorSet()
+	void LightingPass::createGBufferTexturesDescriptorSetLayout()
 	{
+		if (isGBufferSubpass())
+		{
+			//Albedo, material, normal and depth of the pixel being shaded, read from the previous subpass
+			gBufferTexturesDescriptorPool = VtDescriptorPool::Builder(device)
+				.setMaxSets(device.getFramesInFlight())
+				.addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 4 * device.getFramesInFlight())
+				.build();
+
+			gBufferTexturesDescriptorSetLayout = VtDescriptorSetLayout::Builder(device)
+				.addBinding(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(2, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(3, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.build();
+			return;
+		}
+
 		gBufferTexturesDescriptorPool = VtDescriptorPool::Builder(device)
-			.setMaxSets(swapchain->imageCount())
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 * swapchain->imageCount())
+			.setMaxSets(device.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 * device.getFramesInFlight())
 			.build();
 
 		gBufferTexturesDescriptorSetLayout = VtDescriptorSetLayout::Builder(device)
@@ -288,37 +489,5 @@ namespace vt
 
 
 		vkCreateSampler(device.device(), &samplerInfo, nullptr, &gBufferSampler);
-
-		gBufferTexturesDescriptorSets.resize(swapchain->imageCount());
-		for (int i = 0; i < swapchain->imageCount(); i++)
-		{
-			VkDescriptorImageInfo albedoImageInfo = {};
-			albedoImageInfo.sampler = gBufferSampler;
-			albedoImageInfo.imageView = gBufferPass->getAlbedoAttachment(i);
-			albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo positionImageInfo = {};
-			positionImageInfo.sampler = gBufferSampler;
-			positionImageInfo.imageView = gBufferPass->getPositionAttachment(i);
-			positionImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo normalImageInfo = {};
-			normalImageInfo.sampler = gBufferSampler;
-			normalImageInfo.imageView = gBufferPass->getNormalAttachment(i);
-			normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo depthImageInfo = {};
-			depthImageInfo.sampler = gBufferSampler;
-			depthImageInfo.imageView = gBufferPass->getDepthAttachment(i);
-			depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VtDescriptorWriter(*gBufferTexturesDescriptorSetLayout, *gBufferTexturesDescriptorPool)
-				.writeImage(0, &albedoImageInfo)
-				.writeImage(1, &positionImageInfo)
-				.writeImage(2, &normalImageInfo)
-				.writeImage(3, &depthImageInfo)
-				.build(gBufferTexturesDescriptorSets[i]);
-
-		}
 	}
 }
\ No newline at end of file
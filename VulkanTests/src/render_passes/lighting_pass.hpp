@@ -2,13 +2,18 @@
 #include "../vt_device.hpp"
 #include "gbuffer_pass.hpp"
 #include "../vt_descriptors.hpp"
+#include "../vt_light_buffer.hpp"
+#include "../vt_camera.hpp"
 #include "glm\glm.hpp"
 
 namespace vt {
 	class LightingPass : public VtRenderPass
 	{
 	public:
-		LightingPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass);
+		LightingPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass);
+		//The G-buffer textures are only written by createPipelineRessources, once the graph is compiled.
+		//When the G-buffer pass has a lighting subpass the pipeline is built for it and the G-buffer is read as input attachments
+		LightingPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass);
 		virtual ~LightingPass()override;
 
 		LightingPass(const LightingPass&) = delete;
@@ -21,25 +26,49 @@ namespace vt {
 		virtual void createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts)override;
 		virtual void createDefaultPipeline()override;
 		virtual void createPipelineRessources()override;
-		virtual void startRenderPass(VkCommandBuffer commandBuffer, int currentImage)override;
-		virtual void endRenderPass(VkCommandBuffer commandBuffer, int imageIndex)override;
+		virtual void startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)override;
+		virtual void endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)override;
 		virtual void updatePipelineRessources()override {};
-		VkImageView getLightingAttachment(int imageIndex);
+		void bindGBufferTextures(VkCommandBuffer commandBuffer, int frameIndex);
+		//Records the lighting inside the current render pass (or lighting subpass). The fullscreen pass loops over the light clusters,
+		//light volumes write the ambient term fullscreen then add every light over the screen rectangle of its range.
+		//With depth bounds each light is its own draw, the camera gives the depth range of its sphere
+		void draw(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet, const VtLightBuffer& lightBuffer, const VtCamera& camera);
+		void setLightVolumes(bool enabled) { lightVolumes = enabled; }
+		bool requestsLightVolumes() const { return lightVolumes; }
+		//Stays on the clustered path until the light volume pipeline is compiled
+		bool usesLightVolumes() const { return lightVolumes && lightVolumePipeline && lightVolumePipeline->isReady(); }
+		//Render graph mode: samples the G-buffer and writes the lighting resource, or declares the lighting subpass of the G-buffer pass
+		void declareGraphPass(VtRenderGraph::PassBuilder& builder);
+		bool isGBufferSubpass() const { return gBufferPass->hasLightingSubpass(); }
+		//Light volumes skip the pixels outside the depth range of their light before the fragment shader runs.
+		//Needs the depth attachment, only bound in the lighting subpass
+		bool usesDepthBounds() const { return gBufferPass->hasLightingDepthBounds(); }
+		VtGraphResource getLightingResource() const { return lightingResource; }
+		VkImageView getLightingAttachment(int frameIndex);
 		virtual void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
 
 	private:
 		const std::string LIGHTING_PASS_VERTEX_SHADER_PATH = "shaders/light_shader.vert.spv";
 		const std::string LIGHTING_PASS_FRAGMENT_SHADER_PATH = "shaders/light_shader.frag.spv";
+		const std::string LIGHTING_SUBPASS_FRAGMENT_SHADER_PATH = "shaders/light_shader_subpass.frag.spv";
+		const std::string LIGHT_VOLUME_VERTEX_SHADER_PATH = "shaders/light_volume.vert.spv";
+		const std::string LIGHT_VOLUME_FRAGMENT_SHADER_PATH = "shaders/light_volume.frag.spv";
+		const std::string LIGHT_VOLUME_SUBPASS_FRAGMENT_SHADER_PATH = "shaders/light_volume_subpass.frag.spv";
+		const uint32_t LIGHTING_SUBPASS = 1;
 
 		std::shared_ptr<GBufferPass> gBufferPass;
 		std::vector<VtRenderPassAttachment> outLightingAttachment;
+		VtGraphResource lightingResource = 0;
+		std::unique_ptr<VtPipeline> lightVolumePipeline; // additive, one instance per light (one draw per light with depth bounds)
+		bool lightVolumes = false;
 
 		std::unique_ptr<VtDescriptorPool> gBufferTexturesDescriptorPool;
 		std::unique_ptr<VtDescriptorSetLayout> gBufferTexturesDescriptorSetLayout;
 		std::vector<VkDescriptorSet> gBufferTexturesDescriptorSets;
-		VkSampler gBufferSampler;
+		VkSampler gBufferSampler = VK_NULL_HANDLE;
 
-		void createGBufferTexturesDescriptorSet();
+		void createGBufferTexturesDescriptorSetLayout();
 	};
 
 }
@@ -1,17 +1,41 @@
 #include "reflection_pass.hpp"
 #include <array>
+#include <cassert>
 
 namespace vt {
-	ReflectionPass::ReflectionPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass) : VtRenderPass(deviceRef, swapchainRef)
+	struct ReflectionPushConstants
+	{
+		glm::ivec2 traceSize;
+		int32_t traceScale;
+	};
+
+	ReflectionPass::ReflectionPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass, std::shared_ptr<SsrDepthPyramidSystem> depthPyramid, std::shared_ptr<SsrTraceSystem> ssrTrace) : VtRenderPass(deviceRef, swapchainRef, attachmentPoolRef)
 	{
 		this->gBufferPass = gBufferPass;
 		this->lightingPass = lightingPass;
-		createGBufferTexturesDescriptorSet();
+		this->depthPyramid = depthPyramid;
+		this->ssrTrace = ssrTrace;
+		createGBufferTexturesDescriptorSetLayout();
 		createPipelineLayout(descriptorSetLayouts);
 		createAttachments();
 		createRenderPass();
 		createFramebuffer();
 		createDefaultPipeline();
+		createPipelineRessources();
+	}
+
+	ReflectionPass::ReflectionPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass, std::shared_ptr<SsrDepthPyramidSystem> depthPyramid, std::shared_ptr<SsrTraceSystem> ssrTrace) : VtRenderPass(deviceRef, swapchainRef, renderGraphRef)
+	{
+		this->gBufferPass = gBufferPass;
+		this->lightingPass = lightingPass;
+		this->depthPyramid = depthPyramid;
+		this->ssrTrace = ssrTrace;
+		createGBufferTexturesDescriptorSetLayout();
+		createPipelineLayout(descriptorSetLayouts);
+		swapchainResource = renderGraphRef.importSwapchain();
+		debugResource = renderGraphRef.createTexture("Reflection debug", { DEBUG_FORMAT });
+		createRenderPass();
+		createDefaultPipeline();
 	}
 
 	ReflectionPass::~ReflectionPass()
@@ -34,7 +58,7 @@ namespace vt {
 
 		// New attachment for debug output
 		VkAttachmentDescription debugAttachmentDescription{};
-		debugAttachmentDescription.format = outReflectionDebugAttachment[0].format;
+		debugAttachmentDescription.format = DEBUG_FORMAT;
 		debugAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
 		debugAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		debugAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -89,12 +113,14 @@ namespace vt {
 
 	void ReflectionPass::createFramebuffer()
 	{
-		framebuffers.resize(swapchain->imageCount());
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
+		//Any frame in flight can present to any swapchain image
+		const size_t imageCount = swapchain->imageCount();
+		framebuffers.resize(device.getFramesInFlight() * imageCount);
+		for (size_t i = 0; i < framebuffers.size(); i++)
 		{
 			std::vector<VkImageView> attachments = { 
-				swapchain->getImageView(i),
-				outReflectionDebugAttachment[i].imageView
+				swapchain->getImageView(i % imageCount),
+				outReflectionDebugAttachment[i / imageCount].imageView
 			};
 
 			VkExtent2D swapChainExtent = swapchain->getSwapChainExtent();
@@ -122,12 +148,12 @@ namespace vt {
 	{
 		//Images
 		VkExtent2D extent = swapchain->getSwapChainExtent();
-		outReflectionAttachment.resize(swapchain->imageCount());
-		outReflectionDebugAttachment.resize(swapchain->imageCount());
+		attachmentExtent = extent;
 
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = DEBUG_FORMAT;
 		imageInfo.extent.width = extent.width;
 		imageInfo.extent.height = extent.height;
 		imageInfo.extent.depth = 1;
@@ -139,46 +165,13 @@ namespace vt {
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
-
-		for (size_t i = 0; i < swapchain->imageCount(); i++) {
-			outReflectionAttachment[i].format = swapchain->getSwapChainImageFormat();
-			imageInfo.format = outReflectionAttachment[i].format;
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, outReflectionAttachment[i].image, outReflectionAttachment[i].deviceMemory);
-
-			outReflectionDebugAttachment[i].format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			imageInfo.format = outReflectionDebugAttachment[i].format;
-			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, outReflectionDebugAttachment[i].image, outReflectionDebugAttachment[i].deviceMemory);
-		}
-
-		VkImageViewCreateInfo viewInfo{};
-		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
-		viewInfo.subresourceRange.layerCount = 1;
-		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-
-		for (size_t i = 0; i < swapchain->imageCount(); i++) {
-			viewInfo.image = outReflectionAttachment[i].image;
-			viewInfo.format = outReflectionAttachment[i].format;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &outReflectionAttachment[i].imageView));
-
-			viewInfo.image = outReflectionDebugAttachment[i].image;
-			viewInfo.format = outReflectionDebugAttachment[i].format;
-			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &outReflectionDebugAttachment[i].imageView));
-		}
-
+		//Only alive in this pass, can share memory with what is done before the lighting pass
+		attachmentPool.createAttachments(imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VtFramePass::Reflection, VtFramePass::Reflection, outReflectionDebugAttachment);
 	}
 
 	void ReflectionPass::cleanAttachments()
 	{
-		VkDevice vkDevice = device.device();
-		for (size_t i = 0; i < swapchain->imageCount(); i++)
-		{
-			outReflectionAttachment[i].cleanAttachment(vkDevice);
-			outReflectionDebugAttachment[i].cleanAttachment(vkDevice);
-		}
+		attachmentPool.cleanAttachments(outReflectionDebugAttachment);
 	}
 
 	void ReflectionPass::createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
@@ -186,10 +179,18 @@ namespace vt {
 		std::vector<VkDescriptorSetLayout> layouts = descriptorSetLayouts;
 		layouts.push_back(gBufferTexturesDescriptorSetLayout->getDescriptorSetLayout());
 
+		//Grid of the reduced resolution trace, only read by the upsampling shader
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(ReflectionPushConstants);
+
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
 		pipelineLayoutInfo.pSetLayouts = layouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -211,20 +212,71 @@ namespace vt {
 			LIGHTING_PASS_VERTEX_SHADER_PATH,
 			LIGHTING_PASS_FRAGMENT_SHADER_PATH,
 			pipelineConfig);
+
+		linearMarchPipeline = std::make_unique<VtPipeline>(
+			device,
+			LIGHTING_PASS_VERTEX_SHADER_PATH,
+			LINEAR_MARCH_FRAGMENT_SHADER_PATH,
+			pipelineConfig);
+
+		upsamplePipeline = std::make_unique<VtPipeline>(
+			device,
+			LIGHTING_PASS_VERTEX_SHADER_PATH,
+			UPSAMPLE_FRAGMENT_SHADER_PATH,
+			pipelineConfig);
 	}
 
 
 	void ReflectionPass::createPipelineRessources()
 	{
-		createGBufferTexturesDescriptorSet();
+		//The G-buffer and lighting views change with the swapchain, the sets are written again from an empty pool.
+		//Frames in flight may still use the previous sets
+		gBufferTexturesDescriptorPool->retirePool();
+
+		gBufferTexturesDescriptorSets.resize(device.getFramesInFlight());
+		for (int i = 0; i < device.getFramesInFlight(); i++)
+		{
+			VkDescriptorImageInfo materialImageInfo = {};
+			materialImageInfo.sampler = gBufferSampler;
+			materialImageInfo.imageView = gBufferPass->getMaterialAttachment(i);
+			materialImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo normalImageInfo = {};
+			normalImageInfo.sampler = gBufferSampler;
+			normalImageInfo.imageView = gBufferPass->getNormalAttachment(i);
+			normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo depthImageInfo = {};
+			depthImageInfo.sampler = gBufferSampler;
+			depthImageInfo.imageView = gBufferPass->getDepthAttachment(i);
+			depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo lightingImageInfo = {};
+			lightingImageInfo.sampler = gBufferSampler;
+			lightingImageInfo.imageView = lightingPass->getLightingAttachment(i);
+			lightingImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo pyramidImageInfo = depthPyramid->getPyramidImageInfo(i);
+			VkDescriptorImageInfo reflectionImageInfo = ssrTrace->getReflectionImageInfo(i);
+
+			VtDescriptorWriter(*gBufferTexturesDescriptorSetLayout, *gBufferTexturesDescriptorPool)
+				.writeImage(0, &lightingImageInfo)
+				.writeImage(1, &materialImageInfo)
+				.writeImage(2, &normalImageInfo)
+				.writeImage(3, &depthImageInfo)
+				.writeImage(4, &pyramidImageInfo)
+				.writeImage(5, &reflectionImageInfo)
+				.build(gBufferTexturesDescriptorSets[i]);
+
+		}
 	}
 
-	void ReflectionPass::startRenderPass(VkCommandBuffer commandBuffer, int currentImageIndex)
+	void ReflectionPass::startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
 	{
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = renderPass;
-		renderPassInfo.framebuffer = framebuffers[currentImageIndex];
+		renderPassInfo.framebuffer = framebuffers[frameIndex * swapchain->imageCount() + imageIndex];
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
 		renderPassInfo.renderArea.extent = swapchain->getSwapChainExtent();
@@ -243,33 +295,71 @@ namespace vt {
 		VkRect2D scissor{ {0, 0}, swapchain->getSwapChainExtent() };
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, &gBufferTexturesDescriptorSets[currentImageIndex], 0, nullptr);
+		bindGBufferTextures(commandBuffer, frameIndex);
+	}
+
+	void ReflectionPass::bindGBufferTextures(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, &gBufferTexturesDescriptorSets[frameIndex], 0, nullptr);
+	}
+
+	void ReflectionPass::draw(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet)
+	{
+		//The hierarchical full resolution trace is the fallback while the other pipelines compile
+		if (ssrTrace->getResolution() != SsrResolution::Full && upsamplePipeline->isReady())
+		{
+			upsamplePipeline->bind(commandBuffer);
+			ReflectionPushConstants push{ ssrTrace->getTraceSize(), static_cast<int32_t>(ssrTrace->getTraceScale()) };
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ReflectionPushConstants), &push);
+		}
+		else if (hierarchicalTrace || !linearMarchPipeline->isReady()) vtPipeline->bind(commandBuffer);
+		else linearMarchPipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+		bindGBufferTextures(commandBuffer, frameIndex);
+		vkCmdDraw(commandBuffer, 6, 1, 0, 0); //Drawing the lit Texture + reflections
+	}
+
+	void ReflectionPass::declareGraphPass(VtRenderGraph::PassBuilder& builder)
+	{
+		assert(usesRenderGraph() && "ReflectionPass created without render graph");
+
+		builder.sample(lightingPass->getLightingResource(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		//The albedo is not needed, with the lighting subpass it never leaves tile memory. The depth pyramid and the reduced
+		//resolution reflections are synchronized by their systems
+		gBufferPass->declareScreenSpaceReads(builder, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		//Same order as the attachments of renderPass, no need to clear if we fill the screen
+		builder.writeColor(swapchainResource, VtGraphLoad::DontCare);
+		builder.writeColor(debugResource, VtGraphLoad::DontCare);
 	}
 
-	void ReflectionPass::endRenderPass(VkCommandBuffer commandBuffer, int imageIndex)
+	void ReflectionPass::endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
 	{
 		vkCmdEndRenderPass(commandBuffer);
 	}
 
 	void ReflectionPass::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
 	{
+		//Pipelines and render passes are kept, viewport and scissor are dynamic state
+		bool keepAttachments = keepsAttachments(*newSwapchain);
 		this->swapchain = newSwapchain;
-		vtPipeline.reset(nullptr);
-		vkDestroySampler(device.device(), gBufferSampler, nullptr);
-		cleanAttachments();
-		cleanFramebuffer();
+		if (!keepAttachments) attachmentPool.retireAttachments(outReflectionDebugAttachment);
+		//The framebuffers hold the swapchain images, they are rebuilt even when the extent is the same
+		retireFramebuffers(framebuffers);
 
-		createAttachments();
-		createFramebuffer();
-		createDefaultPipeline();
+		//In render graph mode the graph recreates its images and framebuffers itself
+		if (!usesRenderGraph())
+		{
+			if (!keepAttachments) createAttachments();
+			createFramebuffer();
+		}
 		createPipelineRessources();
 	}
 
-	void ReflectionPass::createGBufferTexturesDescriptorSet()
+	void ReflectionPass::createGBufferTexturesDescriptorSetLayout()
 	{
 		gBufferTexturesDescriptorPool = VtDescriptorPool::Builder(device)
-			.setMaxSets(swapchain->imageCount())
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5 * swapchain->imageCount())
+			.setMaxSets(device.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6 * device.getFramesInFlight())
 			.build();
 
 		gBufferTexturesDescriptorSetLayout = VtDescriptorSetLayout::Builder(device)
@@ -278,6 +368,7 @@ namespace vt {
 			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.build();
 
 
@@ -297,43 +388,5 @@ namespace vt {
 
 
 		vkCreateSampler(device.device(), &samplerInfo, nullptr, &gBufferSampler);
-
-		gBufferTexturesDescriptorSets.resize(swapchain->imageCount());
-		for (int i = 0; i < swapchain->imageCount(); i++)
-		{
-			VkDescriptorImageInfo albedoImageInfo = {};
-			albedoImageInfo.sampler = gBufferSampler;
-			albedoImageInfo.imageView = gBufferPass->getAlbedoAttachment(i);
-			albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo positionImageInfo = {};
-			positionImageInfo.sampler = gBufferSampler;
-			positionImageInfo.imageView = gBufferPass->getPositionAttachment(i);
-			positionImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo normalImageInfo = {};
-			normalImageInfo.sampler = gBufferSampler;
-			normalImageInfo.imageView = gBufferPass->getNormalAttachment(i);
-			normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo depthImageInfo = {};
-			depthImageInfo.sampler = gBufferSampler;
-			depthImageInfo.imageView = gBufferPass->getDepthAttachment(i);
-			depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkDescriptorImageInfo lightingImageInfo = {};
-			lightingImageInfo.sampler = gBufferSampler;
-			lightingImageInfo.imageView = lightingPass->getLightingAttachment(i);
-			lightingImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VtDescriptorWriter(*gBufferTexturesDescriptorSetLayout, *gBufferTexturesDescriptorPool)
-				.writeImage(0, &lightingImageInfo)
-				.writeImage(1, &albedoImageInfo)
-				.writeImage(2, &positionImageInfo)
-				.writeImage(3, &normalImageInfo)
-				.writeImage(4, &depthImageInfo)
-				.build(gBufferTexturesDescriptorSets[i]);
-
-		}
 	}
 }
\ No newline at end of file
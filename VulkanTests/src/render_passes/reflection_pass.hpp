@@ -2,6 +2,8 @@
 #include "../vt_device.hpp"
 #include "gbuffer_pass.hpp"
 #include "lighting_pass.hpp"
+#include "../systems/ssr_depth_pyramid_system.hpp"
+#include "../systems/ssr_trace_system.hpp"
 #include "../vt_descriptors.hpp"
 #include "glm\glm.hpp"
 
@@ -9,7 +11,9 @@ namespace vt {
 	class ReflectionPass : public VtRenderPass
 	{
 	public:
-		ReflectionPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass);
+		ReflectionPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass, std::shared_ptr<SsrDepthPyramidSystem> depthPyramid, std::shared_ptr<SsrTraceSystem> ssrTrace);
+		//The G-buffer and lighting textures are only written by createPipelineRessources, once the graph is compiled
+		ReflectionPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass, std::shared_ptr<SsrDepthPyramidSystem> depthPyramid, std::shared_ptr<SsrTraceSystem> ssrTrace);
 		virtual ~ReflectionPass()override;
 
 		ReflectionPass(const ReflectionPass&) = delete;
@@ -22,27 +26,45 @@ namespace vt {
 		virtual void createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts)override;
 		virtual void createDefaultPipeline()override;
 		virtual void createPipelineRessources()override;
-		virtual void startRenderPass(VkCommandBuffer commandBuffer, int currentImageIndex)override;
-		virtual void endRenderPass(VkCommandBuffer commandBuffer, int imageIndex)override;
+		//Draws to the swapchain image, framebuffers are per frame in flight and swapchain image
+		virtual void startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)override;
+		virtual void endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)override;
 		virtual void updatePipelineRessources()override {};
+		void bindGBufferTextures(VkCommandBuffer commandBuffer, int frameIndex);
+		//Records the reflections inside the current render pass, with the Hi-Z trace or the linear march it replaces.
+		//At a reduced resolution it upsamples the reflections traced by the SsrTraceSystem instead
+		void draw(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet);
+		void setHierarchicalTrace(bool enabled) { hierarchicalTrace = enabled; }
+		bool usesHierarchicalTrace() const { return hierarchicalTrace; }
+		//Render graph mode: samples the lighting and the G-buffer and writes the swapchain image
+		void declareGraphPass(VtRenderGraph::PassBuilder& builder);
 
 		virtual void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
 
 	private:
 		const std::string LIGHTING_PASS_VERTEX_SHADER_PATH = "shaders/ssr_shader.vert.spv";
 		const std::string LIGHTING_PASS_FRAGMENT_SHADER_PATH = "shaders/ssr_shader.frag.spv";
+		const std::string LINEAR_MARCH_FRAGMENT_SHADER_PATH = "shaders/ssr_linear_shader.frag.spv";
+		const std::string UPSAMPLE_FRAGMENT_SHADER_PATH = "shaders/ssr_upsample_shader.frag.spv";
+		const VkFormat DEBUG_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
 
 		std::shared_ptr<GBufferPass> gBufferPass;
 		std::shared_ptr<LightingPass> lightingPass;
-		std::vector<VtRenderPassAttachment> outReflectionAttachment;
+		std::shared_ptr<SsrDepthPyramidSystem> depthPyramid;
+		std::shared_ptr<SsrTraceSystem> ssrTrace;
+		std::unique_ptr<VtPipeline> linearMarchPipeline; // reference trace, to compare the outDebugResult hits and the cost
+		std::unique_ptr<VtPipeline> upsamplePipeline;
+		bool hierarchicalTrace = true;
 		std::vector<VtRenderPassAttachment> outReflectionDebugAttachment;
+		VtGraphResource swapchainResource = 0;
+		VtGraphResource debugResource = 0;
 
 		std::unique_ptr<VtDescriptorPool> gBufferTexturesDescriptorPool;
 		std::unique_ptr<VtDescriptorSetLayout> gBufferTexturesDescriptorSetLayout;
 		std::vector<VkDescriptorSet> gBufferTexturesDescriptorSets;
 		VkSampler gBufferSampler;
 
-		void createGBufferTexturesDescriptorSet();
+		void createGBufferTexturesDescriptorSetLayout();
 	};
 
 }
@@ -0,0 +1,70 @@
+#include "light_cluster_system.hpp"
+
+// std
+#include <stdexcept>
+
+namespace vt
+{
+	LightClusterSystem::LightClusterSystem(VtDevice& device, VkDescriptorSetLayout globalSetLayout) : vtDevice{ device }
+	{
+		createBuffers();
+		createPipeline(globalSetLayout);
+	}
+
+	LightClusterSystem::~LightClusterSystem()
+	{
+		vkDestroyPipelineLayout(vtDevice.device(), pipelineLayout, nullptr);
+	}
+
+	void LightClusterSystem::createBuffers()
+	{
+		clusterBuffers.resize(vtDevice.getFramesInFlight());
+		for (int i = 0; i < vtDevice.getFramesInFlight(); i++)
+		{
+			//Light count of every cluster followed by the fixed size light lists
+			clusterBuffers[i] = std::make_unique<VtBuffer>(
+				vtDevice,
+				sizeof(uint32_t),
+				CLUSTER_COUNT * (1 + MAX_LIGHTS_PER_CLUSTER),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	void LightClusterSystem::createPipeline(VkDescriptorSetLayout globalSetLayout)
+	{
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &globalSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
+		if (vkCreatePipelineLayout(vtDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		cullPipeline = std::make_unique<VtComputePipeline>(vtDevice, LIGHT_CLUSTER_SHADER_PATH, pipelineLayout);
+	}
+
+	void LightClusterSystem::cullLights(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet)
+	{
+		//The lists of this frame index were last read by the lighting pass of the frame whose timeline value was waited for
+		cullPipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+
+		//One invocation per cluster, empty clusters still write their count
+		vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + 127) / 128, 1, 1);
+
+		VkBufferMemoryBarrier clusterBarrier{};
+		clusterBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		clusterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		clusterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		clusterBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		clusterBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		clusterBarrier.buffer = clusterBuffers[frameIndex]->getBuffer();
+		clusterBarrier.offset = 0;
+		clusterBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1, &clusterBarrier, 0, nullptr);
+	}
+}
@@ -0,0 +1,63 @@
+/*
+Clustered light culling.
+The view frustum is split into a grid of clusters, screen tiles along x and y and exponential slices along the depth.
+A compute pass bins every point light into the clusters its range sphere touches, the lighting pass then only
+evaluates the list of the cluster its pixel falls into. The per pixel cost follows the local light density instead
+of the total light count.
+The grid is a fraction of the screen so it does not depend on the swapchain extent.
+*/
+
+#pragma once
+
+#include "../vt_buffer.hpp"
+#include "../vt_device.hpp"
+#include "../vt_pipeline.hpp"
+#include "../vt_swap_chain.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace vt
+{
+	class LightClusterSystem
+	{
+	public:
+		// Must match light_clusters.glsl
+		static constexpr uint32_t CLUSTER_COUNT_X = 16;
+		static constexpr uint32_t CLUSTER_COUNT_Y = 9;
+		static constexpr uint32_t CLUSTER_COUNT_Z = 24;
+		static constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+		static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+		// The global set layout must give compute access to the UBO (binding 0), the lights (binding 3) and the clusters (binding 4)
+		LightClusterSystem(VtDevice& device, VkDescriptorSetLayout globalSetLayout);
+		~LightClusterSystem();
+
+		LightClusterSystem(const LightClusterSystem&) = delete;
+		LightClusterSystem& operator=(const LightClusterSystem&) = delete;
+
+		// Must be recorded before the lighting pass, the global UBO and the lights of the frame have to be up to date
+		void cullLights(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet);
+
+		VkDescriptorBufferInfo getClusterBufferInfo(int frameIndex) { return clusterBuffers[frameIndex]->getDescriptorInfo(); }
+
+	private:
+		void createBuffers();
+		void createPipeline(VkDescriptorSetLayout globalSetLayout);
+
+		const std::string LIGHT_CLUSTER_SHADER_PATH = "shaders/light_cluster.comp.spv";
+
+		VtDevice& vtDevice;
+
+		std::vector<std::unique_ptr<VtBuffer>> clusterBuffers;
+
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<VtComputePipeline> cullPipeline;
+	};
+}
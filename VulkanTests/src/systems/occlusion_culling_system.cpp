@@ -0,0 +1,429 @@
+#include "occlusion_culling_system.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace vt
+{
+	struct DepthReducePushConstants
+	{
+		glm::ivec2 sourceSize;
+		glm::ivec2 destinationSize;
+	};
+
+	struct OcclusionCullPushConstants
+	{
+		glm::mat4 viewProjection;
+		glm::vec2 pyramidSize;
+		uint32_t drawCount;
+		uint32_t phase;
+	};
+
+	static uint32_t previousPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result * 2 <= value)
+		{
+			result *= 2;
+		}
+		return result;
+	}
+
+	OcclusionCullingSystem::OcclusionCullingSystem(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool, std::shared_ptr<GBufferPass> gBufferPass, uint32_t maxDrawCount)
+		: vtDevice{ device }, swapchain{ swapchain }, attachmentPool{ attachmentPool }, gBufferPass{ gBufferPass }, maxDrawCount{ maxDrawCount }
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST; //Depth values can't be interpolated without breaking the max reduction
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		VK_CHECK_RESULT(vkCreateSampler(vtDevice.device(), &samplerInfo, nullptr, &pyramidSampler));
+
+		createBuffers();
+		createDescriptorSetLayouts();
+		createPipelines();
+		createBufferDescriptorSets();
+		createDepthPyramids();
+	}
+
+	OcclusionCullingSystem::~OcclusionCullingSystem()
+	{
+		cleanDepthPyramids();
+		vkDestroySampler(vtDevice.device(), pyramidSampler, nullptr);
+		vkDestroyPipelineLayout(vtDevice.device(), reducePipelineLayout, nullptr);
+		vkDestroyPipelineLayout(vtDevice.device(), cullPipelineLayout, nullptr);
+	}
+
+	void OcclusionCullingSystem::createBuffers()
+	{
+		recordBuffers.resize(vtDevice.getFramesInFlight());
+		drawCommandBuffers.resize(vtDevice.getFramesInFlight());
+		for (int i = 0; i < vtDevice.getFramesInFlight(); i++)
+		{
+			recordBuffers[i] = std::make_unique<VtBuffer>(
+				vtDevice,
+				sizeof(OcclusionDrawRecord),
+				maxDrawCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			recordBuffers[i]->map();
+
+			//Early and late commands of a record are interleaved
+			drawCommandBuffers[i] = std::make_unique<VtBuffer>(
+				vtDevice,
+				sizeof(VkDrawIndexedIndirectCommand),
+				2 * maxDrawCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+		//Shared by every frame, it carries the result of the previous frame
+		visibilityBuffer = std::make_unique<VtBuffer>(
+			vtDevice,
+			sizeof(uint32_t),
+			maxDrawCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	void OcclusionCullingSystem::createDescriptorSetLayouts()
+	{
+		reduceSetLayout = VtDescriptorSetLayout::Builder(vtDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+
+		cullBufferSetLayout = VtDescriptorSetLayout::Builder(vtDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+
+		cullPyramidSetLayout = VtDescriptorSetLayout::Builder(vtDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+	}
+
+	void OcclusionCullingSystem::createPipelines()
+	{
+		VkPushConstantRange reducePushConstantRange{};
+		reducePushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		reducePushConstantRange.offset = 0;
+		reducePushConstantRange.size = sizeof(DepthReducePushConstants);
+
+		VkDescriptorSetLayout reduceLayout = reduceSetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &reduceLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &reducePushConstantRange;
+		if (vkCreatePipelineLayout(vtDevice.device(), &pipelineLayoutInfo, nullptr, &reducePipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		VkPushConstantRange cullPushConstantRange{};
+		cullPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		cullPushConstantRange.offset = 0;
+		cullPushConstantRange.size = sizeof(OcclusionCullPushConstants);
+
+		std::vector<VkDescriptorSetLayout> cullLayouts{ cullBufferSetLayout->getDescriptorSetLayout(), cullPyramidSetLayout->getDescriptorSetLayout() };
+
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(cullLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = cullLayouts.data();
+		pipelineLayoutInfo.pPushConstantRanges = &cullPushConstantRange;
+		if (vkCreatePipelineLayout(vtDevice.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		reducePipeline = std::make_unique<VtComputePipeline>(vtDevice, DEPTH_REDUCE_SHADER_PATH, reducePipelineLayout);
+		cullPipeline = std::make_unique<VtComputePipeline>(vtDevice, OCCLUSION_CULL_SHADER_PATH, cullPipelineLayout);
+	}
+
+	void OcclusionCullingSystem::createBufferDescriptorSets()
+	{
+		bufferDescriptorPool = VtDescriptorPool::Builder(vtDevice)
+			.setMaxSets(vtDevice.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * vtDevice.getFramesInFlight())
+			.build();
+
+		cullBufferDescriptorSets.resize(vtDevice.getFramesInFlight());
+		for (int i = 0; i < vtDevice.getFramesInFlight(); i++)
+		{
+			auto recordInfo = recordBuffers[i]->getDescriptorInfo();
+			auto visibilityInfo = visibilityBuffer->getDescriptorInfo();
+			auto commandInfo = drawCommandBuffers[i]->getDescriptorInfo();
+			VtDescriptorWriter(*cullBufferSetLayout, *bufferDescriptorPool)
+				.writeBuffer(0, &recordInfo)
+				.writeBuffer(1, &visibilityInfo)
+				.writeBuffer(2, &commandInfo)
+				.build(cullBufferDescriptorSets[i]);
+		}
+	}
+
+	void OcclusionCullingSystem::createDepthPyramids()
+	{
+		//Power of two below the screen size so that every level is exactly half the previous one
+		VkExtent2D extent = swapchain->getSwapChainExtent();
+		pyramidExtent.width = previousPowerOfTwo(extent.width);
+		pyramidExtent.height = previousPowerOfTwo(extent.height);
+		pyramidLevels = 1;
+		while ((std::max(pyramidExtent.width, pyramidExtent.height) >> pyramidLevels) > 0)
+		{
+			pyramidLevels++;
+		}
+
+		const uint32_t frameCount = vtDevice.getFramesInFlight();
+		pyramidDescriptorPool = VtDescriptorPool::Builder(vtDevice)
+			.setMaxSets(frameCount * (pyramidLevels + 1))
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount * (pyramidLevels + 1))
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, frameCount * pyramidLevels)
+			.build();
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.extent.width = pyramidExtent.width;
+		imageInfo.extent.height = pyramidExtent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = pyramidLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		depthPyramids.resize(frameCount);
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
+			//Built and read during the G-buffer pass only, buildDepthPyramid discards the previous content
+			auto& pyramid = depthPyramids[i];
+			pyramid.image = attachmentPool.createImage(i, imageInfo, VtFramePass::GBuffer, VtFramePass::GBuffer);
+
+			viewInfo.image = pyramid.image;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = pyramidLevels;
+			VK_CHECK_RESULT(vkCreateImageView(vtDevice.device(), &viewInfo, nullptr, &pyramid.fullView));
+
+			pyramid.mipViews.resize(pyramidLevels);
+			pyramid.reduceDescriptorSets.resize(pyramidLevels);
+			for (uint32_t level = 0; level < pyramidLevels; level++)
+			{
+				viewInfo.subresourceRange.baseMipLevel = level;
+				viewInfo.subresourceRange.levelCount = 1;
+				VK_CHECK_RESULT(vkCreateImageView(vtDevice.device(), &viewInfo, nullptr, &pyramid.mipViews[level]));
+
+				//Level 0 reduces the G-buffer depth, the others reduce the previous level
+				VkDescriptorImageInfo sourceInfo{};
+				sourceInfo.sampler = pyramidSampler;
+				sourceInfo.imageView = level == 0 ? gBufferPass->getDepthAttachment(i) : pyramid.mipViews[level - 1];
+				sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+				VkDescriptorImageInfo destinationInfo{};
+				destinationInfo.imageView = pyramid.mipViews[level];
+				destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+				VtDescriptorWriter(*reduceSetLayout, *pyramidDescriptorPool)
+					.writeImage(0, &sourceInfo)
+					.writeImage(1, &destinationInfo)
+					.build(pyramid.reduceDescriptorSets[level]);
+			}
+
+			VkDescriptorImageInfo pyramidInfo{};
+			pyramidInfo.sampler = pyramidSampler;
+			pyramidInfo.imageView = pyramid.fullView;
+			pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			VtDescriptorWriter(*cullPyramidSetLayout, *pyramidDescriptorPool)
+				.writeImage(0, &pyramidInfo)
+				.build(pyramid.cullDescriptorSet);
+		}
+	}
+
+	void OcclusionCullingSystem::cleanDepthPyramids()
+	{
+		VkDevice device = vtDevice.device();
+		for (auto& pyramid : depthPyramids)
+		{
+			for (auto mipView : pyramid.mipViews)
+			{
+				vkDestroyImageView(device, mipView, nullptr);
+			}
+			vkDestroyImageView(device, pyramid.fullView, nullptr);
+			attachmentPool.destroyImage(pyramid.image);
+		}
+		depthPyramids.clear();
+		pyramidDescriptorPool.reset();
+	}
+
+	void OcclusionCullingSystem::retireDepthPyramids()
+	{
+		VkDevice device = vtDevice.device();
+		VtDeletionQueue& deletionQueue = vtDevice.getDeletionQueue();
+		for (auto& pyramid : depthPyramids)
+		{
+			std::vector<VkImageView> views = pyramid.mipViews;
+			views.push_back(pyramid.fullView);
+			deletionQueue.retire([device, views]()
+				{
+					for (auto view : views)
+					{
+						vkDestroyImageView(device, view, nullptr);
+					}
+				});
+			attachmentPool.retireImage(pyramid.image);
+		}
+		depthPyramids.clear();
+		deletionQueue.retire(std::move(pyramidDescriptorPool));
+	}
+
+	void OcclusionCullingSystem::updateRecords(int frameIndex, const std::vector<OcclusionDrawRecord>& records)
+	{
+		assert(records.size() <= maxDrawCount && "Too many draw records for the occlusion culling buffers");
+
+		drawCount = static_cast<uint32_t>(records.size());
+		if (drawCount == 0) return;
+
+		VkDeviceSize size = sizeof(OcclusionDrawRecord) * drawCount;
+		recordBuffers[frameIndex]->writeToBuffer(const_cast<OcclusionDrawRecord*>(records.data()), size);
+		recordBuffers[frameIndex]->flush();
+	}
+
+	void OcclusionCullingSystem::cullEarly(VkCommandBuffer commandBuffer, int frameIndex, const glm::mat4& viewProjection)
+	{
+		if (!visibilityCleared)
+		{
+			//Nothing was visible before the first frame
+			vkCmdFillBuffer(commandBuffer, visibilityBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+			visibilityCleared = true;
+		}
+
+		//Visibility was written by the late cull of the previous frame (or by the fill above)
+		VkBufferMemoryBarrier visibilityBarrier{};
+		visibilityBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		visibilityBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		visibilityBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		visibilityBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		visibilityBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		visibilityBarrier.buffer = visibilityBuffer->getBuffer();
+		visibilityBarrier.offset = 0;
+		visibilityBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &visibilityBarrier, 0, nullptr);
+
+		dispatchCull(commandBuffer, frameIndex, viewProjection, Phase::Early);
+	}
+
+	void OcclusionCullingSystem::buildDepthPyramid(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		auto& pyramid = depthPyramids[frameIndex];
+
+		//Every level is rewritten so the previous content can be discarded
+		VkImageMemoryBarrier pyramidBarrier{};
+		pyramidBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramidBarrier.image = pyramid.image;
+		pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		pyramidBarrier.subresourceRange.baseArrayLayer = 0;
+		pyramidBarrier.subresourceRange.layerCount = 1;
+		pyramidBarrier.subresourceRange.baseMipLevel = 0;
+		pyramidBarrier.subresourceRange.levelCount = pyramidLevels;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+
+		reducePipeline->bind(commandBuffer);
+
+		VkExtent2D depthExtent = swapchain->getSwapChainExtent();
+		glm::ivec2 sourceSize{ depthExtent.width, depthExtent.height };
+		for (uint32_t level = 0; level < pyramidLevels; level++)
+		{
+			glm::ivec2 destinationSize{ std::max(pyramidExtent.width >> level, 1u), std::max(pyramidExtent.height >> level, 1u) };
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reducePipelineLayout, 0, 1, &pyramid.reduceDescriptorSets[level], 0, nullptr);
+
+			DepthReducePushConstants push{ sourceSize, destinationSize };
+			vkCmdPushConstants(commandBuffer, reducePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthReducePushConstants), &push);
+			vkCmdDispatch(commandBuffer, (destinationSize.x + 7) / 8, (destinationSize.y + 7) / 8, 1);
+
+			//Next level (or the late cull) reads this one
+			pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			pyramidBarrier.subresourceRange.baseMipLevel = level;
+			pyramidBarrier.subresourceRange.levelCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+
+			sourceSize = destinationSize;
+		}
+	}
+
+	void OcclusionCullingSystem::cullLate(VkCommandBuffer commandBuffer, int frameIndex, const glm::mat4& viewProjection)
+	{
+		dispatchCull(commandBuffer, frameIndex, viewProjection, Phase::Late);
+	}
+
+	void OcclusionCullingSystem::dispatchCull(VkCommandBuffer commandBuffer, int frameIndex, const glm::mat4& viewProjection, Phase phase)
+	{
+		if (drawCount == 0) return;
+
+		cullPipeline->bind(commandBuffer);
+
+		std::vector<VkDescriptorSet> sets{ cullBufferDescriptorSets[frameIndex], depthPyramids[frameIndex].cullDescriptorSet };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+
+		OcclusionCullPushConstants push{};
+		push.viewProjection = viewProjection;
+		push.pyramidSize = glm::vec2(pyramidExtent.width, pyramidExtent.height);
+		push.drawCount = drawCount;
+		push.phase = static_cast<uint32_t>(phase);
+		vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(OcclusionCullPushConstants), &push);
+		vkCmdDispatch(commandBuffer, (drawCount + 63) / 64, 1, 1);
+
+		VkBufferMemoryBarrier commandBarrier{};
+		commandBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		commandBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		commandBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		commandBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		commandBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		commandBarrier.buffer = drawCommandBuffers[frameIndex]->getBuffer();
+		commandBarrier.offset = 0;
+		commandBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1, &commandBarrier, 0, nullptr);
+	}
+
+	VkDeviceSize OcclusionCullingSystem::getDrawCommandOffset(Phase phase, uint32_t recordIndex) const
+	{
+		uint32_t commandIndex = 2 * recordIndex + static_cast<uint32_t>(phase);
+		return static_cast<VkDeviceSize>(commandIndex) * sizeof(VkDrawIndexedIndirectCommand);
+	}
+
+	void OcclusionCullingSystem::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
+	{
+		swapchain = newSwapchain;
+		retireDepthPyramids();
+		createDepthPyramids();
+	}
+}
@@ -0,0 +1,120 @@
+/*
+Two phase occlusion culling on the GPU.
+Phase 1 draws what was visible last frame, a max depth pyramid (Hi-Z) is then built from that depth and phase 2 tests
+every frustum visible primitive against it, drawing only the ones that just became visible.
+Draws are issued with vkCmdDrawIndexedIndirect, the compute shaders only write the instance count (0 or 1).
+The pyramid only lives during the G-buffer pass of its frame, its memory comes from the transient attachment pool.
+*/
+
+#pragma once
+
+#include "../vt_buffer.hpp"
+#include "../vt_descriptors.hpp"
+#include "../vt_device.hpp"
+#include "../vt_pipeline.hpp"
+#include "../vt_swap_chain.hpp"
+#include "../vt_transient_attachment_pool.hpp"
+#include "../render_passes/gbuffer_pass.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace vt
+{
+	// Matches the DrawRecord struct of occlusion_cull.comp (std430)
+	struct OcclusionDrawRecord
+	{
+		glm::vec4 boundsMin{ 0.f }; // world space, w = 1 when the primitive passed the frustum test
+		glm::vec4 boundsMax{ 0.f };
+		uint32_t indexCount = 0;
+		uint32_t firstIndex = 0;
+		int32_t vertexOffset = 0;
+		uint32_t firstInstance = 0; // object slot in the frame ring buffer
+	};
+
+	class OcclusionCullingSystem
+	{
+	public:
+		enum class Phase : uint32_t
+		{
+			Early = 0,
+			Late = 1
+		};
+
+		OcclusionCullingSystem(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool, std::shared_ptr<GBufferPass> gBufferPass, uint32_t maxDrawCount);
+		~OcclusionCullingSystem();
+
+		OcclusionCullingSystem(const OcclusionCullingSystem&) = delete;
+		OcclusionCullingSystem& operator=(const OcclusionCullingSystem&) = delete;
+
+		// Records must be given in the same order every frame, the visibility of a record is remembered by its index
+		void updateRecords(int frameIndex, const std::vector<OcclusionDrawRecord>& records);
+		void cullEarly(VkCommandBuffer commandBuffer, int frameIndex, const glm::mat4& viewProjection);
+		// Must be recorded after the G-buffer pass has ended, reads its depth attachment
+		void buildDepthPyramid(VkCommandBuffer commandBuffer, int frameIndex);
+		void cullLate(VkCommandBuffer commandBuffer, int frameIndex, const glm::mat4& viewProjection);
+
+		VkBuffer getDrawCommandBuffer(int frameIndex) const { return drawCommandBuffers[frameIndex]->getBuffer(); }
+		VkDeviceSize getDrawCommandOffset(Phase phase, uint32_t recordIndex) const;
+
+		void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
+
+	private:
+		struct DepthPyramid
+		{
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView fullView = VK_NULL_HANDLE;
+			std::vector<VkImageView> mipViews;
+			std::vector<VkDescriptorSet> reduceDescriptorSets;
+			VkDescriptorSet cullDescriptorSet = VK_NULL_HANDLE;
+		};
+
+		void createBuffers();
+		void createDescriptorSetLayouts();
+		void createPipelines();
+		void createBufferDescriptorSets();
+		void createDepthPyramids();
+		void cleanDepthPyramids();
+		// Same as cleanDepthPyramids for pyramids still used by frames in flight, on a resize
+		void retireDepthPyramids();
+		void dispatchCull(VkCommandBuffer commandBuffer, int frameIndex, const glm::mat4& viewProjection, Phase phase);
+
+		const std::string DEPTH_REDUCE_SHADER_PATH = "shaders/hiz_reduce.comp.spv";
+		const std::string OCCLUSION_CULL_SHADER_PATH = "shaders/occlusion_cull.comp.spv";
+
+		VtDevice& vtDevice;
+		std::shared_ptr<VtSwapChain> swapchain;
+		VtTransientAttachmentPool& attachmentPool;
+		std::shared_ptr<GBufferPass> gBufferPass;
+		uint32_t maxDrawCount;
+		uint32_t drawCount = 0;
+		bool visibilityCleared = false;
+
+		std::vector<std::unique_ptr<VtBuffer>> recordBuffers;
+		std::vector<std::unique_ptr<VtBuffer>> drawCommandBuffers;
+		std::unique_ptr<VtBuffer> visibilityBuffer;
+
+		std::unique_ptr<VtDescriptorPool> bufferDescriptorPool;
+		std::unique_ptr<VtDescriptorPool> pyramidDescriptorPool;
+		std::unique_ptr<VtDescriptorSetLayout> reduceSetLayout;
+		std::unique_ptr<VtDescriptorSetLayout> cullBufferSetLayout;
+		std::unique_ptr<VtDescriptorSetLayout> cullPyramidSetLayout;
+		std::vector<VkDescriptorSet> cullBufferDescriptorSets;
+
+		VkPipelineLayout reducePipelineLayout;
+		VkPipelineLayout cullPipelineLayout;
+		std::unique_ptr<VtComputePipeline> reducePipeline;
+		std::unique_ptr<VtComputePipeline> cullPipeline;
+
+		VkSampler pyramidSampler;
+		VkExtent2D pyramidExtent{};
+		uint32_t pyramidLevels = 0;
+		std::vector<DepthPyramid> depthPyramids;
+	};
+}
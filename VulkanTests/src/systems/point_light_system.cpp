@@ -72,29 +72,48 @@ namespace vt
 			pipelineConfig);
 	}
 
-	void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo)
+	static PointLight makeLight(const VtGameObject& obj)
+	{
+		PointLight light{};
+		light.position = glm::vec4(obj.transform.translation, obj.pointLight->range);
+		light.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+		return light;
+	}
+
+	void PointLightSystem::addLights(VtGameObject::Map& gameObjects, VtLightBuffer& lightBuffer)
+	{
+		for (auto& kv : gameObjects)
+		{
+			auto& obj = kv.second;
+			if (obj.pointLight == nullptr || slottedLights.count(obj.getId()) > 0) continue;
+
+			lightSlots.push_back({ &obj, lightBuffer.addLight(makeLight(obj)) });
+			slottedLights.insert(obj.getId());
+		}
+	}
+
+	void PointLightSystem::update(FrameInfo& frameInfo, VtLightBuffer& lightBuffer)
 	{
 		auto rotateLight = glm::rotate(
 			glm::mat4(1.f),
 			frameInfo.frameTime * 0.25f,
 			{ 0.f, -1.f, 0.f });
 
-		int lightIndex = 0;
-		for (auto& kv : frameInfo.gameObjects)
+		for (auto& lightSlot : lightSlots)
 		{
-			auto & obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
+			auto& obj = *lightSlot.gameObject;
 
 			// update
 			obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
 
-			// copy light to ubo
-			ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-			ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-			lightIndex += 1;
+			// copy light to the light buffer when it moved or changed
+			PointLight light = makeLight(obj);
+			const PointLight& previous = lightBuffer.getLight(lightSlot.slot);
+			if (light.position != previous.position || light.color != previous.color)
+			{
+				lightBuffer.updateLight(lightSlot.slot, light);
+			}
 		}
-
-		ubo.numLights = lightIndex;
 	}
 
 	void PointLightSystem::render(FrameInfo& frameInfo)
@@ -5,10 +5,12 @@
 #include "../vt_model.hpp"
 #include "../vt_frame_info.hpp"
 #include "../vt_game_object.hpp"
+#include "../vt_light_buffer.hpp"
 #include "../vt_pipeline.hpp"
 
 // std
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 namespace vt
@@ -22,7 +24,10 @@ namespace vt
 		PointLightSystem(const PointLightSystem&) = delete;
 		PointLightSystem& operator=(const PointLightSystem&) = delete;
 
-		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+		// Gives a light buffer slot to the point lights that don't have one yet
+		void addLights(VtGameObject::Map& gameObjects, VtLightBuffer& lightBuffer);
+		// Only the lights that changed since the last update are written to the light buffer
+		void update(FrameInfo& frameInfo, VtLightBuffer& lightBuffer);
 		void render(FrameInfo& frameInfo);
 
 	private:
@@ -31,6 +36,15 @@ namespace vt
 		
 		VtDevice& vtDevice;
 
+		// Light buffer slot of every point light, Map elements keep their address when the map grows
+		struct LightSlot
+		{
+			VtGameObject* gameObject;
+			uint32_t slot;
+		};
+		std::vector<LightSlot> lightSlots;
+		std::unordered_set<VtGameObject::id_t> slottedLights;
+
 		std::unique_ptr<VtPipeline> vtPipeline;
 		VkPipelineLayout pipelineLayout;
 	};
@@ -0,0 +1,282 @@
+#include "ssr_depth_pyramid_system.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace vt
+{
+	struct SsrDepthReducePushConstants
+	{
+		glm::ivec2 sourceSize;
+		glm::ivec2 destinationSize;
+	};
+
+	SsrDepthPyramidSystem::SsrDepthPyramidSystem(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool, std::shared_ptr<GBufferPass> gBufferPass)
+		: vtDevice{ device }, swapchain{ swapchain }, attachmentPool{ attachmentPool }, gBufferPass{ gBufferPass }
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST; //Depth values can't be interpolated without breaking the min reduction
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		VK_CHECK_RESULT(vkCreateSampler(vtDevice.device(), &samplerInfo, nullptr, &pyramidSampler));
+
+		createDescriptorSetLayout();
+		createPipeline();
+		createDepthPyramids();
+		if (!gBufferPass->usesRenderGraph())
+		{
+			createPipelineRessources();
+		}
+	}
+
+	SsrDepthPyramidSystem::~SsrDepthPyramidSystem()
+	{
+		cleanDepthPyramids();
+		vkDestroySampler(vtDevice.device(), pyramidSampler, nullptr);
+		vkDestroyPipelineLayout(vtDevice.device(), reducePipelineLayout, nullptr);
+	}
+
+	void SsrDepthPyramidSystem::createDescriptorSetLayout()
+	{
+		reduceSetLayout = VtDescriptorSetLayout::Builder(vtDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+	}
+
+	void SsrDepthPyramidSystem::createPipeline()
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(SsrDepthReducePushConstants);
+
+		VkDescriptorSetLayout reduceLayout = reduceSetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &reduceLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(vtDevice.device(), &pipelineLayoutInfo, nullptr, &reducePipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		reducePipeline = std::make_unique<VtComputePipeline>(vtDevice, DEPTH_REDUCE_MIN_SHADER_PATH, reducePipelineLayout);
+	}
+
+	void SsrDepthPyramidSystem::createDepthPyramids()
+	{
+		//Full resolution level 0 so that the finest traversal level matches the depth texels, then the usual mip chain
+		VkExtent2D extent = swapchain->getSwapChainExtent();
+		pyramidLevels = 1;
+		while ((std::max(extent.width, extent.height) >> pyramidLevels) > 0)
+		{
+			pyramidLevels++;
+		}
+
+		const uint32_t frameCount = vtDevice.getFramesInFlight();
+		pyramidDescriptorPool = VtDescriptorPool::Builder(vtDevice)
+			.setMaxSets(frameCount * pyramidLevels)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount * pyramidLevels)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, frameCount * pyramidLevels)
+			.build();
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.extent.width = extent.width;
+		imageInfo.extent.height = extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = pyramidLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		depthPyramids.resize(frameCount);
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
+			//Written after the G-buffer pass, read by the reflection pass, buildPyramid discards the previous content
+			auto& pyramid = depthPyramids[i];
+			pyramid.image = attachmentPool.createImage(i, imageInfo, VtFramePass::GBuffer, VtFramePass::Reflection);
+
+			viewInfo.image = pyramid.image;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = pyramidLevels;
+			VK_CHECK_RESULT(vkCreateImageView(vtDevice.device(), &viewInfo, nullptr, &pyramid.fullView));
+
+			pyramid.mipViews.resize(pyramidLevels);
+			for (uint32_t level = 0; level < pyramidLevels; level++)
+			{
+				viewInfo.subresourceRange.baseMipLevel = level;
+				viewInfo.subresourceRange.levelCount = 1;
+				VK_CHECK_RESULT(vkCreateImageView(vtDevice.device(), &viewInfo, nullptr, &pyramid.mipViews[level]));
+			}
+		}
+	}
+
+	void SsrDepthPyramidSystem::createPipelineRessources()
+	{
+		//The G-buffer depth view changes with the swapchain, the sets are written again from an empty pool. The previous
+		//sets may still be bound by frames in flight
+		pyramidDescriptorPool->retirePool();
+
+		for (uint32_t i = 0; i < depthPyramids.size(); i++)
+		{
+			auto& pyramid = depthPyramids[i];
+			pyramid.reduceDescriptorSets.resize(pyramidLevels);
+			for (uint32_t level = 0; level < pyramidLevels; level++)
+			{
+				//Level 0 copies the G-buffer depth, the others reduce the previous level
+				VkDescriptorImageInfo sourceInfo{};
+				sourceInfo.sampler = pyramidSampler;
+				sourceInfo.imageView = level == 0 ? gBufferPass->getDepthAttachment(i) : pyramid.mipViews[level - 1];
+				sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+				VkDescriptorImageInfo destinationInfo{};
+				destinationInfo.imageView = pyramid.mipViews[level];
+				destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+				VtDescriptorWriter(*reduceSetLayout, *pyramidDescriptorPool)
+					.writeImage(0, &sourceInfo)
+					.writeImage(1, &destinationInfo)
+					.build(pyramid.reduceDescriptorSets[level]);
+			}
+		}
+	}
+
+	void SsrDepthPyramidSystem::cleanDepthPyramids()
+	{
+		VkDevice device = vtDevice.device();
+		for (auto& pyramid : depthPyramids)
+		{
+			for (auto mipView : pyramid.mipViews)
+			{
+				vkDestroyImageView(device, mipView, nullptr);
+			}
+			vkDestroyImageView(device, pyramid.fullView, nullptr);
+			attachmentPool.destroyImage(pyramid.image);
+		}
+		depthPyramids.clear();
+		pyramidDescriptorPool.reset();
+	}
+
+	void SsrDepthPyramidSystem::retireDepthPyramids()
+	{
+		VkDevice device = vtDevice.device();
+		VtDeletionQueue& deletionQueue = vtDevice.getDeletionQueue();
+		for (auto& pyramid : depthPyramids)
+		{
+			std::vector<VkImageView> views = pyramid.mipViews;
+			views.push_back(pyramid.fullView);
+			deletionQueue.retire([device, views]()
+				{
+					for (auto view : views)
+					{
+						vkDestroyImageView(device, view, nullptr);
+					}
+				});
+			attachmentPool.retireImage(pyramid.image);
+		}
+		depthPyramids.clear();
+		deletionQueue.retire(std::move(pyramidDescriptorPool));
+	}
+
+	void SsrDepthPyramidSystem::buildPyramid(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		auto& pyramid = depthPyramids[frameIndex];
+
+		//The depth writes of the G-buffer pass are made visible here, the render graph already did it with its own barrier
+		VkMemoryBarrier depthBarrier{};
+		depthBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		//Every level is rewritten so the previous content can be discarded
+		VkImageMemoryBarrier pyramidBarrier{};
+		pyramidBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramidBarrier.image = pyramid.image;
+		pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		pyramidBarrier.subresourceRange.baseArrayLayer = 0;
+		pyramidBarrier.subresourceRange.layerCount = 1;
+		pyramidBarrier.subresourceRange.baseMipLevel = 0;
+		pyramidBarrier.subresourceRange.levelCount = pyramidLevels;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &depthBarrier, 0, nullptr, 1, &pyramidBarrier);
+
+		reducePipeline->bind(commandBuffer);
+
+		VkExtent2D depthExtent = swapchain->getSwapChainExtent();
+		glm::ivec2 sourceSize{ depthExtent.width, depthExtent.height };
+		for (uint32_t level = 0; level < pyramidLevels; level++)
+		{
+			glm::ivec2 destinationSize{ std::max(depthExtent.width >> level, 1u), std::max(depthExtent.height >> level, 1u) };
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reducePipelineLayout, 0, 1, &pyramid.reduceDescriptorSets[level], 0, nullptr);
+
+			SsrDepthReducePushConstants push{ sourceSize, destinationSize };
+			vkCmdPushConstants(commandBuffer, reducePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SsrDepthReducePushConstants), &push);
+			vkCmdDispatch(commandBuffer, (destinationSize.x + 7) / 8, (destinationSize.y + 7) / 8, 1);
+
+			//Next level reads this one
+			pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			pyramidBarrier.subresourceRange.baseMipLevel = level;
+			pyramidBarrier.subresourceRange.levelCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+
+			sourceSize = destinationSize;
+		}
+
+		//The whole pyramid is traversed by the reflection fragment shader
+		pyramidBarrier.subresourceRange.baseMipLevel = 0;
+		pyramidBarrier.subresourceRange.levelCount = pyramidLevels;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+	}
+
+	VkDescriptorImageInfo SsrDepthPyramidSystem::getPyramidImageInfo(int frameIndex) const
+	{
+		VkDescriptorImageInfo pyramidInfo{};
+		pyramidInfo.sampler = pyramidSampler;
+		pyramidInfo.imageView = depthPyramids[frameIndex].fullView;
+		pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return pyramidInfo;
+	}
+
+	void SsrDepthPyramidSystem::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
+	{
+		swapchain = newSwapchain;
+		retireDepthPyramids();
+		createDepthPyramids();
+		createPipelineRessources();
+	}
+}
@@ -0,0 +1,83 @@
+/*
+Closest depth pyramid (min Hi-Z) for the screen space reflections.
+Level 0 is a full resolution copy of the G-buffer depth and every other level keeps the closest depth of its footprint, so a
+ray in front of a texel of any level is in front of every surface under it. The reflection shader uses it to skip empty
+space in large steps and only walks the finest levels near the surfaces it may hit.
+Built in compute once the G-buffer is complete, read by the reflection pass of the same frame. Its memory comes from the
+transient attachment pool and lives from the G-buffer pass to the reflection pass.
+*/
+
+#pragma once
+
+#include "../vt_descriptors.hpp"
+#include "../vt_device.hpp"
+#include "../vt_pipeline.hpp"
+#include "../vt_swap_chain.hpp"
+#include "../vt_transient_attachment_pool.hpp"
+#include "../render_passes/gbuffer_pass.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace vt
+{
+	class SsrDepthPyramidSystem
+	{
+	public:
+		// Without render graph the G-buffer depth already exists and the descriptors are written right away
+		SsrDepthPyramidSystem(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool, std::shared_ptr<GBufferPass> gBufferPass);
+		~SsrDepthPyramidSystem();
+
+		SsrDepthPyramidSystem(const SsrDepthPyramidSystem&) = delete;
+		SsrDepthPyramidSystem& operator=(const SsrDepthPyramidSystem&) = delete;
+
+		// Reduce descriptors reading the G-buffer depth, render graph mode calls it once the graph is compiled
+		void createPipelineRessources();
+		// Must be recorded after the G-buffer pass has ended, the pyramid is then readable by fragment shaders in GENERAL layout
+		void buildPyramid(VkCommandBuffer commandBuffer, int frameIndex);
+
+		VkDescriptorImageInfo getPyramidImageInfo(int frameIndex) const;
+
+		// After the G-buffer pass (and the render graph) so the new depth view is read, before the reflection pass that samples the pyramid
+		void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
+
+	private:
+		struct DepthPyramid
+		{
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView fullView = VK_NULL_HANDLE;
+			std::vector<VkImageView> mipViews;
+			std::vector<VkDescriptorSet> reduceDescriptorSets;
+		};
+
+		void createDescriptorSetLayout();
+		void createPipeline();
+		void createDepthPyramids();
+		void cleanDepthPyramids();
+		// Same as cleanDepthPyramids for pyramids still used by frames in flight, on a resize
+		void retireDepthPyramids();
+
+		const std::string DEPTH_REDUCE_MIN_SHADER_PATH = "shaders/hiz_reduce_min.comp.spv";
+
+		VtDevice& vtDevice;
+		std::shared_ptr<VtSwapChain> swapchain;
+		VtTransientAttachmentPool& attachmentPool;
+		std::shared_ptr<GBufferPass> gBufferPass;
+
+		std::unique_ptr<VtDescriptorPool> pyramidDescriptorPool;
+		std::unique_ptr<VtDescriptorSetLayout> reduceSetLayout;
+
+		VkPipelineLayout reducePipelineLayout;
+		std::unique_ptr<VtComputePipeline> reducePipeline;
+
+		VkSampler pyramidSampler;
+		uint32_t pyramidLevels = 0;
+		std::vector<DepthPyramid> depthPyramids;
+	};
+}
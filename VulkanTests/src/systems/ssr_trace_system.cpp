@@ -0,0 +1,429 @@
+#include "ssr_trace_system.hpp"
+
+// std
+#include <array>
+#include <stdexcept>
+
+namespace vt
+{
+	struct SsrTracePushConstants
+	{
+		glm::mat4 previousViewProjection;
+		glm::ivec2 traceSize;
+		int32_t traceScale;
+		float historyWeight;
+		uint32_t historyValid;
+	};
+
+	SsrTraceSystem::SsrTraceSystem(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool, VkDescriptorSetLayout globalSetLayout,
+		std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass, std::shared_ptr<SsrDepthPyramidSystem> depthPyramid)
+		: vtDevice{ device }, swapchain{ swapchain }, attachmentPool{ attachmentPool }, gBufferPass{ gBufferPass }, lightingPass{ lightingPass }, depthPyramid{ depthPyramid }
+	{
+		createSamplers();
+		createDescriptorSetLayout();
+		createPipelines(globalSetLayout);
+		createImages();
+		createTileBuffers();
+		if (!gBufferPass->usesRenderGraph())
+		{
+			createPipelineRessources();
+		}
+	}
+
+	SsrTraceSystem::~SsrTraceSystem()
+	{
+		cleanImages();
+		vkDestroySampler(vtDevice.device(), screenSampler, nullptr);
+		vkDestroySampler(vtDevice.device(), historySampler, nullptr);
+		vkDestroyPipelineLayout(vtDevice.device(), pipelineLayout, nullptr);
+	}
+
+	void SsrTraceSystem::createSamplers()
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER; //A ray leaving the screen reads black and is not a hit
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = 0.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+		VK_CHECK_RESULT(vkCreateSampler(vtDevice.device(), &samplerInfo, nullptr, &screenSampler));
+
+		//The reprojected position falls anywhere between the history texels
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		VK_CHECK_RESULT(vkCreateSampler(vtDevice.device(), &samplerInfo, nullptr, &historySampler));
+	}
+
+	void SsrTraceSystem::createDescriptorSetLayout()
+	{
+		//Same first bindings as the textures of the reflection pass, the trace shares its code with ssr_shader.frag
+		traceSetLayout = VtDescriptorSetLayout::Builder(vtDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+
+		traceDescriptorPool = VtDescriptorPool::Builder(vtDevice)
+			.setMaxSets(vtDevice.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6 * vtDevice.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * vtDevice.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, vtDevice.getFramesInFlight())
+			.build();
+	}
+
+	void SsrTraceSystem::createPipelines(VkDescriptorSetLayout globalSetLayout)
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(SsrTracePushConstants);
+
+		std::array<VkDescriptorSetLayout, 2> layouts = { globalSetLayout, traceSetLayout->getDescriptorSetLayout() };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
+		pipelineLayoutInfo.pSetLayouts = layouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(vtDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		classifyPipeline = std::make_unique<VtComputePipeline>(vtDevice, CLASSIFY_SHADER_PATH, pipelineLayout);
+		tracePipeline = std::make_unique<VtComputePipeline>(vtDevice, TRACE_SHADER_PATH, pipelineLayout);
+		temporalPipeline = std::make_unique<VtComputePipeline>(vtDevice, TEMPORAL_SHADER_PATH, pipelineLayout);
+	}
+
+	void SsrTraceSystem::createImages()
+	{
+		//Largest trace, the half resolution one. Switching the resolution never reallocates
+		VkExtent2D extent = swapchain->getSwapChainExtent();
+		imageExtent = { (extent.width + 1) / 2, (extent.height + 1) / 2 };
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = REFLECTION_FORMAT;
+		imageInfo.extent.width = imageExtent.width;
+		imageInfo.extent.height = imageExtent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = REFLECTION_FORMAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		const uint32_t frameCount = vtDevice.getFramesInFlight();
+		traceImages.resize(frameCount);
+		traceImageViews.resize(frameCount);
+		historyAttachments.resize(frameCount);
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
+			//The raw trace only lives between the lighting and the reflection pass
+			traceImages[i] = attachmentPool.createImage(i, imageInfo, VtFramePass::Reflection, VtFramePass::Reflection);
+			viewInfo.image = traceImages[i];
+			VK_CHECK_RESULT(vkCreateImageView(vtDevice.device(), &viewInfo, nullptr, &traceImageViews[i]));
+
+			//The history is read again by the next frame, it can't share memory with anything
+			auto& history = historyAttachments[i];
+			history.format = REFLECTION_FORMAT;
+			vtDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, history.image, history.allocation);
+			viewInfo.image = history.image;
+			VK_CHECK_RESULT(vkCreateImageView(vtDevice.device(), &viewInfo, nullptr, &history.imageView));
+		}
+		accumulatedFrames = 0;
+	}
+
+	void SsrTraceSystem::cleanImages()
+	{
+		for (size_t i = 0; i < traceImages.size(); i++)
+		{
+			vkDestroyImageView(vtDevice.device(), traceImageViews[i], nullptr);
+			attachmentPool.destroyImage(traceImages[i]);
+			historyAttachments[i].cleanAttachment(vtDevice);
+		}
+		traceImages.clear();
+		traceImageViews.clear();
+		historyAttachments.clear();
+	}
+
+	void SsrTraceSystem::retireImages()
+	{
+		VkDevice device = vtDevice.device();
+		VtDeletionQueue& deletionQueue = vtDevice.getDeletionQueue();
+		for (size_t i = 0; i < traceImages.size(); i++)
+		{
+			VkImageView traceView = traceImageViews[i];
+			deletionQueue.retire([device, traceView]() { vkDestroyImageView(device, traceView, nullptr); });
+			attachmentPool.retireImage(traceImages[i]);
+			deletionQueue.retire([&vtDevice = vtDevice, history = historyAttachments[i]]() mutable { history.cleanAttachment(vtDevice); });
+		}
+		traceImages.clear();
+		traceImageViews.clear();
+		historyAttachments.clear();
+
+		for (auto& tileBuffer : tileBuffers)
+		{
+			deletionQueue.retire(std::move(tileBuffer));
+		}
+		tileBuffers.clear();
+	}
+
+	void SsrTraceSystem::createTileBuffers()
+	{
+		//Every tile of the largest trace may be glossy
+		uint32_t maxTileCount = ((imageExtent.width + TILE_SIZE - 1) / TILE_SIZE) * ((imageExtent.height + TILE_SIZE - 1) / TILE_SIZE);
+
+		tileBuffers.resize(vtDevice.getFramesInFlight());
+		for (int i = 0; i < vtDevice.getFramesInFlight(); i++)
+		{
+			tileBuffers[i] = std::make_unique<VtBuffer>(
+				vtDevice,
+				sizeof(uint32_t),
+				3 + maxTileCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	void SsrTraceSystem::createPipelineRessources()
+	{
+		//The lighting and G-buffer views change with the swapchain, the sets are written again from an empty pool. Frames
+		//in flight may still use the previous sets
+		traceDescriptorPool->retirePool();
+
+		const int frameCount = vtDevice.getFramesInFlight();
+		traceDescriptorSets.resize(frameCount);
+		for (int i = 0; i < frameCount; i++)
+		{
+			VkDescriptorImageInfo lightingImageInfo{};
+			lightingImageInfo.sampler = screenSampler;
+			lightingImageInfo.imageView = lightingPass->getLightingAttachment(i);
+			lightingImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo materialImageInfo{};
+			materialImageInfo.sampler = screenSampler;
+			materialImageInfo.imageView = gBufferPass->getMaterialAttachment(i);
+			materialImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo normalImageInfo{};
+			normalImageInfo.sampler = screenSampler;
+			normalImageInfo.imageView = gBufferPass->getNormalAttachment(i);
+			normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo depthImageInfo{};
+			depthImageInfo.sampler = screenSampler;
+			depthImageInfo.imageView = gBufferPass->getDepthAttachment(i);
+			depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkDescriptorImageInfo pyramidImageInfo = depthPyramid->getPyramidImageInfo(i);
+
+			VkDescriptorImageInfo traceImageInfo{};
+			traceImageInfo.imageView = traceImageViews[i];
+			traceImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			//Frames are recorded in order, the previous one used the previous frame index
+			VkDescriptorImageInfo previousHistoryInfo{};
+			previousHistoryInfo.sampler = historySampler;
+			previousHistoryInfo.imageView = historyAttachments[(i + frameCount - 1) % frameCount].imageView;
+			previousHistoryInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			VkDescriptorImageInfo historyInfo{};
+			historyInfo.imageView = historyAttachments[i].imageView;
+			historyInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			VkDescriptorBufferInfo tileBufferInfo = tileBuffers[i]->getDescriptorInfo();
+
+			VtDescriptorWriter(*traceSetLayout, *traceDescriptorPool)
+				.writeImage(0, &lightingImageInfo)
+				.writeImage(1, &materialImageInfo)
+				.writeImage(2, &normalImageInfo)
+				.writeImage(3, &depthImageInfo)
+				.writeImage(4, &pyramidImageInfo)
+				.writeImage(5, &traceImageInfo)
+				.writeImage(6, &previousHistoryInfo)
+				.writeImage(7, &historyInfo)
+				.writeBuffer(8, &tileBufferInfo)
+				.build(traceDescriptorSets[i]);
+		}
+	}
+
+	void SsrTraceSystem::trace(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet, const glm::mat4& viewProjection)
+	{
+		if (resolution == SsrResolution::Full)
+		{
+			//Coming back to a reduced resolution starts a new history
+			accumulatedFrames = 0;
+			return;
+		}
+
+		const int frameCount = vtDevice.getFramesInFlight();
+		VkImage history = historyAttachments[frameIndex].image;
+		VkImage previousHistory = historyAttachments[(frameIndex + frameCount - 1) % frameCount].image;
+		VkBuffer tileBuffer = tileBuffers[frameIndex]->getBuffer();
+
+		//Empty tile list, the classification counts the workgroups of the indirect dispatches
+		VkDispatchIndirectCommand emptyDispatch{ 0, 1, 1 };
+		vkCmdUpdateBuffer(commandBuffer, tileBuffer, 0, sizeof(VkDispatchIndirectCommand), &emptyDispatch);
+
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageBarrier.subresourceRange.baseMipLevel = 0;
+		imageBarrier.subresourceRange.levelCount = 1;
+		imageBarrier.subresourceRange.baseArrayLayer = 0;
+		imageBarrier.subresourceRange.layerCount = 1;
+
+		VkBufferMemoryBarrier tileBarrier{};
+		tileBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		tileBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		tileBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		tileBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		tileBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		tileBarrier.buffer = tileBuffer;
+		tileBarrier.offset = 0;
+		tileBarrier.size = VK_WHOLE_SIZE;
+
+		//The lighting writes are made visible here, the render graph already did it with its own barrier.
+		//The trace target and the history of this frame are fully rewritten so their previous content can be discarded,
+		//the history was last read by the reflection pass of an older frame.
+		//Without a valid history the previous one has never been written, it only needs a layout for its descriptor
+		VkMemoryBarrier lightingBarrier{};
+		lightingBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		lightingBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		lightingBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		imageBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		std::array<VkImageMemoryBarrier, 3> classifyBarriers{ imageBarrier, imageBarrier, imageBarrier };
+		classifyBarriers[0].image = traceImages[frameIndex];
+		classifyBarriers[1].image = history;
+		classifyBarriers[2].srcAccessMask = 0;
+		classifyBarriers[2].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		classifyBarriers[2].image = previousHistory;
+		//With a single frame in flight the previous history is the one being written, the reflections are not accumulated
+		bool historyValid = accumulatedFrames > 0 && frameCount > 1;
+		uint32_t classifyBarrierCount = historyValid || frameCount == 1 ? 2 : 3;
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &lightingBarrier, 1, &tileBarrier, classifyBarrierCount, classifyBarriers.data());
+
+		glm::ivec2 traceSize = getTraceSize();
+		SsrTracePushConstants push{};
+		push.previousViewProjection = previousViewProjection;
+		push.traceSize = traceSize;
+		push.traceScale = static_cast<int32_t>(getTraceScale());
+		push.historyWeight = historyWeight;
+		push.historyValid = historyValid ? 1 : 0;
+
+		std::array<VkDescriptorSet, 2> descriptorSets = { globalDescriptorSet, traceDescriptorSets[frameIndex] };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SsrTracePushConstants), &push);
+
+		//One workgroup per tile of the whole trace
+		classifyPipeline->bind(commandBuffer);
+		vkCmdDispatch(commandBuffer, (traceSize.x + TILE_SIZE - 1) / TILE_SIZE, (traceSize.y + TILE_SIZE - 1) / TILE_SIZE, 1);
+
+		//The tile list drives the next dispatches
+		tileBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		tileBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 1, &tileBarrier, 0, nullptr);
+
+		tracePipeline->bind(commandBuffer);
+		vkCmdDispatchIndirect(commandBuffer, tileBuffer, 0);
+
+		//The temporal pass reads the trace around its tiles, including the texels cleared by the classification
+		imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		imageBarrier.image = traceImages[frameIndex];
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		temporalPipeline->bind(commandBuffer);
+		vkCmdDispatchIndirect(commandBuffer, tileBuffer, 0);
+
+		//Upsampled by the reflection pass, reprojected by the temporal pass of the next frame
+		imageBarrier.image = history;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		previousViewProjection = viewProjection;
+		accumulatedFrames++;
+	}
+
+	void SsrTraceSystem::setResolution(SsrResolution newResolution)
+	{
+		if (newResolution != resolution)
+		{
+			resolution = newResolution;
+			accumulatedFrames = 0;
+		}
+	}
+
+	glm::ivec2 SsrTraceSystem::getTraceSize() const
+	{
+		VkExtent2D extent = swapchain->getSwapChainExtent();
+		uint32_t scale = getTraceScale();
+		return { (extent.width + scale - 1) / scale, (extent.height + scale - 1) / scale };
+	}
+
+	VkDescriptorImageInfo SsrTraceSystem::getReflectionImageInfo(int frameIndex) const
+	{
+		VkDescriptorImageInfo reflectionInfo{};
+		reflectionInfo.sampler = screenSampler;
+		reflectionInfo.imageView = historyAttachments[frameIndex].imageView;
+		reflectionInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return reflectionInfo;
+	}
+
+	void SsrTraceSystem::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
+	{
+		swapchain = newSwapchain;
+		VkExtent2D extent = swapchain->getSwapChainExtent();
+		VkExtent2D newImageExtent = { (extent.width + 1) / 2, (extent.height + 1) / 2 };
+		if (newImageExtent.width != imageExtent.width || newImageExtent.height != imageExtent.height)
+		{
+			retireImages();
+			createImages();
+			createTileBuffers();
+		}
+		//The lighting and G-buffer views may have changed
+		createPipelineRessources();
+	}
+}
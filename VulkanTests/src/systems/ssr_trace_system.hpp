@@ -0,0 +1,129 @@
+/*
+Reduced resolution screen space reflections.
+At half or quarter resolution one ray is traced per 2x2 or 4x4 block of pixels, in compute once the lighting is complete.
+The result is accumulated with the previous frames: the history is reprojected with the camera motion of the surface,
+clamped to the neighbourhood of the new trace so that disoccluded or moving reflections do not ghost, then blended in.
+The reflection pass upsamples the history with weights that follow the depth and the normal of the G-buffer, so the
+reflections keep the edges of the objects instead of the blocks of the trace.
+A classification pass first lists the 8x8 tiles of the trace holding a glossy surface. The trace and the temporal passes
+are then indirect dispatches over that list only, the other tiles are cleared by the classification itself. On scenes
+where few surfaces are glossy most of the screen costs a roughness fetch instead of a trace.
+At full resolution nothing is done here, the reflection pass traces every pixel itself.
+The trace targets come from the transient attachment pool, the histories have to survive from one frame to the next and
+are allocated on their own, one per frame in flight: a frame writes its own and reads the one of the previous frame.
+With a single frame in flight there is no previous history to read and the reflections are not accumulated.
+*/
+
+#pragma once
+
+#include "../vt_buffer.hpp"
+#include "../vt_descriptors.hpp"
+#include "../vt_device.hpp"
+#include "../vt_pipeline.hpp"
+#include "../vt_swap_chain.hpp"
+#include "../vt_transient_attachment_pool.hpp"
+#include "../render_passes/gbuffer_pass.hpp"
+#include "../render_passes/lighting_pass.hpp"
+#include "ssr_depth_pyramid_system.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace vt
+{
+	// Pixels per side of the block sharing one ray
+	enum class SsrResolution : uint32_t
+	{
+		Full = 1,
+		Half = 2,
+		Quarter = 4
+	};
+
+	class SsrTraceSystem
+	{
+	public:
+		// The global set layout must give compute access to the UBO (binding 0).
+		// Without render graph the lighting and G-buffer targets already exist and the descriptors are written right away
+		SsrTraceSystem(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool, VkDescriptorSetLayout globalSetLayout,
+			std::shared_ptr<GBufferPass> gBufferPass, std::shared_ptr<LightingPass> lightingPass, std::shared_ptr<SsrDepthPyramidSystem> depthPyramid);
+		~SsrTraceSystem();
+
+		SsrTraceSystem(const SsrTraceSystem&) = delete;
+		SsrTraceSystem& operator=(const SsrTraceSystem&) = delete;
+
+		// Descriptors reading the lighting and the G-buffer, render graph mode calls it once the graph is compiled
+		void createPipelineRessources();
+		// Must be recorded after the lighting pass has ended and before the reflection pass, which then reads the history of
+		// frameIndex. viewProjection is the one of this frame, the next frame reprojects its history with it
+		void trace(VkCommandBuffer commandBuffer, int frameIndex, VkDescriptorSet globalDescriptorSet, const glm::mat4& viewProjection);
+
+		// Changing the resolution drops the history, the new trace does not cover the same pixels
+		void setResolution(SsrResolution newResolution);
+		SsrResolution getResolution() const { return resolution; }
+		// Share of the reprojected history in the accumulated reflections, lower reacts faster but flickers more
+		void setHistoryWeight(float weight) { historyWeight = weight; }
+
+		uint32_t getTraceScale() const { return static_cast<uint32_t>(resolution); }
+		glm::ivec2 getTraceSize() const;
+		// Accumulated reflections of the frame, rgb is the color and alpha the share of hits. GENERAL layout
+		VkDescriptorImageInfo getReflectionImageInfo(int frameIndex) const;
+
+		// After the lighting pass and the depth pyramid so their new views are read, before the reflection pass that samples the history
+		void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
+
+	private:
+		void createSamplers();
+		void createDescriptorSetLayout();
+		void createPipelines(VkDescriptorSetLayout globalSetLayout);
+		void createImages();
+		void cleanImages();
+		// Same as cleanImages for images and tile lists still used by frames in flight, on a resize
+		void retireImages();
+		void createTileBuffers();
+
+		static constexpr uint32_t TILE_SIZE = 8; // trace texels per tile side, must match ssr_tiles.glsl
+
+		const std::string CLASSIFY_SHADER_PATH = "shaders/ssr_classify.comp.spv";
+		const std::string TRACE_SHADER_PATH = "shaders/ssr_trace.comp.spv";
+		const std::string TEMPORAL_SHADER_PATH = "shaders/ssr_temporal.comp.spv";
+		const VkFormat REFLECTION_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		VtDevice& vtDevice;
+		std::shared_ptr<VtSwapChain> swapchain;
+		VtTransientAttachmentPool& attachmentPool;
+		std::shared_ptr<GBufferPass> gBufferPass;
+		std::shared_ptr<LightingPass> lightingPass;
+		std::shared_ptr<SsrDepthPyramidSystem> depthPyramid;
+
+		std::unique_ptr<VtDescriptorPool> traceDescriptorPool;
+		std::unique_ptr<VtDescriptorSetLayout> traceSetLayout;
+		std::vector<VkDescriptorSet> traceDescriptorSets;
+
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<VtComputePipeline> classifyPipeline;
+		std::unique_ptr<VtComputePipeline> tracePipeline;
+		std::unique_ptr<VtComputePipeline> temporalPipeline;
+
+		VkSampler screenSampler; // black outside of the screen, like the sampler of the reflection pass
+		VkSampler historySampler;
+
+		// Sized for half resolution, quarter resolution only uses a corner of them
+		VkExtent2D imageExtent{};
+		std::vector<VkImage> traceImages;
+		std::vector<VkImageView> traceImageViews;
+		std::vector<VtRenderPassAttachment> historyAttachments;
+		// Dispatch command of the glossy tiles followed by their list, see ssr_tiles.glsl
+		std::vector<std::unique_ptr<VtBuffer>> tileBuffers;
+
+		SsrResolution resolution = SsrResolution::Half;
+		float historyWeight = 0.8f;
+		uint32_t accumulatedFrames = 0; // 0 when the previous history can't be reprojected
+		glm::mat4 previousViewProjection{ 1.f };
+	};
+}
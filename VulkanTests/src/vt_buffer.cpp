@@ -36,18 +36,21 @@ namespace vt {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     VtBuffer::~VtBuffer() {
         unmap();
         vkDestroyBuffer(vtDevice.device(), buffer, nullptr);
-        vkFreeMemory(vtDevice.device(), memory, nullptr);
+        vtDevice.getMemoryAllocator().free(allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note The buffer shares its device memory with other resources, the allocator maps the whole
+     * memory block once and size is only kept for compatibility
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -55,8 +58,13 @@ namespace vt {
      * @return VkResult of the buffer mapping call
      */
     VkResult VtBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(vtDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.memory && "Called map on buffer before create");
+        void* data = nullptr;
+        VkResult result = vtDevice.getMemoryAllocator().map(allocation, &data);
+        if (result == VK_SUCCESS) {
+            mapped = static_cast<char*>(data) + offset;
+        }
+        return result;
     }
 
     /**
@@ -66,7 +74,7 @@ namespace vt {
      */
     void VtBuffer::unmap() {
         if (mapped) {
-            vkUnmapMemory(vtDevice.device(), memory);
+            vtDevice.getMemoryAllocator().unmap(allocation);
             mapped = nullptr;
         }
     }
@@ -93,6 +101,24 @@ namespace vt {
         }
     }
 
+    /**
+     * Size of a mapped memory range starting at offset in the buffer
+     *
+     * @note VK_WHOLE_SIZE would reach the end of the shared memory block, the range is clamped to the
+     * end of the buffer rounded up to nonCoherentAtomSize, which stays inside the allocator's node
+     *
+     * @param size Size of the range, or VK_WHOLE_SIZE for the rest of the buffer
+     * @param offset Byte offset from beginning
+     *
+     * @return Size to use in a VkMappedMemoryRange
+     */
+    VkDeviceSize VtBuffer::getMappedRangeSize(VkDeviceSize size, VkDeviceSize offset) const {
+        if (size != VK_WHOLE_SIZE || allocation.block->isDedicated()) {
+            return size;
+        }
+        return getAlignment(bufferSize - offset, vtDevice.properties.limits.nonCoherentAtomSize);
+    }
+
     /**
      * Flush a memory range of the buffer to make it visible to the device
      *
@@ -107,9 +133,9 @@ namespace vt {
     VkResult VtBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = allocation.offset + offset;
+        mappedRange.size = getMappedRangeSize(size, offset);
         return vkFlushMappedMemoryRanges(vtDevice.device(), 1, &mappedRange);
     }
 
@@ -127,9 +153,9 @@ namespace vt {
     VkResult VtBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = allocation.offset + offset;
+        mappedRange.size = getMappedRangeSize(size, offset);
         return vkInvalidateMappedMemoryRanges(vtDevice.device(), 1, &mappedRange);
     }
 
@@ -0,0 +1,566 @@
+#include "vt_bvh.hpp"
+
+// libs
+#include <glm/gtc/matrix_transform.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+namespace vt
+{
+	namespace
+	{
+		constexpr uint32_t MAX_LEAF_ITEMS = 2;
+		constexpr int SAH_BIN_COUNT = 12;
+		// Query stacks are fixed size arrays, a node deeper than this is kept as a leaf
+		constexpr uint32_t MAX_DEPTH = 63;
+
+		VtAabb emptyBox()
+		{
+			VtAabb box{};
+			box.min = glm::vec3(std::numeric_limits<float>::max());
+			box.max = glm::vec3(-std::numeric_limits<float>::max());
+			return box;
+		}
+
+		void grow(VtAabb& box, const VtAabb& other)
+		{
+			box.min = glm::min(box.min, other.min);
+			box.max = glm::max(box.max, other.max);
+		}
+
+		float surfaceArea(const VtAabb& box)
+		{
+			glm::vec3 size = box.max - box.min;
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+
+		// Distance along the ray where it enters the box, infinity on a miss
+		float rayBoxDistance(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const VtAabb& box)
+		{
+			glm::vec3 t0 = (box.min - origin) * inverseDirection;
+			glm::vec3 t1 = (box.max - origin) * inverseDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+			float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+			float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+			return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+		}
+
+		bool sphereTouchesBox(const VtSphere& sphere, const VtAabb& box)
+		{
+			glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+			glm::vec3 offset = sphere.center - closest;
+			return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+		}
+
+		enum class FrustumTest
+		{
+			Outside,
+			Intersecting,
+			Inside
+		};
+
+		FrustumTest testFrustum(const VtFrustum& frustum, const VtAabb& box)
+		{
+			FrustumTest result = FrustumTest::Inside;
+			for (const auto& plane : frustum.planes)
+			{
+				//Corner furthest along the normal decides if the box is outside, the nearest one if it crosses the plane
+				glm::vec3 positive{ plane.x > 0.f ? box.max.x : box.min.x, plane.y > 0.f ? box.max.y : box.min.y, plane.z > 0.f ? box.max.z : box.min.z };
+				glm::vec3 negative{ plane.x > 0.f ? box.min.x : box.max.x, plane.y > 0.f ? box.min.y : box.max.y, plane.z > 0.f ? box.min.z : box.max.z };
+				if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.f)
+				{
+					return FrustumTest::Outside;
+				}
+				if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.f)
+				{
+					result = FrustumTest::Intersecting;
+				}
+			}
+			return result;
+		}
+	}
+
+	void VtBvh::build(const std::vector<VtAabb>& boxes)
+	{
+		const uint32_t count = static_cast<uint32_t>(boxes.size());
+		itemBoxes = boxes;
+		itemIndices.resize(count);
+		std::iota(itemIndices.begin(), itemIndices.end(), 0u);
+		nodes.clear();
+		if (count == 0) return;
+
+		std::vector<glm::vec3> centroids(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			centroids[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+		}
+
+		//A binary tree with single item leaves has 2n - 1 nodes, reserving keeps node references valid during the build
+		nodes.reserve(2 * static_cast<size_t>(count));
+		nodes.push_back({ emptyBox(), 0, count });
+		updateNodeBounds(0);
+		subdivide(0, centroids);
+	}
+
+	void VtBvh::refit(const std::vector<VtAabb>& boxes)
+	{
+		assert(boxes.size() == itemBoxes.size() && "refit needs the same boxes as build");
+		itemBoxes = boxes;
+
+		for (size_t i = nodes.size(); i-- > 0;)
+		{
+			Node& node = nodes[i];
+			if (node.itemCount > 0)
+			{
+				updateNodeBounds(static_cast<uint32_t>(i));
+			}
+			else
+			{
+				node.bounds = nodes[node.firstChildOrItem].bounds;
+				grow(node.bounds, nodes[node.firstChildOrItem + 1].bounds);
+			}
+		}
+	}
+
+	void VtBvh::updateNodeBounds(uint32_t nodeIndex)
+	{
+		Node& node = nodes[nodeIndex];
+		node.bounds = emptyBox();
+		for (uint32_t i = 0; i < node.itemCount; i++)
+		{
+			grow(node.bounds, itemBoxes[itemIndices[node.firstChildOrItem + i]]);
+		}
+	}
+
+	void VtBvh::subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centroids)
+	{
+		struct PendingNode
+		{
+			uint32_t index;
+			uint32_t depth;
+		};
+		std::vector<PendingNode> pending{ { nodeIndex, 0 } };
+
+		while (!pending.empty())
+		{
+			PendingNode current = pending.back();
+			pending.pop_back();
+
+			Node& node = nodes[current.index];
+			const uint32_t first = node.firstChildOrItem;
+			const uint32_t count = node.itemCount;
+			if (count <= MAX_LEAF_ITEMS || current.depth >= MAX_DEPTH) continue;
+
+			VtAabb centroidBounds = emptyBox();
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				centroidBounds.min = glm::min(centroidBounds.min, centroids[itemIndices[i]]);
+				centroidBounds.max = glm::max(centroidBounds.max, centroids[itemIndices[i]]);
+			}
+
+			//Binned SAH: cost of a split is the item count times the surface area on each side
+			float bestCost = std::numeric_limits<float>::max();
+			int bestAxis = -1;
+			int bestSplit = 0;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+				if (extent <= 0.f) continue;
+
+				VtAabb binBounds[SAH_BIN_COUNT];
+				uint32_t binCounts[SAH_BIN_COUNT] = {};
+				for (auto& bounds : binBounds)
+				{
+					bounds = emptyBox();
+				}
+
+				float scale = SAH_BIN_COUNT / extent;
+				for (uint32_t i = first; i < first + count; i++)
+				{
+					uint32_t item = itemIndices[i];
+					int bin = std::min(SAH_BIN_COUNT - 1, static_cast<int>((centroids[item][axis] - centroidBounds.min[axis]) * scale));
+					binCounts[bin]++;
+					grow(binBounds[bin], itemBoxes[item]);
+				}
+
+				float leftArea[SAH_BIN_COUNT - 1];
+				uint32_t leftCount[SAH_BIN_COUNT - 1];
+				VtAabb sweep = emptyBox();
+				uint32_t sweepCount = 0;
+				for (int i = 0; i < SAH_BIN_COUNT - 1; i++)
+				{
+					sweepCount += binCounts[i];
+					if (binCounts[i] > 0) grow(sweep, binBounds[i]);
+					leftCount[i] = sweepCount;
+					leftArea[i] = sweepCount > 0 ? surfaceArea(sweep) : 0.f;
+				}
+
+				sweep = emptyBox();
+				sweepCount = 0;
+				for (int i = SAH_BIN_COUNT - 1; i > 0; i--)
+				{
+					sweepCount += binCounts[i];
+					if (binCounts[i] > 0) grow(sweep, binBounds[i]);
+					float rightArea = sweepCount > 0 ? surfaceArea(sweep) : 0.f;
+					float cost = leftCount[i - 1] * leftArea[i - 1] + sweepCount * rightArea;
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = i - 1;
+					}
+				}
+			}
+
+			float leafCost = count * surfaceArea(node.bounds);
+			if (bestAxis < 0 || bestCost >= leafCost) continue;
+
+			float scale = SAH_BIN_COUNT / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+			auto middle = std::partition(itemIndices.begin() + first, itemIndices.begin() + first + count, [&](uint32_t item)
+				{
+					int bin = std::min(SAH_BIN_COUNT - 1, static_cast<int>((centroids[item][bestAxis] - centroidBounds.min[bestAxis]) * scale));
+					return bin <= bestSplit;
+				});
+			uint32_t leftItems = static_cast<uint32_t>(middle - (itemIndices.begin() + first));
+			if (leftItems == 0 || leftItems == count) continue;
+
+			uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+			node.firstChildOrItem = leftIndex;
+			node.itemCount = 0;
+			nodes.push_back({ emptyBox(), first, leftItems });
+			nodes.push_back({ emptyBox(), first + leftItems, count - leftItems });
+			updateNodeBounds(leftIndex);
+			updateNodeBounds(leftIndex + 1);
+
+			pending.push_back({ leftIndex, current.depth + 1 });
+			pending.push_back({ leftIndex + 1, current.depth + 1 });
+		}
+	}
+
+	VtRayHit VtBvh::raycast(const VtRay& ray) const
+	{
+		VtRayHit closest{};
+		if (nodes.empty()) return closest;
+
+		glm::vec3 inverseDirection = 1.f / ray.direction;
+		closest.distance = ray.maxDistance;
+
+		uint32_t stack[MAX_DEPTH + 2];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node = nodes[stack[--stackSize]];
+			if (rayBoxDistance(ray.origin, inverseDirection, closest.distance, node.bounds) > closest.distance) continue;
+
+			if (node.itemCount > 0)
+			{
+				for (uint32_t i = 0; i < node.itemCount; i++)
+				{
+					uint32_t item = itemIndices[node.firstChildOrItem + i];
+					float distance = rayBoxDistance(ray.origin, inverseDirection, closest.distance, itemBoxes[item]);
+					if (distance < closest.distance || (distance == closest.distance && !closest.hit()))
+					{
+						closest.itemIndex = item;
+						closest.distance = distance;
+					}
+				}
+				continue;
+			}
+
+			//Nearest child is pushed last so it is visited first and shrinks the search distance sooner
+			uint32_t nearChild = node.firstChildOrItem;
+			uint32_t farChild = node.firstChildOrItem + 1;
+			float nearDistance = rayBoxDistance(ray.origin, inverseDirection, closest.distance, nodes[nearChild].bounds);
+			float farDistance = rayBoxDistance(ray.origin, inverseDirection, closest.distance, nodes[farChild].bounds);
+			if (farDistance < nearDistance)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearDistance, farDistance);
+			}
+			if (farDistance <= closest.distance) stack[stackSize++] = farChild;
+			if (nearDistance <= closest.distance) stack[stackSize++] = nearChild;
+		}
+
+		if (!closest.hit())
+		{
+			closest.distance = std::numeric_limits<float>::max();
+		}
+		return closest;
+	}
+
+	void VtBvh::querySphere(const VtSphere& sphere, std::vector<uint32_t>& result) const
+	{
+		if (nodes.empty()) return;
+
+		uint32_t stack[MAX_DEPTH + 2];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node = nodes[stack[--stackSize]];
+			if (!sphereTouchesBox(sphere, node.bounds)) continue;
+
+			if (node.itemCount > 0)
+			{
+				for (uint32_t i = 0; i < node.itemCount; i++)
+				{
+					uint32_t item = itemIndices[node.firstChildOrItem + i];
+					if (sphereTouchesBox(sphere, itemBoxes[item]))
+					{
+						result.push_back(item);
+					}
+				}
+				continue;
+			}
+			stack[stackSize++] = node.firstChildOrItem;
+			stack[stackSize++] = node.firstChildOrItem + 1;
+		}
+	}
+
+	void VtBvh::queryFrustum(const VtFrustum& frustum, std::vector<uint32_t>& result) const
+	{
+		if (nodes.empty()) return;
+
+		//Lowest bit tells that the node is known to be fully inside, its subtree is then taken without tests
+		uint32_t stack[MAX_DEPTH + 2];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			uint32_t entry = stack[--stackSize];
+			const Node& node = nodes[entry >> 1];
+			bool inside = (entry & 1) != 0;
+			if (!inside)
+			{
+				FrustumTest test = testFrustum(frustum, node.bounds);
+				if (test == FrustumTest::Outside) continue;
+				inside = test == FrustumTest::Inside;
+			}
+
+			if (node.itemCount > 0)
+			{
+				for (uint32_t i = 0; i < node.itemCount; i++)
+				{
+					uint32_t item = itemIndices[node.firstChildOrItem + i];
+					if (inside || testFrustum(frustum, itemBoxes[item]) != FrustumTest::Outside)
+					{
+						result.push_back(item);
+					}
+				}
+				continue;
+			}
+			stack[stackSize++] = (node.firstChildOrItem << 1) | (inside ? 1u : 0u);
+			stack[stackSize++] = ((node.firstChildOrItem + 1) << 1) | (inside ? 1u : 0u);
+		}
+	}
+
+	void VtBvh::raycastBatch(const std::vector<VtRay>& rays, std::vector<VtRayHit>& hits, VtThreadPool& threadPool) const
+	{
+		hits.resize(rays.size());
+		threadPool.parallelFor(rays.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					hits[i] = raycast(rays[i]);
+				}
+			});
+	}
+
+	void VtBvh::querySphereBatch(const std::vector<VtSphere>& spheres, std::vector<std::vector<uint32_t>>& results, VtThreadPool& threadPool) const
+	{
+		results.resize(spheres.size());
+		threadPool.parallelFor(spheres.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					results[i].clear();
+					querySphere(spheres[i], results[i]);
+				}
+			});
+	}
+
+	void VtBvh::queryFrustumBatch(const std::vector<VtFrustum>& frustums, std::vector<std::vector<uint32_t>>& results, VtThreadPool& threadPool) const
+	{
+		results.resize(frustums.size());
+		threadPool.parallelFor(frustums.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					results[i].clear();
+					queryFrustum(frustums[i], results[i]);
+				}
+			});
+	}
+
+	void VtBvh::runBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto milliseconds = [](Clock::time_point start, Clock::time_point end) { return std::chrono::duration<double, std::milli>(end - start).count(); };
+
+		constexpr size_t QUERY_COUNT = 4096;
+		VtThreadPool threadPool{};
+
+		for (size_t boxCount : { 1'000, 10'000, 100'000 })
+		{
+			//World grows with the box count so that the density, and the work per query, stays comparable
+			float worldSize = 10.f * std::cbrt(static_cast<float>(boxCount));
+			std::mt19937 random{ 1234 };
+			std::uniform_real_distribution<float> position{ -worldSize * 0.5f, worldSize * 0.5f };
+			std::uniform_real_distribution<float> extent{ 0.1f, 2.f };
+			std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+
+			std::vector<VtAabb> boxes(boxCount);
+			for (auto& box : boxes)
+			{
+				glm::vec3 center{ position(random), position(random), position(random) };
+				glm::vec3 halfSize{ extent(random), extent(random), extent(random) };
+				box.min = center - halfSize;
+				box.max = center + halfSize;
+			}
+
+			std::vector<VtRay> rays(QUERY_COUNT);
+			std::vector<VtSphere> spheres(QUERY_COUNT);
+			for (size_t i = 0; i < QUERY_COUNT; i++)
+			{
+				rays[i].origin = { position(random), position(random), position(random) };
+				rays[i].direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(1e-4f));
+				spheres[i].center = { position(random), position(random), position(random) };
+				spheres[i].radius = 5.f;
+			}
+
+			std::vector<VtFrustum> frustums(QUERY_COUNT / 64);
+			glm::mat4 projection = glm::perspective(glm::radians(50.f), 16.f / 9.f, 0.1f, worldSize * 0.25f);
+			for (auto& frustum : frustums)
+			{
+				glm::vec3 eye{ position(random), position(random), position(random) };
+				glm::vec3 target = eye + glm::vec3(unit(random), unit(random), unit(random));
+				frustum = VtFrustum::fromMatrix(projection * glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f)));
+			}
+
+			VtBvh bvh{};
+			auto buildStart = Clock::now();
+			bvh.build(boxes);
+			auto buildEnd = Clock::now();
+
+			//Small jitter, like objects moving a bit between frames
+			std::vector<VtAabb> movedBoxes = boxes;
+			for (auto& box : movedBoxes)
+			{
+				glm::vec3 offset{ unit(random) * 0.1f, unit(random) * 0.1f, unit(random) * 0.1f };
+				box.min += offset;
+				box.max += offset;
+			}
+			auto refitStart = Clock::now();
+			bvh.refit(movedBoxes);
+			auto refitEnd = Clock::now();
+			bvh.refit(boxes);
+
+			//Rays
+			std::vector<VtRayHit> bvhHits(QUERY_COUNT);
+			auto start = Clock::now();
+			for (size_t i = 0; i < QUERY_COUNT; i++)
+			{
+				bvhHits[i] = bvh.raycast(rays[i]);
+			}
+			auto middle = Clock::now();
+			std::vector<VtRayHit> batchHits;
+			bvh.raycastBatch(rays, batchHits, threadPool);
+			auto batchEnd = Clock::now();
+
+			size_t rayMismatches = 0;
+			auto bruteStart = Clock::now();
+			for (size_t i = 0; i < QUERY_COUNT; i++)
+			{
+				glm::vec3 inverseDirection = 1.f / rays[i].direction;
+				float closest = std::numeric_limits<float>::infinity();
+				for (const auto& box : boxes)
+				{
+					closest = std::min(closest, rayBoxDistance(rays[i].origin, inverseDirection, rays[i].maxDistance, box));
+				}
+				bool bruteHit = closest != std::numeric_limits<float>::infinity();
+				if (bruteHit != bvhHits[i].hit() || (bruteHit && closest != bvhHits[i].distance) || batchHits[i].itemIndex != bvhHits[i].itemIndex)
+				{
+					rayMismatches++;
+				}
+			}
+			auto bruteEnd = Clock::now();
+
+			std::cout << "BVH " << boxCount << " boxes: build " << milliseconds(buildStart, buildEnd) << " ms, refit "
+				<< milliseconds(refitStart, refitEnd) << " ms, " << bvh.nodeCount() << " nodes" << std::endl;
+			std::cout << "  " << QUERY_COUNT << " rays: bvh " << milliseconds(start, middle) << " ms, bvh "
+				<< threadPool.getThreadCount() << " threads " << milliseconds(middle, batchEnd) << " ms, brute force "
+				<< milliseconds(bruteStart, bruteEnd) << " ms" << (rayMismatches == 0 ? "" : " MISMATCH") << std::endl;
+
+			//Spheres
+			std::vector<std::vector<uint32_t>> sphereResults(QUERY_COUNT);
+			start = Clock::now();
+			for (size_t i = 0; i < QUERY_COUNT; i++)
+			{
+				sphereResults[i].clear();
+				bvh.querySphere(spheres[i], sphereResults[i]);
+			}
+			middle = Clock::now();
+			std::vector<std::vector<uint32_t>> batchResults;
+			bvh.querySphereBatch(spheres, batchResults, threadPool);
+			batchEnd = Clock::now();
+
+			size_t sphereMismatches = 0;
+			bruteStart = Clock::now();
+			for (size_t i = 0; i < QUERY_COUNT; i++)
+			{
+				size_t bruteCount = 0;
+				for (const auto& box : boxes)
+				{
+					bruteCount += sphereTouchesBox(spheres[i], box) ? 1 : 0;
+				}
+				sphereMismatches += (bruteCount != sphereResults[i].size() || bruteCount != batchResults[i].size()) ? 1 : 0;
+			}
+			bruteEnd = Clock::now();
+
+			std::cout << "  " << QUERY_COUNT << " spheres: bvh " << milliseconds(start, middle) << " ms, bvh threaded "
+				<< milliseconds(middle, batchEnd) << " ms, brute force " << milliseconds(bruteStart, bruteEnd) << " ms"
+				<< (sphereMismatches == 0 ? "" : " MISMATCH") << std::endl;
+
+			//Frustums
+			std::vector<std::vector<uint32_t>> frustumResults(frustums.size());
+			start = Clock::now();
+			for (size_t i = 0; i < frustums.size(); i++)
+			{
+				frustumResults[i].clear();
+				bvh.queryFrustum(frustums[i], frustumResults[i]);
+			}
+			middle = Clock::now();
+			bvh.queryFrustumBatch(frustums, batchResults, threadPool);
+			batchEnd = Clock::now();
+
+			size_t frustumMismatches = 0;
+			bruteStart = Clock::now();
+			for (size_t i = 0; i < frustums.size(); i++)
+			{
+				size_t bruteCount = 0;
+				for (const auto& box : boxes)
+				{
+					bruteCount += testFrustum(frustums[i], box) != FrustumTest::Outside ? 1 : 0;
+				}
+				frustumMismatches += (bruteCount != frustumResults[i].size() || bruteCount != batchResults[i].size()) ? 1 : 0;
+			}
+			bruteEnd = Clock::now();
+
+			std::cout << "  " << frustums.size() << " frustums: bvh " << milliseconds(start, middle) << " ms, bvh threaded "
+				<< milliseconds(middle, batchEnd) << " ms, brute force " << milliseconds(bruteStart, bruteEnd) << " ms"
+				<< (frustumMismatches == 0 ? "" : " MISMATCH") << std::endl;
+		}
+	}
+}
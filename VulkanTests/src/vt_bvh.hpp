@@ -0,0 +1,87 @@
+/*
+Bounding volume hierarchy over axis aligned boxes (objects or model primitives).
+Built top down with a binned surface area heuristic, moving items only need a refit which keeps the topology.
+Queries return the indices of the boxes given to build(), batched versions spread the queries over a VtThreadPool.
+Like the frustum culler it has no Vulkan dependency.
+*/
+
+#pragma once
+
+#include "vt_frustum_culler.hpp"
+#include "vt_thread_pool.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace vt
+{
+	struct VtRay
+	{
+		glm::vec3 origin{ 0.f };
+		glm::vec3 direction{ 0.f, 0.f, 1.f };
+		float maxDistance = std::numeric_limits<float>::max();
+	};
+
+	struct VtRayHit
+	{
+		static constexpr uint32_t NO_HIT = std::numeric_limits<uint32_t>::max();
+
+		uint32_t itemIndex = NO_HIT;
+		float distance = std::numeric_limits<float>::max();
+
+		bool hit() const { return itemIndex != NO_HIT; }
+	};
+
+	struct VtSphere
+	{
+		glm::vec3 center{ 0.f };
+		float radius = 0.f;
+	};
+
+	class VtBvh
+	{
+	public:
+		void build(const std::vector<VtAabb>& boxes);
+		// Boxes must be given in the same order as in build(), the tree gets looser as items move away from where they were built
+		void refit(const std::vector<VtAabb>& boxes);
+
+		size_t itemCount() const { return itemBoxes.size(); }
+		size_t nodeCount() const { return nodes.size(); }
+
+		// Closest box hit by the ray, distance is where the ray enters the box (0 if it starts inside)
+		VtRayHit raycast(const VtRay& ray) const;
+		// Indices of the boxes touching the sphere / intersecting the frustum are appended to result
+		void querySphere(const VtSphere& sphere, std::vector<uint32_t>& result) const;
+		void queryFrustum(const VtFrustum& frustum, std::vector<uint32_t>& result) const;
+
+		void raycastBatch(const std::vector<VtRay>& rays, std::vector<VtRayHit>& hits, VtThreadPool& threadPool) const;
+		void querySphereBatch(const std::vector<VtSphere>& spheres, std::vector<std::vector<uint32_t>>& results, VtThreadPool& threadPool) const;
+		void queryFrustumBatch(const std::vector<VtFrustum>& frustums, std::vector<std::vector<uint32_t>>& results, VtThreadPool& threadPool) const;
+
+		// Times build, refit and queries against brute force on 1k, 10k and 100k random boxes and prints the results
+		static void runBenchmark();
+
+	private:
+		// Children of an inner node are stored next to each other after their parent, so a reverse walk visits children first
+		struct Node
+		{
+			VtAabb bounds;
+			uint32_t firstChildOrItem = 0; // index of the left child, or of the first item in itemIndices for leaves
+			uint32_t itemCount = 0; // 0 for inner nodes
+		};
+
+		void subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centroids);
+		void updateNodeBounds(uint32_t nodeIndex);
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> itemIndices;
+		std::vector<VtAabb> itemBoxes;
+	};
+}
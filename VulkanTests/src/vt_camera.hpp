@@ -5,6 +5,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "vt_frustum_culler.hpp"
+
 namespace vt
 {
 	class VtCamera
@@ -24,6 +26,7 @@ namespace vt
 		const glm::mat4& getInverseProjection() const { return inverseProjectionMatrix; }
 		const glm::mat4& getProjection() const { return projectionMatrix; }
 		const glm::mat4& getView() const { return viewMatrix; }
+		VtFrustum getFrustum() const { return VtFrustum::fromMatrix(projectionMatrix * viewMatrix); }
 
 		void setView(const glm::mat4& world_matrix);
 
@@ -0,0 +1,40 @@
+#include "vt_deletion_queue.hpp"
+
+namespace vt
+{
+	VtDeletionQueue::VtDeletionQueue(VtTimeline& timeline) : timeline{ timeline }
+	{
+	}
+
+	VtDeletionQueue::~VtDeletionQueue()
+	{
+		flush();
+	}
+
+	void VtDeletionQueue::retire(std::function<void()> destroy)
+	{
+		entries.push_back({ timeline.getRecordingFrame(), std::move(destroy) });
+	}
+
+	void VtDeletionQueue::collect()
+	{
+		//Entries are in retirement order, the first one still in use ends the release
+		while (!entries.empty() && timeline.isFrameComplete(entries.front().frameNumber))
+		{
+			//Popped first, destroying may retire other resources
+			std::function<void()> destroy = std::move(entries.front().destroy);
+			entries.pop_front();
+			destroy();
+		}
+	}
+
+	void VtDeletionQueue::flush()
+	{
+		while (!entries.empty())
+		{
+			std::function<void()> destroy = std::move(entries.front().destroy);
+			entries.pop_front();
+			destroy();
+		}
+	}
+}
@@ -0,0 +1,65 @@
+/*
+Deferred destruction of resources that frames in flight may still use, owned by VtDevice.
+Resizing replaces the screen sized resources while the previous frames are still executing: instead of waiting for the
+device to be idle, the old objects are handed to this queue with the number of the frame being recorded and destroyed
+once the timeline of the device shows that frame completed. The renderer collects the queue at the start of each frame.
+Only resources replaced at runtime go through it, destructors run after vkDeviceWaitIdle and destroy right away.
+*/
+
+#pragma once
+
+#include "vt_timeline.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace vt
+{
+	class VtDeletionQueue
+	{
+	public:
+		VtDeletionQueue(VtTimeline& timeline);
+		~VtDeletionQueue();
+
+		VtDeletionQueue(const VtDeletionQueue&) = delete;
+		VtDeletionQueue& operator=(const VtDeletionQueue&) = delete;
+
+		// destroy runs once the frame being recorded (or the next one between frames) has completed, and with it every
+		// frame before
+		void retire(std::function<void()> destroy);
+		// The object is destroyed with its last reference, kept here until the frames using it have completed
+		template<typename T>
+		void retire(std::unique_ptr<T> object)
+		{
+			if (!object) return;
+			std::shared_ptr<T> retired = std::move(object);
+			retire([retired]() {});
+		}
+		template<typename T>
+		void retire(std::shared_ptr<T> object)
+		{
+			if (!object) return;
+			retire([object]() {});
+		}
+
+		// Destroys what the completed frames were the last to use, never blocks
+		void collect();
+		// Destroys everything, the device must be idle
+		void flush();
+
+		size_t getPendingCount() const { return entries.size(); }
+
+	private:
+		struct Entry
+		{
+			uint64_t frameNumber; // last frame that may use the resource
+			std::function<void()> destroy;
+		};
+
+		VtTimeline& timeline;
+		std::deque<Entry> entries;
+	};
+}
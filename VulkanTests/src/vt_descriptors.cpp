@@ -95,7 +95,17 @@ namespace vt
         uint32_t maxSets,
         VkDescriptorPoolCreateFlags poolFlags,
         const std::vector<VkDescriptorPoolSize>& poolSizes)
-        : vtDevice{ vtDevice }
+        : vtDevice{ vtDevice }, maxSets{ maxSets }, poolFlags{ poolFlags }, poolSizes{ poolSizes }
+    {
+        createPool();
+    }
+
+    VtDescriptorPool::~VtDescriptorPool()
+    {
+        vkDestroyDescriptorPool(vtDevice.device(), descriptorPool, nullptr);
+    }
+
+    void VtDescriptorPool::createPool()
     {
         VkDescriptorPoolCreateInfo descriptorPoolInfo{};
         descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -111,11 +121,6 @@ namespace vt
         }
     }
 
-    VtDescriptorPool::~VtDescriptorPool()
-    {
-        vkDestroyDescriptorPool(vtDevice.device(), descriptorPool, nullptr);
-    }
-
     bool VtDescriptorPool::allocateDescriptorSet(
         const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const
     {
@@ -150,6 +155,14 @@ namespace vt
         vkResetDescriptorPool(vtDevice.device(), descriptorPool, 0);
     }
 
+    void VtDescriptorPool::retirePool()
+    {
+        VkDevice device = vtDevice.device();
+        VkDescriptorPool oldPool = descriptorPool;
+        vtDevice.getDeletionQueue().retire([device, oldPool]() { vkDestroyDescriptorPool(device, oldPool, nullptr); });
+        createPool();
+    }
+
     // *************** Descriptor Writer *********************
 
     VtDescriptorWriter::VtDescriptorWriter(VtDescriptorSetLayout& setLayout, VtDescriptorPool& pool)
@@ -80,10 +80,18 @@ namespace vt
         void freeDescriptors(std::vector<VkDescriptorSet>& descriptors) const;
 
         void resetPool();
+        // Same as resetPool for sets still bound by frames in flight: the old pool goes to the deletion queue of the
+        // device and an empty one with the same sizes takes its place
+        void retirePool();
 
     private:
+        void createPool();
+
         VtDevice& vtDevice;
         VkDescriptorPool descriptorPool;
+        uint32_t maxSets;
+        VkDescriptorPoolCreateFlags poolFlags;
+        std::vector<VkDescriptorPoolSize> poolSizes;
 
         friend class VtDescriptorWriter;
     };
@@ -55,19 +55,38 @@ namespace vt
     }
 
     // class member functions
-    VtDevice::VtDevice(VtWindow& window) : window{ window }
+    VtDevice::VtDevice(VtWindow& window, uint32_t framesInFlight) : window{ window }, framesInFlight{ framesInFlight }
     {
+        if (framesInFlight == 0 || framesInFlight > MAX_FRAMES_IN_FLIGHT)
+        {
+            throw std::runtime_error("frames in flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT) + "!");
+        }
+
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
-        createCommandPool();
+        createTimeline();
+        createSingleTimeCommandPool();
+        createMemoryAllocator();
+        createPipelineCache();
+        createPipelineCompiler();
     }
 
     VtDevice::~VtDevice()
     {
-        vkDestroyCommandPool(device_, commandPool, nullptr);
+        //Normally already flushed by the app once the device is idle
+        deletionQueue.reset();
+        timeline.reset();
+        vkDestroyCommandPool(device_, singleTimeCommandPool, nullptr);
+        //Waits for the last jobs, they merge into the pipeline cache
+        pipelineCompiler.reset();
+        shaderModuleCache.reset();
+        //Every pipeline of the run is in it by now
+        pipelineCache->save();
+        pipelineCache.reset();
+        memoryAllocator.reset();
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers)
@@ -102,6 +121,11 @@ namespace vt
         createInfo.pApplicationInfo = &appInfo;
 
         auto extensions = getRequiredExtensions();
+        if (isInstanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+        {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            physicalDeviceProperties2Enabled = true;
+        }
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -157,6 +181,36 @@ namespace vt
 
         vkGetPhysicalDeviceProperties(physicalDevice, &properties);
         std::cout << "physical device: " << properties.deviceName << std::endl;
+
+        memoryBudgetSupported = physicalDeviceProperties2Enabled &&
+            isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        std::cout << "memory budget: " << (memoryBudgetSupported ? "VK_EXT_memory_budget" : "estimated") << std::endl;
+
+        graphicsPipelineLibrarySupported = physicalDeviceProperties2Enabled &&
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+            isDeviceExtensionAvailable(physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        if (graphicsPipelineLibrarySupported)
+        {
+            //The extension can be listed without the feature
+            auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+                vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+            VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures{};
+            libraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            VkPhysicalDeviceFeatures2 features{};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &libraryFeatures;
+            if (getFeatures2 != nullptr)
+            {
+                getFeatures2(physicalDevice, &features);
+            }
+            graphicsPipelineLibrarySupported = libraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+        }
+        std::cout << "pipeline creation: " << (graphicsPipelineLibrarySupported ? "VK_EXT_graphics_pipeline_library" : "monolithic") << std::endl;
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        depthBoundsSupported = supportedFeatures.depthBounds == VK_TRUE;
+        std::cout << "depth bounds test: " << (depthBoundsSupported ? "supported" : "not supported") << std::endl;
     }
 
     // Describe what features of our device we want to use
@@ -214,16 +268,50 @@ namespace vt
             .pNext = &physical_device_raytracing_pipeline_features,
             .rayQuery = VK_TRUE };
 
-        VkPhysicalDeviceFeatures deviceFeatures = { .geometryShader = VK_TRUE, .samplerAnisotropy = VK_TRUE };
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT
+            physical_device_graphics_pipeline_library_features = {
+                .sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+                .pNext = &physical_device_ray_query_features,
+                .graphicsPipelineLibrary = VK_TRUE };
+
+        // Frame pacing, uploads and deferred deletions all wait on the timeline of the device
+        VkPhysicalDeviceTimelineSemaphoreFeatures physical_device_timeline_semaphore_features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+            .pNext = NULL,
+            .timelineSemaphore = VK_TRUE };
+
+        // The occlusion culling writes the object slot of each draw as the firstInstance of its indirect command
+        VkPhysicalDeviceFeatures deviceFeatures = {
+            .geometryShader = VK_TRUE,
+            .drawIndirectFirstInstance = VK_TRUE,
+            .depthBounds = depthBoundsSupported ? VK_TRUE : VK_FALSE,
+            .samplerAnisotropy = VK_TRUE };
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.pNext = &physical_device_ray_query_features;
+        if (graphicsPipelineLibrarySupported)
+        {
+            createInfo.pNext = &physical_device_graphics_pipeline_library_features;
+        }
+        physical_device_timeline_semaphore_features.pNext = const_cast<void*>(createInfo.pNext);
+        createInfo.pNext = &physical_device_timeline_semaphore_features;
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        if (memoryBudgetSupported)
+        {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+        if (graphicsPipelineLibrarySupported)
+        {
+            enabledExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -248,21 +336,56 @@ namespace vt
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
     }
 
+    void VtDevice::createTimeline()
+    {
+        timeline = std::make_unique<VtTimeline>(device_);
+        deletionQueue = std::make_unique<VtDeletionQueue>(*timeline);
+    }
+
+    void VtDevice::createMemoryAllocator()
+    {
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+        if (memoryBudgetSupported)
+        {
+            getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+                vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+        }
+        memoryAllocator = std::make_unique<VtMemoryAllocator>(device_, physicalDevice, getMemoryProperties2);
+    }
+
+    void VtDevice::createPipelineCache()
+    {
+        pipelineCache = std::make_unique<VtPipelineCache>(device_, properties, PIPELINE_CACHE_PATH);
+    }
+
+    void VtDevice::createPipelineCompiler()
+    {
+        shaderModuleCache = std::make_unique<VtShaderModuleCache>(device_);
+        pipelineCompiler = std::make_unique<VtPipelineCompiler>(device_, *pipelineCache, graphicsPipelineLibrarySupported);
+    }
+
     // Helps with command buffer allocation
-    void VtDevice::createCommandPool()
+    VkCommandPool VtDevice::createCommandPool(VkCommandPoolCreateFlags flags)
     {
         QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
         VkCommandPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-        poolInfo.flags =
-            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.flags = flags;
 
+        VkCommandPool commandPool;
         if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create command pool!");
         }
+        return commandPool;
+    }
+
+    void VtDevice::createSingleTimeCommandPool()
+    {
+        // No individual reset, buffers are reset together with the pool
+        singleTimeCommandPool = createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
     }
 
     // Create a surface (Relies on GLFW)
@@ -286,7 +409,7 @@ namespace vt
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
         return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-            supportedFeatures.samplerAnisotropy;
+            supportedFeatures.samplerAnisotropy && supportedFeatures.drawIndirectFirstInstance;
     }
 
     void VtDevice::populateDebugMessengerCreateInfo(
@@ -411,6 +534,40 @@ namespace vt
         return requiredExtensions.empty();
     }
 
+    bool VtDevice::isInstanceExtensionAvailable(const char* extensionName)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+        for (const auto& extension : extensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool VtDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+        for (const auto& extension : extensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     QueueFamilyIndices VtDevice::findQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -518,7 +675,7 @@ namespace vt
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory)
+        VtAllocation& bufferAllocation)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -534,29 +691,34 @@ namespace vt
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferAllocation = memoryAllocator->allocate(
+            memRequirements, properties, VtAllocationKind::Linear, VtMemoryAllocator::getBufferCategory(usage, properties));
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+        if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+            throw std::runtime_error("failed to bind buffer memory!");
         }
-
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
     }
 
     VkCommandBuffer VtDevice::beginSingleTimeCommands()
     {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
-
         VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        if (!freeSingleTimeCommandBuffers.empty())
+        {
+            commandBuffer = freeSingleTimeCommandBuffers.back();
+            freeSingleTimeCommandBuffers.pop_back();
+        }
+        else
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = singleTimeCommandPool;
+            allocInfo.commandBufferCount = 1;
+
+            vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        }
+        activeSingleTimeCommandBuffers++;
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -575,10 +737,22 @@ namespace vt
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // Only this submission is waited for, not the frames in flight. Its value being reached, every earlier
+        // submission has completed too
+        timeline->wait(timeline->submit(graphicsQueue_, submitInfo));
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        // Once nothing else is being recorded every buffer of the pool can be reset at once
+        submittedSingleTimeCommandBuffers.push_back(commandBuffer);
+        activeSingleTimeCommandBuffers--;
+        if (activeSingleTimeCommandBuffers == 0)
+        {
+            vkResetCommandPool(device_, singleTimeCommandPool, 0);
+            freeSingleTimeCommandBuffers.insert(
+                freeSingleTimeCommandBuffers.end(),
+                submittedSingleTimeCommandBuffers.begin(),
+                submittedSingleTimeCommandBuffers.end());
+            submittedSingleTimeCommandBuffers.clear();
+        }
     }
 
     void VtDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -626,7 +800,7 @@ namespace vt
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory)
+        VtAllocation& imageAllocation)
     {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
         {
@@ -636,17 +810,19 @@ namespace vt
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+        VtAllocationKind kind = VtAllocationKind::Optimal;
+        if (imageInfo.tiling == VK_IMAGE_TILING_LINEAR)
+        {
+            kind = VtAllocationKind::Linear;
+        }
+        else if (imageInfo.usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
         {
-            throw std::runtime_error("failed to allocate image memory!");
+            kind = VtAllocationKind::Dedicated;
         }
+        imageAllocation = memoryAllocator->allocate(
+            memRequirements, properties, kind, VtMemoryAllocator::getImageCategory(imageInfo.usage));
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+        if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to bind image memory!");
         }
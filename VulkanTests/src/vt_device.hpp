@@ -1,6 +1,12 @@
 #pragma once
 
 #include "vt_window.hpp"
+#include "vt_deletion_queue.hpp"
+#include "vt_memory_allocator.hpp"
+#include "vt_pipeline_cache.hpp"
+#include "vt_pipeline_compiler.hpp"
+#include "vt_shader_module_cache.hpp"
+#include "vt_timeline.hpp"
 #include <iostream>
 #include <assert.h>
 
@@ -16,6 +22,7 @@
 
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -48,7 +55,11 @@ namespace vt
         const bool enableValidationLayers = true;
 #endif
 
-        VtDevice(VtWindow& window);
+        // Upper bound of framesInFlight
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+        // framesInFlight sizes every per-frame resource of the application, it is fixed for the life of the device
+        VtDevice(VtWindow& window, uint32_t framesInFlight = 2);
         ~VtDevice();
 
         // Not copyable or movable
@@ -57,7 +68,6 @@ namespace vt
         VtDevice(VtDevice&&) = delete;
         VtDevice& operator=(VtDevice&&) = delete;
 
-        VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
@@ -70,25 +80,45 @@ namespace vt
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
         VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+        uint32_t getFramesInFlight() const { return framesInFlight; }
+        VtMemoryAllocator& getMemoryAllocator() { return *memoryAllocator; }
+        // Pass getPipelineCache().getCache() to every vkCreate*Pipelines call
+        VtPipelineCache& getPipelineCache() { return *pipelineCache; }
+        // VtPipeline and VtComputePipeline compile through it, wait for it before destroying what their jobs use
+        VtPipelineCompiler& getPipelineCompiler() { return *pipelineCompiler; }
+        VtShaderModuleCache& getShaderModuleCache() { return *shaderModuleCache; }
+        // Every submission to the graphics queue signals it, frames are paced on it
+        VtTimeline& getTimeline() { return *timeline; }
+        // Resources replaced while frames are in flight (resize), destroyed once those frames have completed
+        VtDeletionQueue& getDeletionQueue() { return *deletionQueue; }
+        bool isMemoryBudgetSupported() const { return memoryBudgetSupported; }
+        bool isGraphicsPipelineLibrarySupported() const { return graphicsPipelineLibrarySupported; }
+        bool isDepthBoundsSupported() const { return depthBoundsSupported; }
+
+        // Graphics queue family pool, owned by the caller
+        VkCommandPool createCommandPool(VkCommandPoolCreateFlags flags);
 
         // Buffer Helper Functions
+        // Memory is sub-allocated, release it with getMemoryAllocator().free() after destroying the resource
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            VtAllocation& bufferAllocation);
+        // One-shot commands (uploads, layout transitions) have their own pool, separate from the frame command buffers
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
         void copyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
+        // Attachment images large enough get a dedicated allocation
         void createImageWithInfo(
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            VtAllocation& imageAllocation);
 
         VkPhysicalDeviceProperties properties;
 
@@ -98,7 +128,8 @@ namespace vt
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
-        void createCommandPool();
+        void createSingleTimeCommandPool();
+        void createTimeline();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -108,19 +139,44 @@ namespace vt
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isInstanceExtensionAvailable(const char* extensionName);
+        bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
+        void createMemoryAllocator();
+        void createPipelineCache();
+        void createPipelineCompiler();
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         VtWindow& window;
-        VkCommandPool commandPool;
+        uint32_t framesInFlight;
+        VkCommandPool singleTimeCommandPool;
+        std::unique_ptr<VtMemoryAllocator> memoryAllocator;
+        std::unique_ptr<VtPipelineCache> pipelineCache;
+        std::unique_ptr<VtShaderModuleCache> shaderModuleCache;
+        std::unique_ptr<VtPipelineCompiler> pipelineCompiler;
+        std::unique_ptr<VtTimeline> timeline;
+        std::unique_ptr<VtDeletionQueue> deletionQueue;
+        // VK_EXT_memory_budget needs vkGetPhysicalDeviceMemoryProperties2, both are optional
+        bool physicalDeviceProperties2Enabled = false;
+        bool memoryBudgetSupported = false;
+        // VK_EXT_graphics_pipeline_library and VK_KHR_pipeline_library, optional as well
+        bool graphicsPipelineLibrarySupported = false;
+        // Optional feature, enabled when present: light volumes reject the pixels outside the depth range of their light
+        bool depthBoundsSupported = false;
+        // Buffers of the one-shot pool are recycled, the whole pool is reset once none of them is being recorded
+        std::vector<VkCommandBuffer> freeSingleTimeCommandBuffers;
+        std::vector<VkCommandBuffer> submittedSingleTimeCommandBuffers;
+        uint32_t activeSingleTimeCommandBuffers = 0;
 
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
 
+        // Relative to the working directory, like the shaders
+        const std::string PIPELINE_CACHE_PATH = "pipeline_cache.bin";
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> deviceExtensions = { 
             VK_KHR_SWAPCHAIN_EXTENSION_NAME,
@@ -132,7 +188,8 @@ namespace vt
             VK_KHR_RAY_QUERY_EXTENSION_NAME,
             VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
             VK_KHR_SPIRV_1_4_EXTENSION_NAME,
-            VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME
+            VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME,
+            VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME
         };
     };
 }
\ No newline at end of file
@@ -5,14 +5,14 @@
 
 namespace vt 
 {
-#define MAX_LIGHTS 10
-
+	// Element of the light storage buffer (std430)
 	struct PointLight
 	{
-		glm::vec4 position{};  // ignore w
+		glm::vec4 position{};  // world space, w is the range
 		glm::vec4 color{};     // w is intensity
 	};
 
+	// Per frame camera data, the lights live in their own storage buffer
 	struct GlobalUbo
 	{
 		glm::mat4 projection{ 1.f };
@@ -20,8 +20,16 @@ namespace vt
 		glm::mat4 inverseView{ 1.f };
 		glm::mat4 inverseProjection{ 1.f };
 		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f };  // w is intensity
-		PointLight pointLights[MAX_LIGHTS];
-		int numLights;
+		float nearPlane = 0.f;
+		float farPlane = 0.f;
+		uint32_t lightCount = 0;
+	};
+
+	// Per object data of the frame ring buffer, indexed by the draw's first instance
+	struct ObjectData
+	{
+		glm::mat4 modelMatrix{ 1.f };
+		glm::mat4 normalMatrix{ 1.f };
 	};
 
 	struct FrameInfo
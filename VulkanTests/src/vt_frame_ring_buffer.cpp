@@ -0,0 +1,56 @@
+#include "vt_frame_ring_buffer.hpp"
+#include "vt_swap_chain.hpp"
+
+// std
+#include <algorithm>
+
+namespace vt
+{
+	VtFrameRingBuffer::VtFrameRingBuffer(VtDevice& device, VkDeviceSize frameSize, VkBufferUsageFlags usageFlags) : frameSize{ frameSize }
+	{
+		//Partitions are bound and flushed on their own, so they start on both the descriptor offset and the non coherent atom alignments (all powers of two)
+		const auto& limits = device.properties.limits;
+		VkDeviceSize alignment = limits.nonCoherentAtomSize;
+		if (usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+		{
+			alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
+		}
+		if (usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		{
+			alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
+		}
+
+		buffer = std::make_unique<VtBuffer>(
+			device,
+			frameSize,
+			device.getFramesInFlight(),
+			usageFlags,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			alignment);
+		buffer->map();
+	}
+
+	void VtFrameRingBuffer::beginFrame(int frameIndex)
+	{
+		currentFrameIndex = frameIndex;
+		head = 0;
+	}
+
+	VtFrameRingBuffer::Allocation VtFrameRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+		if (offset + size > frameSize)
+		{
+			throw std::runtime_error("frame ring buffer is full!");
+		}
+		head = offset + size;
+
+		char* partition = static_cast<char*>(buffer->getMappedMemory()) + currentFrameIndex * buffer->getAlignmentSize();
+		return { offset, partition + offset };
+	}
+
+	void VtFrameRingBuffer::flush()
+	{
+		buffer->flushIndex(currentFrameIndex);
+	}
+}
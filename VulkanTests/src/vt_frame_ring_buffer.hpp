@@ -0,0 +1,56 @@
+/*
+Persistently mapped host visible buffer with one partition per frame in flight.
+Per frame data is sub-allocated linearly from the partition of the current frame, which is reused once the timeline has reached that frame.
+Each partition starts on the device offset alignment of the buffer usage so it can be bound on its own.
+*/
+
+#pragma once
+
+#include "vt_buffer.hpp"
+#include "vt_device.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+
+namespace vt
+{
+	class VtFrameRingBuffer
+	{
+	public:
+		struct Allocation
+		{
+			VkDeviceSize offset = 0; // from the start of the frame partition
+			void* data = nullptr;
+		};
+
+		VtFrameRingBuffer(VtDevice& device, VkDeviceSize frameSize, VkBufferUsageFlags usageFlags);
+
+		VtFrameRingBuffer(const VtFrameRingBuffer&) = delete;
+		VtFrameRingBuffer& operator=(const VtFrameRingBuffer&) = delete;
+
+		// Starts allocating from the partition of frameIndex, everything previously allocated in it is discarded
+		void beginFrame(int frameIndex);
+		Allocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+		// Typed version, the offset is aligned on sizeof(T) so firstIndex can index an array of T covering the partition
+		template<typename T>
+		T* allocateArray(uint32_t count, uint32_t& firstIndex)
+		{
+			Allocation allocation = allocate(sizeof(T) * count, sizeof(T));
+			firstIndex = static_cast<uint32_t>(allocation.offset / sizeof(T));
+			return static_cast<T*>(allocation.data);
+		}
+		// Makes this frame's writes visible to the device, the memory may not be coherent
+		void flush();
+
+		VkDescriptorBufferInfo getDescriptorInfo(int frameIndex) { return buffer->getDescriptorInfoForIndex(frameIndex); }
+		VkDeviceSize getFrameSize() const { return frameSize; }
+		VkDeviceSize getUsedSize() const { return head; }
+
+	private:
+		std::unique_ptr<VtBuffer> buffer;
+		VkDeviceSize frameSize;
+		int currentFrameIndex = 0;
+		VkDeviceSize head = 0;
+	};
+}
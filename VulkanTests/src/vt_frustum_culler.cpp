@@ -0,0 +1,290 @@
+#include "vt_frustum_culler.hpp"
+
+// libs
+#include <glm/gtc/matrix_transform.hpp>
+
+// std
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VT_CULL_SSE
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace vt
+{
+	namespace
+	{
+#if defined(VT_CULL_SSE)
+		bool cpuSupportsAvx2()
+		{
+			unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+			__cpuid(info, 1);
+			ecx = static_cast<unsigned int>(info[2]);
+#else
+			if (__get_cpuid_max(0, nullptr) < 7) return false;
+			__get_cpuid(1, &eax, &ebx, &ecx, &edx);
+#endif
+			//AVX needs OSXSAVE and the OS saving the xmm and ymm registers on context switches (XCR0 bits 1 and 2)
+			if ((ecx & (1u << 27)) == 0 || (ecx & (1u << 28)) == 0) return false;
+#if defined(_MSC_VER)
+			unsigned long long xcr0 = _xgetbv(0);
+#else
+			unsigned int xcr0Low = 0, xcr0High = 0;
+			__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+			unsigned long long xcr0 = xcr0Low;
+#endif
+			if ((xcr0 & 0x6) != 0x6) return false;
+
+#if defined(_MSC_VER)
+			__cpuidex(info, 7, 0);
+			ebx = static_cast<unsigned int>(info[1]);
+#else
+			__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+#endif
+			return (ebx & (1u << 5)) != 0;
+		}
+
+		const bool useAvx2 = cpuSupportsAvx2();
+#endif
+	}
+
+	VtAabb VtAabb::transformed(const glm::mat4& matrix) const
+	{
+		VtAabb result{};
+		for (int row = 0; row < 3; row++)
+		{
+			result.min[row] = matrix[3][row];
+			result.max[row] = matrix[3][row];
+			for (int col = 0; col < 3; col++)
+			{
+				float a = matrix[col][row] * min[col];
+				float b = matrix[col][row] * max[col];
+				result.min[row] += a < b ? a : b;
+				result.max[row] += a < b ? b : a;
+			}
+		}
+		return result;
+	}
+
+	VtFrustum VtFrustum::fromMatrix(const glm::mat4& m)
+	{
+		// Gribb/Hartmann extraction, glm matrices are column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+		auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+		VtFrustum frustum{};
+		frustum.planes[0] = row(3) + row(0);
+		frustum.planes[1] = row(3) - row(0);
+		frustum.planes[2] = row(3) + row(1);
+		frustum.planes[3] = row(3) - row(1);
+		frustum.planes[4] = row(2); // 0 <= z in Vulkan clip space
+		frustum.planes[5] = row(3) - row(2);
+
+		for (auto& plane : frustum.planes)
+		{
+			float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			plane = plane / length;
+		}
+		return frustum;
+	}
+
+	void VtFrustumCuller::clear()
+	{
+		minX.clear();
+		minY.clear();
+		minZ.clear();
+		maxX.clear();
+		maxY.clear();
+		maxZ.clear();
+	}
+
+	void VtFrustumCuller::reserve(size_t boxCount)
+	{
+		minX.reserve(boxCount);
+		minY.reserve(boxCount);
+		minZ.reserve(boxCount);
+		maxX.reserve(boxCount);
+		maxY.reserve(boxCount);
+		maxZ.reserve(boxCount);
+	}
+
+	uint32_t VtFrustumCuller::addBox(const glm::vec3& min, const glm::vec3& max)
+	{
+		minX.push_back(min.x);
+		minY.push_back(min.y);
+		minZ.push_back(min.z);
+		maxX.push_back(max.x);
+		maxY.push_back(max.y);
+		maxZ.push_back(max.z);
+		return static_cast<uint32_t>(minX.size() - 1);
+	}
+
+	size_t VtFrustumCuller::cull(const VtFrustum& frustum, std::vector<uint32_t>& visibleIndices) const
+	{
+		const size_t count = size();
+		visibleIndices.resize(count);
+		uint32_t* out = visibleIndices.data();
+		size_t visibleCount = 0;
+		size_t i = 0;
+
+#if defined(VT_CULL_SSE)
+		visibleCount = useAvx2 ? cullAvx2(frustum, i, out) : cullSse(frustum, i, out);
+#endif
+
+		// Remaining boxes that do not fill a whole SIMD register
+		visibleCount += cullRange(frustum, i, count, out + visibleCount);
+		visibleIndices.resize(visibleCount);
+		return visibleCount;
+	}
+
+#if defined(VT_CULL_SSE)
+	size_t VtFrustumCuller::cullSse(const VtFrustum& frustum, size_t& processed, uint32_t* out) const
+	{
+		const size_t count = size();
+		size_t visibleCount = 0;
+		size_t i = 0;
+
+		__m128 planeA[6], planeB[6], planeC[6], planeD[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeA[p] = _mm_set1_ps(frustum.planes[p].x);
+			planeB[p] = _mm_set1_ps(frustum.planes[p].y);
+			planeC[p] = _mm_set1_ps(frustum.planes[p].z);
+			planeD[p] = _mm_set1_ps(frustum.planes[p].w);
+		}
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x0 = _mm_loadu_ps(&minX[i]);
+			__m128 y0 = _mm_loadu_ps(&minY[i]);
+			__m128 z0 = _mm_loadu_ps(&minZ[i]);
+			__m128 x1 = _mm_loadu_ps(&maxX[i]);
+			__m128 y1 = _mm_loadu_ps(&maxY[i]);
+			__m128 z1 = _mm_loadu_ps(&maxZ[i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_max_ps(_mm_mul_ps(planeA[p], x0), _mm_mul_ps(planeA[p], x1));
+				distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(planeB[p], y0), _mm_mul_ps(planeB[p], y1)));
+				distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(planeC[p], z0), _mm_mul_ps(planeC[p], z1)));
+				distance = _mm_add_ps(distance, planeD[p]);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				out[visibleCount] = static_cast<uint32_t>(i + lane);
+				visibleCount += (mask >> lane) & 1;
+			}
+		}
+
+		processed = i;
+		return visibleCount;
+	}
+#endif
+
+	const char* VtFrustumCuller::simdKernelName()
+	{
+#if defined(VT_CULL_SSE)
+		return useAvx2 ? "AVX2" : "SSE";
+#else
+		return "scalar";
+#endif
+	}
+
+	size_t VtFrustumCuller::cullScalar(const VtFrustum& frustum, std::vector<uint32_t>& visibleIndices) const
+	{
+		visibleIndices.resize(size());
+		size_t visibleCount = cullRange(frustum, 0, size(), visibleIndices.data());
+		visibleIndices.resize(visibleCount);
+		return visibleCount;
+	}
+
+	size_t VtFrustumCuller::cullRange(const VtFrustum& frustum, size_t first, size_t last, uint32_t* out) const
+	{
+		size_t visibleCount = 0;
+		for (size_t i = first; i < last; i++)
+		{
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++)
+			{
+				const glm::vec4& plane = frustum.planes[p];
+				float distance = plane.w;
+				distance += plane.x > 0.f ? plane.x * maxX[i] : plane.x * minX[i];
+				distance += plane.y > 0.f ? plane.y * maxY[i] : plane.y * minY[i];
+				distance += plane.z > 0.f ? plane.z * maxZ[i] : plane.z * minZ[i];
+				inside = distance >= 0.f;
+			}
+			if (inside)
+			{
+				out[visibleCount++] = static_cast<uint32_t>(i);
+			}
+		}
+		return visibleCount;
+	}
+
+	void VtFrustumCuller::runBenchmark()
+	{
+		const char* simdName = simdKernelName();
+		std::cout << "Frustum culling kernel: " << simdName << std::endl;
+
+		// Camera at the origin looking down -z, boxes spread all around it so roughly a sixth is visible
+		glm::mat4 projection = glm::perspective(glm::radians(50.f), 16.f / 9.f, 0.1f, 1000.f);
+		VtFrustum frustum = VtFrustum::fromMatrix(projection);
+
+		std::mt19937 random{ 1234 };
+		std::uniform_real_distribution<float> position{ -500.f, 500.f };
+		std::uniform_real_distribution<float> extent{ 0.1f, 5.f };
+
+		std::vector<uint32_t> visible;
+		for (size_t boxCount : { 10'000, 100'000, 1'000'000 })
+		{
+			VtFrustumCuller culler{};
+			culler.reserve(boxCount);
+			for (size_t i = 0; i < boxCount; i++)
+			{
+				glm::vec3 center{ position(random), position(random), position(random) };
+				glm::vec3 halfSize{ extent(random), extent(random), extent(random) };
+				culler.addBox(center - halfSize, center + halfSize);
+			}
+
+			constexpr int iterations = 20;
+			size_t simdVisible = 0;
+			size_t scalarVisible = 0;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				simdVisible = culler.cull(frustum, visible);
+			}
+			auto middle = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				scalarVisible = culler.cullScalar(frustum, visible);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+
+			double simdMs = std::chrono::duration<double, std::milli>(middle - start).count() / iterations;
+			double scalarMs = std::chrono::duration<double, std::milli>(end - middle).count() / iterations;
+
+			std::cout << "Frustum culling " << boxCount << " boxes: "
+				<< simdName << " " << simdMs << " ms, scalar " << scalarMs << " ms ("
+				<< simdVisible << " visible" << (simdVisible == scalarVisible ? "" : ", MISMATCH") << ")" << std::endl;
+		}
+	}
+}
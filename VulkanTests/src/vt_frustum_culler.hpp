@@ -0,0 +1,72 @@
+/*
+Frustum culling of axis aligned bounding boxes.
+Boxes are kept in structure-of-arrays form so they can be tested 8 at a time (AVX2) or 4 at a time (SSE).
+The AVX2 kernel lives in vt_frustum_culler_avx2.cpp, the only file built with /arch:AVX2, and is picked at startup when
+cpuid reports AVX2 and the OS saves the ymm registers. Other x86 CPUs run the SSE kernel.
+The culler has no Vulkan dependency so it can be exercised on its own.
+*/
+
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace vt
+{
+	struct VtAabb
+	{
+		glm::vec3 min{ 0.f };
+		glm::vec3 max{ 0.f };
+
+		// Returns the box enclosing this box once transformed by the given matrix (Arvo's method)
+		VtAabb transformed(const glm::mat4& matrix) const;
+	};
+
+	struct VtFrustum
+	{
+		// xyz is the inward facing normal, w the distance. Order: left, right, bottom, top, near, far
+		glm::vec4 planes[6];
+
+		// Extracts the planes from a projection * view matrix using the Vulkan [0, 1] depth range
+		static VtFrustum fromMatrix(const glm::mat4& viewProjection);
+	};
+
+	class VtFrustumCuller
+	{
+	public:
+		void clear();
+		void reserve(size_t boxCount);
+		uint32_t addBox(const glm::vec3& min, const glm::vec3& max);
+		uint32_t addBox(const VtAabb& box) { return addBox(box.min, box.max); }
+		size_t size() const { return minX.size(); }
+
+		// Fills visibleIndices with the indices of the boxes intersecting the frustum, returns how many there are
+		size_t cull(const VtFrustum& frustum, std::vector<uint32_t>& visibleIndices) const;
+		// Reference implementation, one box at a time
+		size_t cullScalar(const VtFrustum& frustum, std::vector<uint32_t>& visibleIndices) const;
+
+		// Kernel cull() runs on this CPU: "AVX2", "SSE" or "scalar"
+		static const char* simdKernelName();
+		// Times the SIMD and scalar paths on 10k, 100k and 1M random boxes and prints the results
+		static void runBenchmark();
+
+	private:
+		// Test whole registers of boxes from the first one, processed is set to the first box left for cullRange
+		size_t cullAvx2(const VtFrustum& frustum, size_t& processed, uint32_t* out) const;
+		size_t cullSse(const VtFrustum& frustum, size_t& processed, uint32_t* out) const;
+		size_t cullRange(const VtFrustum& frustum, size_t first, size_t last, uint32_t* out) const;
+
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+	};
+}
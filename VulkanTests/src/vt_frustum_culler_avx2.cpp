@@ -0,0 +1,59 @@
+#include "vt_frustum_culler.hpp"
+
+//This file alone is built with /arch:AVX2, VtFrustumCuller::cull only calls into it once the CPU reported AVX2 support
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace vt
+{
+	size_t VtFrustumCuller::cullAvx2(const VtFrustum& frustum, size_t& processed, uint32_t* out) const
+	{
+		const size_t count = size();
+		size_t visibleCount = 0;
+		size_t i = 0;
+
+		__m256 planeA[6], planeB[6], planeC[6], planeD[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeA[p] = _mm256_set1_ps(frustum.planes[p].x);
+			planeB[p] = _mm256_set1_ps(frustum.planes[p].y);
+			planeC[p] = _mm256_set1_ps(frustum.planes[p].z);
+			planeD[p] = _mm256_set1_ps(frustum.planes[p].w);
+		}
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x0 = _mm256_loadu_ps(&minX[i]);
+			__m256 y0 = _mm256_loadu_ps(&minY[i]);
+			__m256 z0 = _mm256_loadu_ps(&minZ[i]);
+			__m256 x1 = _mm256_loadu_ps(&maxX[i]);
+			__m256 y1 = _mm256_loadu_ps(&maxY[i]);
+			__m256 z1 = _mm256_loadu_ps(&maxZ[i]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; p++)
+			{
+				// Distance of the corner furthest along the plane normal
+				__m256 distance = _mm256_max_ps(_mm256_mul_ps(planeA[p], x0), _mm256_mul_ps(planeA[p], x1));
+				distance = _mm256_add_ps(distance, _mm256_max_ps(_mm256_mul_ps(planeB[p], y0), _mm256_mul_ps(planeB[p], y1)));
+				distance = _mm256_add_ps(distance, _mm256_max_ps(_mm256_mul_ps(planeC[p], z0), _mm256_mul_ps(planeC[p], z1)));
+				distance = _mm256_add_ps(distance, planeD[p]);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(inside);
+			for (int lane = 0; lane < 8; lane++)
+			{
+				out[visibleCount] = static_cast<uint32_t>(i + lane);
+				visibleCount += (mask >> lane) & 1;
+			}
+		}
+
+		processed = i;
+		return visibleCount;
+	}
+}
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#error "vt_frustum_culler_avx2.cpp must be compiled with AVX2 enabled (/arch:AVX2)"
+#endif
@@ -64,13 +64,14 @@ namespace vt
         };
     }
 
-    VtGameObject VtGameObject::makePointLight(float intensity, float radius, glm::vec3 color)
+    VtGameObject VtGameObject::makePointLight(float intensity, float radius, glm::vec3 color, float range)
     {
         VtGameObject gameObj = VtGameObject::createGameObject();
         gameObj.color = color;
         gameObj.transform.scale.x = radius;
         gameObj.pointLight = std::make_unique<PointLightComponent>();
         gameObj.pointLight->lightIntensity = intensity;
+        gameObj.pointLight->range = range;
         return gameObj;
     }
 }
\ No newline at end of file
@@ -27,6 +27,7 @@ namespace vt {
 
 	struct PointLightComponent {
 		float lightIntensity = 1.0f;
+		float range = 10.0f; // no influence past this distance, lights are clustered by it
 	};
 
 	class VtGameObject {
@@ -40,7 +41,7 @@ namespace vt {
 		}
 
 		static VtGameObject makePointLight(
-			float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+			float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f), float range = 10.f);
 
 		VtGameObject(const VtGameObject&) = delete;
 		VtGameObject& operator=(const VtGameObject&) = delete;
@@ -0,0 +1,75 @@
+#include "vt_gpu_timer.hpp"
+#include "vt_swap_chain.hpp"
+
+namespace vt
+{
+	VtGpuTimer::VtGpuTimer(VtDevice& device, uint32_t timestampCount) : vtDevice{ device }, timestampCount{ timestampCount }
+	{
+		timestampPeriod = vtDevice.properties.limits.timestampPeriod;
+		supported = vtDevice.properties.limits.timestampComputeAndGraphics == VK_TRUE;
+		if (!supported)
+		{
+			std::cout << "Timestamp queries are not supported, GPU timings are disabled" << std::endl;
+			return;
+		}
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = timestampCount;
+
+		queryPools.resize(vtDevice.getFramesInFlight());
+		recordedFrames.resize(vtDevice.getFramesInFlight(), 0);
+		results.resize(timestampCount);
+		for (auto& queryPool : queryPools)
+		{
+			if (vkCreateQueryPool(vtDevice.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create timestamp query pool!");
+			}
+		}
+	}
+
+	VtGpuTimer::~VtGpuTimer()
+	{
+		for (auto queryPool : queryPools)
+		{
+			vkDestroyQueryPool(vtDevice.device(), queryPool, nullptr);
+		}
+	}
+
+	void VtGpuTimer::reset(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		if (!supported) return;
+
+		vkCmdResetQueryPool(commandBuffer, queryPools[frameIndex], 0, timestampCount);
+		recordedFrames[frameIndex] = vtDevice.getTimeline().getRecordingFrame();
+	}
+
+	void VtGpuTimer::writeTimestamp(VkCommandBuffer commandBuffer, int frameIndex, uint32_t timestampIndex, VkPipelineStageFlagBits stage)
+	{
+		if (!supported) return;
+
+		assert(timestampIndex < timestampCount && "timestampIndex out of range");
+		vkCmdWriteTimestamp(commandBuffer, stage, queryPools[frameIndex], timestampIndex);
+	}
+
+	float VtGpuTimer::getElapsedMilliseconds(int frameIndex, uint32_t beginIndex, uint32_t endIndex)
+	{
+		if (!supported || recordedFrames[frameIndex] == 0 || !vtDevice.getTimeline().isFrameComplete(recordedFrames[frameIndex])) return -1.f;
+
+		VkResult result = vkGetQueryPoolResults(
+			vtDevice.device(),
+			queryPools[frameIndex],
+			0,
+			timestampCount,
+			results.size() * sizeof(uint64_t),
+			results.data(),
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS) return -1.f;
+
+		//timestampPeriod is in nanoseconds per tick
+		return static_cast<float>(results[endIndex] - results[beginIndex]) * timestampPeriod * 1e-6f;
+	}
+}
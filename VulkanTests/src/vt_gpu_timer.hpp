@@ -0,0 +1,44 @@
+/*
+GPU timestamps, one query pool per frame in flight.
+Results are read back once the timeline of the device shows the frame that wrote them completed, so reading never stalls.
+*/
+
+#pragma once
+
+#include "vt_device.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace vt
+{
+	class VtGpuTimer
+	{
+	public:
+		VtGpuTimer(VtDevice& device, uint32_t timestampCount);
+		~VtGpuTimer();
+
+		VtGpuTimer(const VtGpuTimer&) = delete;
+		VtGpuTimer& operator=(const VtGpuTimer&) = delete;
+
+		bool isSupported() const { return supported; }
+
+		// Must be recorded outside of a render pass, before the first timestamp of the frame
+		void reset(VkCommandBuffer commandBuffer, int frameIndex);
+		void writeTimestamp(VkCommandBuffer commandBuffer, int frameIndex, uint32_t timestampIndex, VkPipelineStageFlagBits stage);
+
+		// Milliseconds between two timestamps of the previous submission of this frame index, negative when there is no result yet.
+		// Call after beginFrame and before reset
+		float getElapsedMilliseconds(int frameIndex, uint32_t beginIndex, uint32_t endIndex);
+
+	private:
+		VtDevice& vtDevice;
+		uint32_t timestampCount;
+		float timestampPeriod;
+		bool supported;
+		std::vector<VkQueryPool> queryPools;
+		std::vector<uint64_t> recordedFrames; // timeline frame number of the last recording per frame index, 0 if none
+		std::vector<uint64_t> results;
+	};
+}
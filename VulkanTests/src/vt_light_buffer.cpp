@@ -0,0 +1,138 @@
+#include "vt_light_buffer.hpp"
+#include "vt_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace vt
+{
+	VtLightBuffer::VtLightBuffer(VtDevice& device, uint32_t initialCapacity) : vtDevice{ device }
+	{
+		assert(initialCapacity > 0 && "Light buffer needs room for at least one light");
+
+		dirtySlots.resize(vtDevice.getFramesInFlight());
+		buffers.resize(vtDevice.getFramesInFlight());
+		capacities.resize(vtDevice.getFramesInFlight());
+		for (int i = 0; i < vtDevice.getFramesInFlight(); i++)
+		{
+			createBuffer(i, initialCapacity);
+		}
+	}
+
+	void VtLightBuffer::createBuffer(int frameIndex, uint32_t capacity)
+	{
+		buffers[frameIndex] = std::make_unique<VtBuffer>(
+			vtDevice,
+			sizeof(PointLight),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffers[frameIndex]->map();
+		capacities[frameIndex] = capacity;
+	}
+
+	uint32_t VtLightBuffer::addLight(const PointLight& light)
+	{
+		uint32_t slot = static_cast<uint32_t>(lights.size());
+		lights.push_back(light);
+		dirtyFrames.push_back(0);
+		markDirty(slot);
+		return slot;
+	}
+
+	void VtLightBuffer::updateLight(uint32_t slot, const PointLight& light)
+	{
+		assert(slot < lights.size() && "Light slot out of range");
+
+		lights[slot] = light;
+		markDirty(slot);
+	}
+
+	void VtLightBuffer::markDirty(uint32_t slot)
+	{
+		//Each copy remembers the slot once, however many times it changes before the copy is uploaded
+		for (int i = 0; i < vtDevice.getFramesInFlight(); i++)
+		{
+			uint32_t frameBit = 1u << i;
+			if ((dirtyFrames[slot] & frameBit) == 0)
+			{
+				dirtyFrames[slot] |= frameBit;
+				dirtySlots[i].push_back(slot);
+			}
+		}
+	}
+
+	bool VtLightBuffer::upload(int frameIndex)
+	{
+		uint32_t frameBit = 1u << frameIndex;
+		auto& slots = dirtySlots[frameIndex];
+
+		uint32_t lightCount = getLightCount();
+		if (lightCount > capacities[frameIndex])
+		{
+			//The previous copy of this frame is not used anymore, it is released right away
+			uint32_t capacity = capacities[frameIndex];
+			while (capacity < lightCount)
+			{
+				capacity *= 2;
+			}
+			createBuffer(frameIndex, capacity);
+
+			//A new copy starts empty, every light is written
+			buffers[frameIndex]->writeToBuffer(lights.data(), sizeof(PointLight) * lightCount);
+			for (uint32_t slot : slots)
+			{
+				dirtyFrames[slot] &= ~frameBit;
+			}
+			slots.clear();
+			buffers[frameIndex]->flush();
+			return true;
+		}
+
+		if (slots.empty()) return false;
+
+		//Only the dirty slots are flushed. A light is smaller than nonCoherentAtomSize, so each slot is rounded out to whole
+		//atoms and slots sharing or touching an atom are merged, in slot order, into one range
+		auto& buffer = *buffers[frameIndex];
+		const VkDeviceSize atomSize = vtDevice.properties.limits.nonCoherentAtomSize;
+		const VkDeviceSize stride = buffer.getAlignmentSize();
+		VkDeviceSize rangeBegin = 0;
+		VkDeviceSize rangeEnd = 0;
+
+		std::sort(slots.begin(), slots.end());
+		for (uint32_t slot : slots)
+		{
+			buffer.writeToIndex(&lights[slot], slot);
+			dirtyFrames[slot] &= ~frameBit;
+
+			VkDeviceSize begin = slot * stride / atomSize * atomSize;
+			VkDeviceSize end = ((slot + 1) * stride + atomSize - 1) / atomSize * atomSize;
+			if (rangeEnd > 0 && begin <= rangeEnd)
+			{
+				rangeEnd = std::max(rangeEnd, end);
+				continue;
+			}
+			if (rangeEnd > 0)
+			{
+				flushRange(buffer, rangeBegin, rangeEnd);
+			}
+			rangeBegin = begin;
+			rangeEnd = end;
+		}
+		flushRange(buffer, rangeBegin, rangeEnd);
+		slots.clear();
+		return false;
+	}
+
+	void VtLightBuffer::flushRange(VtBuffer& buffer, VkDeviceSize begin, VkDeviceSize end)
+	{
+		//The last atom can run past the buffer, VK_WHOLE_SIZE lets VtBuffer clamp it to the end of its memory
+		if (end >= buffer.getBufferSize())
+		{
+			buffer.flush(VK_WHOLE_SIZE, begin);
+			return;
+		}
+		buffer.flush(end - begin, begin);
+	}
+}
@@ -0,0 +1,55 @@
+/*
+Point lights of the scene in a host visible storage buffer, one copy per frame in flight.
+Lights are kept in a CPU array and only the ones changed since a frame's copy was last written are uploaded and flushed.
+A copy grows to the next power of two when the lights don't fit anymore, there is no fixed light limit.
+*/
+
+#pragma once
+
+#include "vt_buffer.hpp"
+#include "vt_device.hpp"
+#include "vt_frame_info.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vt
+{
+	class VtLightBuffer
+	{
+	public:
+		VtLightBuffer(VtDevice& device, uint32_t initialCapacity = 64);
+
+		VtLightBuffer(const VtLightBuffer&) = delete;
+		VtLightBuffer& operator=(const VtLightBuffer&) = delete;
+
+		// Returns the slot of the light, it indexes the lights array of the shaders
+		uint32_t addLight(const PointLight& light);
+		void updateLight(uint32_t slot, const PointLight& light);
+		const PointLight& getLight(uint32_t slot) const { return lights[slot]; }
+		uint32_t getLightCount() const { return static_cast<uint32_t>(lights.size()); }
+
+		// Writes the lights changed since the last upload of this frame index, its previous use must be over.
+		// Returns true when the copy of the frame was reallocated, its descriptor has to be written again
+		bool upload(int frameIndex);
+
+		VkDescriptorBufferInfo getDescriptorInfo(int frameIndex) { return buffers[frameIndex]->getDescriptorInfo(); }
+		uint32_t getCapacity(int frameIndex) const { return capacities[frameIndex]; }
+
+	private:
+		void markDirty(uint32_t slot);
+		void createBuffer(int frameIndex, uint32_t capacity);
+		// Flushes the atom aligned byte range [begin, end) of a copy
+		static void flushRange(VtBuffer& buffer, VkDeviceSize begin, VkDeviceSize end);
+
+		VtDevice& vtDevice;
+		std::vector<PointLight> lights;
+		std::vector<uint32_t> dirtyFrames; // bit per frame in flight whose copy misses the light
+		std::vector<std::vector<uint32_t>> dirtySlots; // per frame in flight
+
+		std::vector<std::unique_ptr<VtBuffer>> buffers;
+		std::vector<uint32_t> capacities;
+	};
+}
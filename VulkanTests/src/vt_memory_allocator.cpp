@@ -0,0 +1,571 @@
+#include "vt_memory_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <stdexcept>
+
+namespace vt
+{
+	namespace
+	{
+		double toMegabytes(VkDeviceSize bytes)
+		{
+			return static_cast<double>(bytes) / (1024.0 * 1024.0);
+		}
+	}
+
+	VtMemoryBlock::VtMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, bool dedicated)
+		: memory{ memory }, size{ size }, memoryTypeIndex{ memoryTypeIndex }, dedicated{ dedicated }
+	{
+		if (dedicated) return;
+
+		assert((size & (size - 1)) == 0 && size >= MIN_NODE_SIZE && "Block size must be a power of two");
+		uint32_t levelCount = 1;
+		while ((size >> levelCount) >= MIN_NODE_SIZE)
+		{
+			levelCount++;
+		}
+		freeNodes.resize(levelCount);
+		freeNodes[0].insert(0);
+	}
+
+	bool VtMemoryBlock::allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize& offset)
+	{
+		if (dedicated)
+		{
+			if (allocationCount > 0 || allocationSize > size) return false;
+			offset = 0;
+			allocatedNodes[0] = { 0, allocationSize };
+			allocationCount = 1;
+			usedSize = size;
+			requestedSize = allocationSize;
+			return true;
+		}
+
+		//Nodes are aligned on their own size, so the alignment only matters when it is larger than the allocation
+		VkDeviceSize needed = std::max({ allocationSize, alignment, MIN_NODE_SIZE });
+		if (needed > size) return false;
+
+		uint32_t targetLevel = 0;
+		while (targetLevel + 1 < freeNodes.size() && getNodeSize(targetLevel + 1) >= needed)
+		{
+			targetLevel++;
+		}
+
+		//Smallest free node that fits, split down to the target size
+		int level = static_cast<int>(targetLevel);
+		while (level >= 0 && freeNodes[level].empty())
+		{
+			level--;
+		}
+		if (level < 0) return false;
+
+		VkDeviceSize node = *freeNodes[level].begin();
+		freeNodes[level].erase(freeNodes[level].begin());
+		while (static_cast<uint32_t>(level) < targetLevel)
+		{
+			level++;
+			freeNodes[level].insert(node + getNodeSize(level));
+		}
+
+		offset = node;
+		allocatedNodes[node] = { targetLevel, allocationSize };
+		allocationCount++;
+		usedSize += getNodeSize(targetLevel);
+		requestedSize += allocationSize;
+		return true;
+	}
+
+	void VtMemoryBlock::free(VkDeviceSize offset)
+	{
+		auto it = allocatedNodes.find(offset);
+		assert(it != allocatedNodes.end() && "Freeing an offset that was not allocated from this block");
+		Node node = it->second;
+		allocatedNodes.erase(it);
+		allocationCount--;
+		requestedSize -= node.requestedSize;
+
+		if (dedicated)
+		{
+			usedSize = 0;
+			return;
+		}
+		usedSize -= getNodeSize(node.level);
+
+		//Merge with the buddy for as long as it is free
+		uint32_t level = node.level;
+		while (level > 0)
+		{
+			VkDeviceSize buddy = offset ^ getNodeSize(level);
+			auto buddyIt = freeNodes[level].find(buddy);
+			if (buddyIt == freeNodes[level].end()) break;
+
+			freeNodes[level].erase(buddyIt);
+			offset = std::min(offset, buddy);
+			level--;
+		}
+		freeNodes[level].insert(offset);
+	}
+
+	VtMemoryAllocator::VtMemoryAllocator(
+		VkDevice device,
+		VkPhysicalDevice physicalDevice,
+		PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2)
+		: device{ device }, physicalDevice{ physicalDevice }, getMemoryProperties2{ getMemoryProperties2 }
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		bufferImageGranularity = properties.limits.bufferImageGranularity;
+		nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+		heaps.resize(memoryProperties.memoryTypeCount);
+	}
+
+	VtMemoryAllocator::~VtMemoryAllocator()
+	{
+		for (auto& heap : heaps)
+		{
+			for (auto& blocks : heap.blocks)
+			{
+				for (auto& block : blocks)
+				{
+					freeBlockMemory(*block);
+				}
+			}
+		}
+		for (auto& block : dedicatedBlocks)
+		{
+			freeBlockMemory(*block);
+		}
+	}
+
+	VtAllocation VtMemoryAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		VkMemoryPropertyFlags properties,
+		VtAllocationKind kind,
+		VtMemoryCategory category)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+		VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+
+		VtMemoryBlock* block = nullptr;
+		VkDeviceSize offset = 0;
+
+		//Anything taking more than half a block would waste most of it once rounded up to a power of two
+		bool dedicated = requirements.size > blockSize / 2
+			|| (kind == VtAllocationKind::Dedicated && requirements.size >= DEDICATED_THRESHOLD);
+		if (dedicated)
+		{
+			dedicatedBlocks.push_back(createBlock(memoryTypeIndex, requirements.size, true));
+			block = dedicatedBlocks.back().get();
+			block->allocate(requirements.size, requirements.alignment, offset);
+		}
+		else
+		{
+			//Flushed and invalidated ranges must start on an atom, even for coherent memory, and must not straddle two allocations
+			VkDeviceSize alignment = requirements.alignment;
+			if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			{
+				alignment = std::max(alignment, nonCoherentAtomSize);
+			}
+
+			auto& blocks = heaps[memoryTypeIndex].blocks[getBlockList(kind)];
+			for (auto& candidate : blocks)
+			{
+				if (candidate->allocate(requirements.size, alignment, offset))
+				{
+					block = candidate.get();
+					break;
+				}
+			}
+
+			if (block == nullptr)
+			{
+				blocks.push_back(createBlock(memoryTypeIndex, blockSize, false));
+				block = blocks.back().get();
+				if (!block->allocate(requirements.size, alignment, offset))
+				{
+					throw std::runtime_error("failed to sub-allocate from a new memory block!");
+				}
+			}
+		}
+
+		VtAllocation allocation{};
+		allocation.memory = block->getMemory();
+		allocation.offset = offset;
+		allocation.size = requirements.size;
+		allocation.block = block;
+		allocation.category = category;
+
+		auto& categoryStat = categoryStats[static_cast<uint32_t>(category)];
+		categoryStat.allocationCount++;
+		categoryStat.bytes += requirements.size;
+		return allocation;
+	}
+
+	void VtMemoryAllocator::free(VtAllocation& allocation)
+	{
+		if (allocation.block == nullptr) return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto& categoryStat = categoryStats[static_cast<uint32_t>(allocation.category)];
+		categoryStat.allocationCount--;
+		categoryStat.bytes -= allocation.size;
+
+		VtMemoryBlock* block = allocation.block;
+		block->free(allocation.offset);
+		allocation = {};
+
+		if (!block->isEmpty()) return;
+
+		auto release = [&](std::vector<std::unique_ptr<VtMemoryBlock>>& blocks)
+			{
+				auto it = std::find_if(blocks.begin(), blocks.end(), [&](const auto& candidate) { return candidate.get() == block; });
+				if (it == blocks.end()) return false;
+
+				freeBlockMemory(**it);
+				blocks.erase(it);
+				return true;
+			};
+
+		if (block->isDedicated())
+		{
+			release(dedicatedBlocks);
+			return;
+		}
+
+		//One empty block per list is kept around so a resource recreated every frame does not hit vkAllocateMemory
+		for (auto& blocks : heaps[block->getMemoryTypeIndex()].blocks)
+		{
+			bool ownsBlock = std::any_of(blocks.begin(), blocks.end(), [&](const auto& candidate) { return candidate.get() == block; });
+			if (!ownsBlock) continue;
+
+			size_t emptyBlocks = std::count_if(blocks.begin(), blocks.end(), [](const auto& candidate) { return candidate->isEmpty(); });
+			if (emptyBlocks > 1)
+			{
+				release(blocks);
+			}
+			return;
+		}
+	}
+
+	VkResult VtMemoryAllocator::map(const VtAllocation& allocation, void** data)
+	{
+		assert(allocation.block != nullptr && "Mapping an empty allocation");
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VtMemoryBlock* block = allocation.block;
+		if (block->mapCount == 0)
+		{
+			VkResult result = vkMapMemory(device, block->getMemory(), 0, VK_WHOLE_SIZE, 0, &block->mappedData);
+			if (result != VK_SUCCESS) return result;
+		}
+		block->mapCount++;
+
+		*data = static_cast<char*>(block->mappedData) + allocation.offset;
+		return VK_SUCCESS;
+	}
+
+	void VtMemoryAllocator::unmap(const VtAllocation& allocation)
+	{
+		assert(allocation.block != nullptr && "Unmapping an empty allocation");
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VtMemoryBlock* block = allocation.block;
+		assert(block->mapCount > 0 && "Unmapping an allocation that is not mapped");
+		block->mapCount--;
+		if (block->mapCount == 0)
+		{
+			vkUnmapMemory(device, block->getMemory());
+			block->mappedData = nullptr;
+		}
+	}
+
+	uint32_t VtMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) &&
+				(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	bool VtMemoryAllocator::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) &&
+				(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	VtMemoryAllocator::Stats VtMemoryAllocator::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Stats stats{};
+		for (const auto& heap : heaps)
+		{
+			for (const auto& blocks : heap.blocks)
+			{
+				for (const auto& block : blocks)
+				{
+					addBlockStats(*block, stats);
+				}
+			}
+		}
+		for (const auto& block : dedicatedBlocks)
+		{
+			addBlockStats(*block, stats);
+		}
+		return stats;
+	}
+
+	VtMemoryAllocator::Stats VtMemoryAllocator::getStats(uint32_t memoryTypeIndex) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Stats stats{};
+		for (const auto& blocks : heaps[memoryTypeIndex].blocks)
+		{
+			for (const auto& block : blocks)
+			{
+				addBlockStats(*block, stats);
+			}
+		}
+		for (const auto& block : dedicatedBlocks)
+		{
+			if (block->getMemoryTypeIndex() == memoryTypeIndex)
+			{
+				addBlockStats(*block, stats);
+			}
+		}
+		return stats;
+	}
+
+	VtMemoryAllocator::CategoryStats VtMemoryAllocator::getCategoryStats(VtMemoryCategory category) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return categoryStats[static_cast<uint32_t>(category)];
+	}
+
+	std::vector<VtMemoryAllocator::HeapBudget> VtMemoryAllocator::getHeapBudgets() const
+	{
+		std::vector<HeapBudget> budgets(memoryProperties.memoryHeapCount);
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			budgets[i].size = memoryProperties.memoryHeaps[i].size;
+			budgets[i].deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		}
+
+		//The driver's numbers include other processes and memory not allocated through here
+		if (getMemoryProperties2 != nullptr)
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+			budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+			VkPhysicalDeviceMemoryProperties2 properties2{};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties2.pNext = &budgetProperties;
+			getMemoryProperties2(physicalDevice, &properties2);
+
+			for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+			{
+				budgets[i].usage = budgetProperties.heapUsage[i];
+				budgets[i].budget = budgetProperties.heapBudget[i];
+			}
+			return budgets;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto addUsage = [&](const VtMemoryBlock& block)
+			{
+				budgets[memoryProperties.memoryTypes[block.getMemoryTypeIndex()].heapIndex].usage += block.getSize();
+			};
+		for (const auto& heap : heaps)
+		{
+			for (const auto& blocks : heap.blocks)
+			{
+				for (const auto& block : blocks)
+				{
+					addUsage(*block);
+				}
+			}
+		}
+		for (const auto& block : dedicatedBlocks)
+		{
+			addUsage(*block);
+		}
+		for (auto& budget : budgets)
+		{
+			budget.budget = budget.size / 10 * 8;
+		}
+		return budgets;
+	}
+
+	void VtMemoryAllocator::printStats(std::ostream& stream) const
+	{
+		auto print = [&](const Stats& stats)
+			{
+				stream << "blocks " << stats.blockCount << " (" << toMegabytes(stats.blockBytes) << " MB)"
+					<< " | used " << toMegabytes(stats.usedBytes) << " MB (requested " << toMegabytes(stats.requestedBytes) << " MB)"
+					<< " | dedicated " << stats.dedicatedCount << " (" << toMegabytes(stats.dedicatedBytes) << " MB)"
+					<< " | allocations " << stats.allocationCount
+					<< " | device memory objects " << stats.blockCount + stats.dedicatedCount << std::endl;
+			};
+
+		std::ios_base::fmtflags flags = stream.flags();
+		stream << std::fixed << std::setprecision(2);
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			Stats stats = getStats(i);
+			if (stats.blockCount + stats.dedicatedCount == 0) continue;
+
+			stream << "Memory type " << i << " (heap " << memoryProperties.memoryTypes[i].heapIndex << "): ";
+			print(stats);
+		}
+		stream << "Total: ";
+		print(getStats());
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(VtMemoryCategory::Count); i++)
+		{
+			VtMemoryCategory category = static_cast<VtMemoryCategory>(i);
+			CategoryStats stats = getCategoryStats(category);
+			stream << "  " << getCategoryName(category) << ": " << toMegabytes(stats.bytes) << " MB in " << stats.allocationCount << " allocations" << std::endl;
+		}
+
+		auto budgets = getHeapBudgets();
+		for (uint32_t i = 0; i < budgets.size(); i++)
+		{
+			stream << "Heap " << i << (budgets[i].deviceLocal ? " (device local)" : "")
+				<< ": usage " << toMegabytes(budgets[i].usage) << " MB / budget " << toMegabytes(budgets[i].budget) << " MB"
+				<< " (heap " << toMegabytes(budgets[i].size) << " MB" << (hasDriverBudget() ? ")" : ", estimated)") << std::endl;
+		}
+		stream.flags(flags);
+	}
+
+	bool VtMemoryAllocator::warnIfNearBudget(std::ostream& stream, float threshold) const
+	{
+		bool nearBudget = false;
+		auto budgets = getHeapBudgets();
+		for (uint32_t i = 0; i < budgets.size(); i++)
+		{
+			if (budgets[i].budget == 0 || budgets[i].usage < static_cast<VkDeviceSize>(budgets[i].budget * threshold)) continue;
+
+			std::ios_base::fmtflags flags = stream.flags();
+			stream << std::fixed << std::setprecision(2)
+				<< "Warning: memory heap " << i << " is at " << toMegabytes(budgets[i].usage) << " MB of its "
+				<< toMegabytes(budgets[i].budget) << " MB budget" << std::endl;
+			stream.flags(flags);
+			nearBudget = true;
+		}
+		return nearBudget;
+	}
+
+	VtMemoryCategory VtMemoryAllocator::getBufferCategory(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+	{
+		if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) return VtMemoryCategory::Geometry;
+		if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return VtMemoryCategory::Uniform;
+		if ((usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) && (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) return VtMemoryCategory::Staging;
+		return VtMemoryCategory::Storage;
+	}
+
+	VtMemoryCategory VtMemoryAllocator::getImageCategory(VkImageUsageFlags usage)
+	{
+		//Storage images are screen sized intermediates (depth pyramid...), they are counted with the render targets
+		if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT))
+		{
+			return VtMemoryCategory::RenderTarget;
+		}
+		return VtMemoryCategory::Texture;
+	}
+
+	const char* VtMemoryAllocator::getCategoryName(VtMemoryCategory category)
+	{
+		switch (category)
+		{
+		case VtMemoryCategory::Texture: return "texture";
+		case VtMemoryCategory::Geometry: return "geometry";
+		case VtMemoryCategory::RenderTarget: return "render target";
+		case VtMemoryCategory::Uniform: return "uniform";
+		case VtMemoryCategory::Staging: return "staging";
+		case VtMemoryCategory::Storage: return "storage";
+		default: return "unknown";
+		}
+	}
+
+	std::unique_ptr<VtMemoryBlock> VtMemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate device memory block!");
+		}
+
+		return std::make_unique<VtMemoryBlock>(memory, size, memoryTypeIndex, dedicated);
+	}
+
+	void VtMemoryAllocator::freeBlockMemory(VtMemoryBlock& block)
+	{
+		//Freeing the memory implicitly unmaps it
+		vkFreeMemory(device, block.getMemory(), nullptr);
+		block.mappedData = nullptr;
+		block.mapCount = 0;
+	}
+
+	VkDeviceSize VtMemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) const
+	{
+		//Small heaps (host visible device local windows are often 256MB) get smaller blocks
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+		VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+		while (blockSize > heapSize / 8 && blockSize > 1024 * 1024)
+		{
+			blockSize /= 2;
+		}
+		return blockSize;
+	}
+
+	uint32_t VtMemoryAllocator::getBlockList(VtAllocationKind kind) const
+	{
+		if (bufferImageGranularity <= 1) return 0;
+		return kind == VtAllocationKind::Linear ? 0 : 1;
+	}
+
+	void VtMemoryAllocator::addBlockStats(const VtMemoryBlock& block, Stats& stats) const
+	{
+		stats.allocationCount += block.getAllocationCount();
+		if (block.isDedicated())
+		{
+			stats.dedicatedCount++;
+			stats.dedicatedBytes += block.getSize();
+			return;
+		}
+		stats.blockCount++;
+		stats.blockBytes += block.getSize();
+		stats.usedBytes += block.getUsedSize();
+		stats.requestedBytes += block.getRequestedSize();
+	}
+}
@@ -0,0 +1,207 @@
+/*
+Sub-allocating device memory allocator owned by VtDevice.
+Memory is reserved in large blocks per memory type and split with a buddy allocator, so a scene costs a handful of
+vkAllocateMemory calls instead of one per buffer and image.
+When bufferImageGranularity is larger than 1, linear resources (buffers) and optimal tiling images live in separate
+blocks so they can never share a granularity page.
+Large render targets get their own VkDeviceMemory, which hands the memory back to the driver as soon as a resize frees them.
+Host visible blocks are mapped once and stay mapped while at least one of their allocations is mapped.
+Every allocation is tagged with a category for capacity reports. Heap budgets come from VK_EXT_memory_budget when the
+device has it, otherwise usage is what this allocator holds on the heap and the budget 80% of the heap size.
+*/
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace vt
+{
+	class VtMemoryBlock;
+
+	enum class VtMemoryCategory : uint32_t
+	{
+		Texture,
+		Geometry,
+		RenderTarget,
+		Uniform,
+		Staging,
+		Storage, // storage, indirect and readback buffers
+		Count
+	};
+
+	struct VtAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0; // of the resource inside memory
+		VkDeviceSize size = 0;
+		VtMemoryBlock* block = nullptr;
+		VtMemoryCategory category = VtMemoryCategory::Storage;
+	};
+
+	enum class VtAllocationKind : uint32_t
+	{
+		Linear, // buffers and linear tiling images
+		Optimal, // optimal tiling images
+		Dedicated // optimal tiling images that should get their own memory when large enough (render targets)
+	};
+
+	// Buddy allocator over one VkDeviceMemory. A dedicated block holds exactly one allocation covering all of it
+	class VtMemoryBlock
+	{
+	public:
+		VtMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, bool dedicated);
+
+		VtMemoryBlock(const VtMemoryBlock&) = delete;
+		VtMemoryBlock& operator=(const VtMemoryBlock&) = delete;
+
+		// Returns false when no free node can hold size bytes at the requested power of two alignment
+		bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+		void free(VkDeviceSize offset);
+
+		VkDeviceMemory getMemory() const { return memory; }
+		VkDeviceSize getSize() const { return size; }
+		uint32_t getMemoryTypeIndex() const { return memoryTypeIndex; }
+		bool isDedicated() const { return dedicated; }
+		bool isEmpty() const { return allocationCount == 0; }
+		uint32_t getAllocationCount() const { return allocationCount; }
+		// Bytes of the nodes handed out, includes the rounding of each allocation to a power of two
+		VkDeviceSize getUsedSize() const { return usedSize; }
+		// Bytes actually asked for by the allocations
+		VkDeviceSize getRequestedSize() const { return requestedSize; }
+
+	private:
+		friend class VtMemoryAllocator;
+
+		static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+
+		struct Node
+		{
+			uint32_t level;
+			VkDeviceSize requestedSize;
+		};
+
+		VkDeviceSize getNodeSize(uint32_t level) const { return size >> level; }
+
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		uint32_t memoryTypeIndex;
+		bool dedicated;
+
+		// freeNodes[level] holds the offsets of the free nodes of size (size >> level), ordered so low offsets are reused first
+		std::vector<std::set<VkDeviceSize>> freeNodes;
+		std::unordered_map<VkDeviceSize, Node> allocatedNodes;
+		uint32_t allocationCount = 0;
+		VkDeviceSize usedSize = 0;
+		VkDeviceSize requestedSize = 0;
+
+		// Managed by the allocator, the whole block is mapped while mapCount > 0
+		void* mappedData = nullptr;
+		uint32_t mapCount = 0;
+	};
+
+	class VtMemoryAllocator
+	{
+	public:
+		struct Stats
+		{
+			uint32_t blockCount = 0;
+			uint32_t dedicatedCount = 0;
+			uint32_t allocationCount = 0;
+			VkDeviceSize blockBytes = 0; // reserved in blocks
+			VkDeviceSize usedBytes = 0; // handed out from blocks
+			VkDeviceSize requestedBytes = 0; // asked for by the resources living in blocks
+			VkDeviceSize dedicatedBytes = 0;
+		};
+
+		struct CategoryStats
+		{
+			uint32_t allocationCount = 0;
+			VkDeviceSize bytes = 0; // requested by the resources, without block rounding
+		};
+
+		struct HeapBudget
+		{
+			VkDeviceSize usage = 0;
+			VkDeviceSize budget = 0;
+			VkDeviceSize size = 0;
+			bool deviceLocal = false;
+		};
+
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+		// Render targets at least this big get a dedicated allocation (a 1080p RGBA16F target is about 16MB)
+		static constexpr VkDeviceSize DEDICATED_THRESHOLD = 8 * 1024 * 1024;
+		static constexpr float BUDGET_WARNING_THRESHOLD = 0.9f;
+
+		// getMemoryProperties2 is only given when VK_EXT_memory_budget is enabled
+		VtMemoryAllocator(
+			VkDevice device,
+			VkPhysicalDevice physicalDevice,
+			PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr);
+		~VtMemoryAllocator();
+
+		VtMemoryAllocator(const VtMemoryAllocator&) = delete;
+		VtMemoryAllocator& operator=(const VtMemoryAllocator&) = delete;
+
+		VtAllocation allocate(
+			const VkMemoryRequirements& requirements,
+			VkMemoryPropertyFlags properties,
+			VtAllocationKind kind,
+			VtMemoryCategory category);
+		void free(VtAllocation& allocation);
+
+		// data points to the start of the allocation, the block is mapped on first use
+		VkResult map(const VtAllocation& allocation, void** data);
+		void unmap(const VtAllocation& allocation);
+
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+		Stats getStats() const;
+		Stats getStats(uint32_t memoryTypeIndex) const;
+		CategoryStats getCategoryStats(VtMemoryCategory category) const;
+		// One entry per memory heap
+		std::vector<HeapBudget> getHeapBudgets() const;
+		bool hasDriverBudget() const { return getMemoryProperties2 != nullptr; }
+		void printStats(std::ostream& stream) const;
+		// Prints a warning for every heap above threshold of its budget, returns true if there was one
+		bool warnIfNearBudget(std::ostream& stream, float threshold = BUDGET_WARNING_THRESHOLD) const;
+
+		static VtMemoryCategory getBufferCategory(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+		static VtMemoryCategory getImageCategory(VkImageUsageFlags usage);
+		static const char* getCategoryName(VtMemoryCategory category);
+
+	private:
+		// Blocks of one memory type, split by kind when bufferImageGranularity requires it
+		struct Heap
+		{
+			std::vector<std::unique_ptr<VtMemoryBlock>> blocks[2];
+		};
+
+		std::unique_ptr<VtMemoryBlock> createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated);
+		void freeBlockMemory(VtMemoryBlock& block);
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+		uint32_t getBlockList(VtAllocationKind kind) const;
+		void addBlockStats(const VtMemoryBlock& block, Stats& stats) const;
+
+		VkDevice device;
+		VkPhysicalDevice physicalDevice;
+		PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize bufferImageGranularity;
+		VkDeviceSize nonCoherentAtomSize;
+
+		std::vector<Heap> heaps;
+		std::vector<std::unique_ptr<VtMemoryBlock>> dedicatedBlocks;
+		CategoryStats categoryStats[static_cast<uint32_t>(VtMemoryCategory::Count)];
+		mutable std::mutex mutex;
+	};
+}
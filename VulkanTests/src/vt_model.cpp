@@ -14,6 +14,7 @@
 #include <unordered_map>
 #include <filesystem>
 #include <iostream>
+#include <limits>
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -131,22 +132,39 @@ namespace vt
 
     void VtModel::draw(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet, VkPipelineLayout pipelineLayout)
     {
-        for (auto& primitive : primitives)
+        for (uint32_t i = 0; i < primitives.size(); i++)
         {
-            if (hasIndexBuffer)
-            {
-                std::vector<VkDescriptorSet> sets{ globalDescriptorSet, primitive.material.descriptor_set };
-                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
-                    sets.size(), sets.data(), 0, nullptr);
-                vkCmdDrawIndexed(commandBuffer, primitive.indexCount, 1, primitive.firstIndex, primitive.firstVertex, 0);
-            }
-            else
-            {
-                vkCmdDraw(commandBuffer, primitive.vertexCount, 1, 0, 0);
-            }
+            drawPrimitive(commandBuffer, i, globalDescriptorSet, pipelineLayout);
+        }
+    }
+
+    void VtModel::drawPrimitive(VkCommandBuffer commandBuffer, uint32_t primitiveIndex, VkDescriptorSet globalDescriptorSet, VkPipelineLayout pipelineLayout)
+    {
+        auto& primitive = primitives[primitiveIndex];
+        if (hasIndexBuffer)
+        {
+            std::vector<VkDescriptorSet> sets{ globalDescriptorSet, primitive.material.descriptor_set };
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
+                sets.size(), sets.data(), 0, nullptr);
+            vkCmdDrawIndexed(commandBuffer, primitive.indexCount, 1, primitive.firstIndex, primitive.firstVertex, 0);
+        }
+        else
+        {
+            vkCmdDraw(commandBuffer, primitive.vertexCount, 1, 0, 0);
         }
     }
 
+    void VtModel::drawPrimitiveIndirect(VkCommandBuffer commandBuffer, uint32_t primitiveIndex, VkDescriptorSet globalDescriptorSet, VkPipelineLayout pipelineLayout, VkBuffer indirectBuffer, VkDeviceSize offset)
+    {
+        assert(hasIndexBuffer && "Indirect drawing is only supported for indexed models");
+
+        auto& primitive = primitives[primitiveIndex];
+        std::vector<VkDescriptorSet> sets{ globalDescriptorSet, primitive.material.descriptor_set };
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
+            sets.size(), sets.data(), 0, nullptr);
+        vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+    }
+
     void VtModel::bind(VkCommandBuffer commandBuffer)
     {
         VkBuffer buffers[] = { vertexBuffer->getBuffer() };
@@ -192,6 +210,7 @@ namespace vt
         }
 
         auto path = std::filesystem::path{ filepath };
+        std::unordered_map<int, PBRMaterial> materialCache;
         int i = 0;
         for (auto& image : GltfModel.images)
         {
@@ -245,10 +264,13 @@ namespace vt
                         tangentsBuffer = reinterpret_cast<const float*>(&(GltfModel.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
                     }
 
+                    VtAabb bounds{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
                     for (size_t i = 0; i < vertexCount; i++)
                     {
                         Vertex vertex{};
                         vertex.position = glm::make_vec3(&positionBuffer[i * 3]);
+                        bounds.min = glm::min(bounds.min, vertex.position);
+                        bounds.max = glm::max(bounds.max, vertex.position);
                         vertex.normal = glm::normalize(
                             glm::vec3(normalsBuffer ? glm::make_vec3(&normalsBuffer[i * 3]) : glm::vec3(0.0f)));
                         vertex.tangent = glm::vec4(
@@ -295,143 +317,20 @@ namespace vt
                         return;
                     }
 
-                    std::shared_ptr<Texture> defaultTexture = std::make_shared<Texture>(vtDevice, "textures/white.png", true);
-                    std::shared_ptr<Texture> defaultNormalTexture = std::make_shared<Texture>(vtDevice, "textures/normal.png", false);
-                    std::shared_ptr<Texture> defaultMetallicRoughnessTexture = std::make_shared<Texture>(vtDevice, "textures/metallicRoughness.png", false);
-
-                    PBRMaterial material = {};
-                    if (GltfPrimitive.material != -1)
-                    {
-                        tinygltf::Material& primitiveMaterial = GltfModel.materials[GltfPrimitive.material];
-                        if (primitiveMaterial.pbrMetallicRoughness.baseColorTexture.index != -1)
-                        {
-                            uint32_t textureIndex = primitiveMaterial.pbrMetallicRoughness.baseColorTexture.index;  // Get the texture index
-                            uint32_t imageIndex = GltfModel.textures[textureIndex].source;                          // Get the image index
-                            material.base_color_texture = images[imageIndex];                                       // Set Base Color Texture
-                            material.pbr_parameters.has_base_color_texture = 1;                                     // Set Has_Base_Color Parameter
-                        }
-                        else
-                        {
-                            material.base_color_texture = defaultTexture;
-                            material.pbr_parameters.has_base_color_texture = 0;
-                            auto color = primitiveMaterial.pbrMetallicRoughness.baseColorFactor;
-                            material.pbr_parameters.base_color_factor = { color[0], color[1], color[2], color[3] };
-                        }
-
-                        if (primitiveMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index != -1)
-                        {
-                            uint32_t textureIndex = primitiveMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index;  // Get the texture index
-                            uint32_t imageIndex = GltfModel.textures[textureIndex].source;                                  // Get the image index
-                            material.metallic_roughness_texture = images[imageIndex];                                       // Set Base Color Texture
-                            material.pbr_parameters.has_metallic_roughness_texture = 1;                                     // Set Has_Base_Color Parameter
-                        }
-                        else
-                        {
-                            material.metallic_roughness_texture = defaultMetallicRoughnessTexture;
-                            material.pbr_parameters.has_metallic_roughness_texture = 0;
-                            material.pbr_parameters.metallic_factor = primitiveMaterial.pbrMetallicRoughness.metallicFactor;
-                            material.pbr_parameters.roughness_factor = primitiveMaterial.pbrMetallicRoughness.roughnessFactor;
-                        }
-
-                        if (primitiveMaterial.normalTexture.index != -1)
-                        {
-                            uint32_t textureIndex = primitiveMaterial.normalTexture.index;
-                            uint32_t imageIndex = GltfModel.textures[textureIndex].source;
-                            material.normal_texture = images[imageIndex];
-                            material.pbr_parameters.has_normal_texture = 1;
-                            material.pbr_parameters.scale = primitiveMaterial.normalTexture.scale;
-                        }
-                        else
-                        {
-                            material.normal_texture = defaultNormalTexture;
-                            material.pbr_parameters.has_normal_texture = 0;
-                        }
-
-                        if (primitiveMaterial.occlusionTexture.index != -1)
-                        {
-                            uint32_t textureIndex = primitiveMaterial.occlusionTexture.index;
-                            uint32_t imageIndex = GltfModel.textures[textureIndex].source;
-                            material.occlusion_texture = images[imageIndex];
-                            material.pbr_parameters.has_occlusion_texture = 1;
-                            material.pbr_parameters.strength = primitiveMaterial.occlusionTexture.strength;
-                        }
-                        else
-                        {
-                            material.occlusion_texture = defaultTexture;
-                            material.pbr_parameters.has_occlusion_texture = 0;
-                            material.pbr_parameters.strength = primitiveMaterial.occlusionTexture.strength;
-                        }
-
-                        if (primitiveMaterial.emissiveTexture.index != -1)
-                        {
-                            uint32_t textureIndex = primitiveMaterial.emissiveTexture.index;
-                            uint32_t imageIndex = GltfModel.textures[textureIndex].source;
-                            material.emissive_texture = images[imageIndex];
-                            material.pbr_parameters.has_emissive_texture = 1;
-                        }
-                        else
-                        {
-                            material.emissive_texture = defaultTexture;
-                            material.pbr_parameters.has_emissive_texture = 0;
-                            auto color = primitiveMaterial.emissiveFactor;
-                            material.pbr_parameters.emissive_factor = { color[0], color[1], color[2] };
-                        }
-
-                        material.pbr_parameters.alpha_cut_off = primitiveMaterial.alphaCutoff;
-                        material.pbr_parameters.alpha_mode = 0.f; // static_cast<float>(std::stof(primitiveMaterial.alphaMode));
-                    }
-                    else
+                    //Primitives using the same glTF material share its descriptor set, so binds can be skipped between them
+                    auto cachedMaterial = materialCache.find(GltfPrimitive.material);
+                    if (cachedMaterial == materialCache.end())
                     {
-                        material.base_color_texture = defaultTexture;
-                        material.metallic_roughness_texture = defaultMetallicRoughnessTexture;
-                        material.normal_texture = defaultNormalTexture;
-                        material.occlusion_texture = defaultTexture;
-                        material.emissive_texture = defaultTexture;
+                        cachedMaterial = materialCache.emplace(GltfPrimitive.material, createMaterial(GltfModel, GltfPrimitive.material, materialSetLayout, descriptorPool)).first;
                     }
 
-                    VtBuffer stagingBuffer{
-                        vtDevice,
-                        sizeof(PBRParameters),
-                        1,
-                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-                    };
-
-                    stagingBuffer.map();
-                    stagingBuffer.writeToBuffer(&material.pbr_parameters);
-
-                    material.pbr_parameters_buffer = std::make_unique<VtBuffer>(
-                        vtDevice,
-                        sizeof(PBRParameters),
-                        1,
-                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-                        );
-
-                    vtDevice.copyBuffer(stagingBuffer.getBuffer(), material.pbr_parameters_buffer->getBuffer(), sizeof(PBRParameters));
-
-                    VkDescriptorImageInfo baseColorImageInfo = material.base_color_texture->getDescriptorImageInfo();
-                    VkDescriptorImageInfo metallicRoughnessImageInfo = material.metallic_roughness_texture->getDescriptorImageInfo();
-                    VkDescriptorImageInfo normalImageInfo = material.normal_texture->getDescriptorImageInfo();
-                    VkDescriptorImageInfo occlusionImageInfo = material.occlusion_texture->getDescriptorImageInfo();
-                    VkDescriptorImageInfo emissiveImageInfo = material.emissive_texture->getDescriptorImageInfo();
-                    VkDescriptorBufferInfo pbrParametersBufferInfo = material.pbr_parameters_buffer->getDescriptorInfo();
-
-                    VtDescriptorWriter(materialSetLayout, descriptorPool)
-                        .writeImage(0, &baseColorImageInfo)
-                        .writeImage(1, &metallicRoughnessImageInfo)
-                        .writeImage(2, &normalImageInfo)
-                        .writeImage(3, &occlusionImageInfo)
-                        .writeImage(4, &emissiveImageInfo)
-                        .writeBuffer(5, &pbrParametersBufferInfo)
-                        .build(material.descriptor_set);
-
                     Primitive primitive{};
                     primitive.firstVertex = vertexOffset;
                     primitive.vertexCount = vertexCount;
                     primitive.indexCount = indexCount;
                     primitive.firstIndex = indexOffset;
-                    primitive.material = material;
+                    primitive.bounds = bounds;
+                    primitive.material = cachedMaterial->second;
                     primitives.push_back(primitive);
                     vertexOffset += vertexCount;
                     indexOffset += indexCount;
@@ -441,4 +340,143 @@ namespace vt
             createIndexBuffers(indices);
         }
     }
+
+    VtModel::PBRMaterial VtModel::createMaterial(tinygltf::Model& GltfModel, int materialIndex, VtDescriptorSetLayout& materialSetLayout, VtDescriptorPool& descriptorPool)
+    {
+        std::shared_ptr<Texture> defaultTexture = std::make_shared<Texture>(vtDevice, "textures/white.png", true);
+        std::shared_ptr<Texture> defaultNormalTexture = std::make_shared<Texture>(vtDevice, "textures/normal.png", false);
+        std::shared_ptr<Texture> defaultMetallicRoughnessTexture = std::make_shared<Texture>(vtDevice, "textures/metallicRoughness.png", false);
+
+        PBRMaterial material = {};
+        if (materialIndex != -1)
+        {
+            tinygltf::Material& primitiveMaterial = GltfModel.materials[materialIndex];
+            if (primitiveMaterial.pbrMetallicRoughness.baseColorTexture.index != -1)
+            {
+                uint32_t textureIndex = primitiveMaterial.pbrMetallicRoughness.baseColorTexture.index;  // Get the texture index
+                uint32_t imageIndex = GltfModel.textures[textureIndex].source;                          // Get the image index
+                material.base_color_texture = images[imageIndex];                                       // Set Base Color Texture
+                material.pbr_parameters.has_base_color_texture = 1;                                     // Set Has_Base_Color Parameter
+            }
+            else
+            {
+                material.base_color_texture = defaultTexture;
+                material.pbr_parameters.has_base_color_texture = 0;
+                auto color = primitiveMaterial.pbrMetallicRoughness.baseColorFactor;
+                material.pbr_parameters.base_color_factor = { color[0], color[1], color[2], color[3] };
+            }
+
+            if (primitiveMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index != -1)
+            {
+                uint32_t textureIndex = primitiveMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index;  // Get the texture index
+                uint32_t imageIndex = GltfModel.textures[textureIndex].source;                                  // Get the image index
+                material.metallic_roughness_texture = images[imageIndex];                                       // Set Base Color Texture
+                material.pbr_parameters.has_metallic_roughness_texture = 1;                                     // Set Has_Base_Color Parameter
+            }
+            else
+            {
+                material.metallic_roughness_texture = defaultMetallicRoughnessTexture;
+                material.pbr_parameters.has_metallic_roughness_texture = 0;
+                material.pbr_parameters.metallic_factor = primitiveMaterial.pbrMetallicRoughness.metallicFactor;
+                material.pbr_parameters.roughness_factor = primitiveMaterial.pbrMetallicRoughness.roughnessFactor;
+            }
+
+            if (primitiveMaterial.normalTexture.index != -1)
+            {
+                uint32_t textureIndex = primitiveMaterial.normalTexture.index;
+                uint32_t imageIndex = GltfModel.textures[textureIndex].source;
+                material.normal_texture = images[imageIndex];
+                material.pbr_parameters.has_normal_texture = 1;
+                material.pbr_parameters.scale = primitiveMaterial.normalTexture.scale;
+            }
+            else
+            {
+                material.normal_texture = defaultNormalTexture;
+                material.pbr_parameters.has_normal_texture = 0;
+            }
+
+            if (primitiveMaterial.occlusionTexture.index != -1)
+            {
+                uint32_t textureIndex = primitiveMaterial.occlusionTexture.index;
+                uint32_t imageIndex = GltfModel.textures[textureIndex].source;
+                material.occlusion_texture = images[imageIndex];
+                material.pbr_parameters.has_occlusion_texture = 1;
+                material.pbr_parameters.strength = primitiveMaterial.occlusionTexture.strength;
+            }
+            else
+            {
+                material.occlusion_texture = defaultTexture;
+                material.pbr_parameters.has_occlusion_texture = 0;
+                material.pbr_parameters.strength = primitiveMaterial.occlusionTexture.strength;
+            }
+
+            if (primitiveMaterial.emissiveTexture.index != -1)
+            {
+                uint32_t textureIndex = primitiveMaterial.emissiveTexture.index;
+                uint32_t imageIndex = GltfModel.textures[textureIndex].source;
+                material.emissive_texture = images[imageIndex];
+                material.pbr_parameters.has_emissive_texture = 1;
+            }
+            else
+            {
+                material.emissive_texture = defaultTexture;
+                material.pbr_parameters.has_emissive_texture = 0;
+                auto color = primitiveMaterial.emissiveFactor;
+                material.pbr_parameters.emissive_factor = { color[0], color[1], color[2] };
+            }
+
+            material.pbr_parameters.alpha_cut_off = primitiveMaterial.alphaCutoff;
+            material.alpha_masked = primitiveMaterial.alphaMode != "OPAQUE";
+            if (primitiveMaterial.alphaMode == "MASK") material.pbr_parameters.alpha_mode = 1.f;
+            else if (primitiveMaterial.alphaMode == "BLEND") material.pbr_parameters.alpha_mode = 2.f;
+            else material.pbr_parameters.alpha_mode = 0.f;
+        }
+        else
+        {
+            material.base_color_texture = defaultTexture;
+            material.metallic_roughness_texture = defaultMetallicRoughnessTexture;
+            material.normal_texture = defaultNormalTexture;
+            material.occlusion_texture = defaultTexture;
+            material.emissive_texture = defaultTexture;
+        }
+
+        VtBuffer stagingBuffer{
+            vtDevice,
+            sizeof(PBRParameters),
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
+
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer(&material.pbr_parameters);
+
+        material.pbr_parameters_buffer = std::make_unique<VtBuffer>(
+            vtDevice,
+            sizeof(PBRParameters),
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+        vtDevice.copyBuffer(stagingBuffer.getBuffer(), material.pbr_parameters_buffer->getBuffer(), sizeof(PBRParameters));
+
+        VkDescriptorImageInfo baseColorImageInfo = material.base_color_texture->getDescriptorImageInfo();
+        VkDescriptorImageInfo metallicRoughnessImageInfo = material.metallic_roughness_texture->getDescriptorImageInfo();
+        VkDescriptorImageInfo normalImageInfo = material.normal_texture->getDescriptorImageInfo();
+        VkDescriptorImageInfo occlusionImageInfo = material.occlusion_texture->getDescriptorImageInfo();
+        VkDescriptorImageInfo emissiveImageInfo = material.emissive_texture->getDescriptorImageInfo();
+        VkDescriptorBufferInfo pbrParametersBufferInfo = material.pbr_parameters_buffer->getDescriptorInfo();
+
+        VtDescriptorWriter(materialSetLayout, descriptorPool)
+            .writeImage(0, &baseColorImageInfo)
+            .writeImage(1, &metallicRoughnessImageInfo)
+            .writeImage(2, &normalImageInfo)
+            .writeImage(3, &occlusionImageInfo)
+            .writeImage(4, &emissiveImageInfo)
+            .writeBuffer(5, &pbrParametersBufferInfo)
+            .build(material.descriptor_set);
+
+        return material;
+    }
 }
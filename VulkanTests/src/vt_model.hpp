@@ -5,6 +5,7 @@
 #include "vt_device.hpp"
 #include "vt_texture.hpp"
 #include "vt_descriptors.hpp"
+#include "vt_frustum_culler.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -29,7 +30,7 @@ namespace vt {
 			float scale = 1.0;
 			float strength = 1.0;
 			float alpha_cut_off = 1.0;
-			float alpha_mode = 1.0;
+			float alpha_mode = 0.0; // glTF OPAQUE 0, MASK 1, BLEND 2
 
 			int has_base_color_texture = 0;
 			int has_metallic_roughness_texture = 0;
@@ -49,6 +50,7 @@ namespace vt {
 
 			std::shared_ptr<VtBuffer> pbr_parameters_buffer = {};
 			VkDescriptorSet descriptor_set = {};
+			bool alpha_masked = false; // glTF MASK or BLEND, needs the alpha test in depth only passes
 		};
 
 		struct Material
@@ -65,6 +67,7 @@ namespace vt {
 			uint32_t firstVertex;
 			uint32_t indexCount;
 			uint32_t vertexCount;
+			VtAabb bounds;  // model space
 			PBRMaterial material;
 		};
 
@@ -88,11 +91,18 @@ namespace vt {
 
 		void bind(VkCommandBuffer commandBuffer);
 		void draw(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet, VkPipelineLayout pipelineLayout);
+		void drawPrimitive(VkCommandBuffer commandBuffer, uint32_t primitiveIndex, VkDescriptorSet globalDescriptorSet, VkPipelineLayout pipelineLayout);
+		// Same as drawPrimitive but the draw parameters come from a VkDrawIndexedIndirectCommand written on the GPU
+		void drawPrimitiveIndirect(VkCommandBuffer commandBuffer, uint32_t primitiveIndex, VkDescriptorSet globalDescriptorSet, VkPipelineLayout pipelineLayout, VkBuffer indirectBuffer, VkDeviceSize offset);
+
+		const std::vector<Primitive>& getPrimitives() const { return primitives; }
+		bool hasIndices() const { return hasIndexBuffer; }
 
 	private:
 
 		//void LoadImagesGLTF();
 		bool GetImageFormatGLTF(uint32_t imageIndex, tinygltf::Model GltfModel);
+		PBRMaterial createMaterial(tinygltf::Model& GltfModel, int materialIndex, VtDescriptorSetLayout& materialSetLayout, VtDescriptorPool& descriptorPool);
 		void createVertexBuffers(const std::vector<Vertex>& vertices);
 		void createIndexBuffers(const std::vector<uint32_t>& indices);
 
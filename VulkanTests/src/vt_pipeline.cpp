@@ -3,6 +3,7 @@
 #include "vt_model.hpp"
 
 // std
+#include <chrono>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
@@ -10,20 +11,86 @@
 #include <vector>
 
 namespace vt {
+	//FNV-1a over the fields a pipeline library is built from, field by field so that padding never reaches the key
+	class PipelineStateHash {
+	public:
+		template<typename T>
+		PipelineStateHash& add(const T& value) { return addBytes(&value, sizeof(T)); }
+		template<typename T>
+		PipelineStateHash& add(const std::vector<T>& values) { return add(values.size()).addBytes(values.data(), values.size() * sizeof(T)); }
+		uint64_t get() const { return hash; }
+
+	private:
+		PipelineStateHash& addBytes(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return *this;
+		}
+
+		uint64_t hash = 14695981039346656037ull;
+	};
+
+	static double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
 	VtPipeline::VtPipeline(
 		VtDevice& device,
 		const std::string& vertFilepath,
 		const std::string& fragFilepath,
-		PipelineConfigInfo& configInfo) : vtDevice{ device }
+		const PipelineConfigInfo& config) : vtDevice{ device }, vertFilepath{ vertFilepath }, fragFilepath{ fragFilepath }
 	{
-		createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+		assert(
+			config.pipelineLayout != VK_NULL_HANDLE &&
+			"Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
+		assert(
+			config.renderPass != VK_NULL_HANDLE &&
+			"Cannot create graphics pipeline: no renderPass provided in configInfo");
+
+		//Own copy for the compilation thread, with the pointers moved to the copied arrays
+		configInfo.bindingDescriptions = config.bindingDescriptions;
+		configInfo.attributeDescriptions = config.attributeDescriptions;
+		configInfo.viewportInfo = config.viewportInfo;
+		configInfo.inputAssemblyInfo = config.inputAssemblyInfo;
+		configInfo.rasterizationInfo = config.rasterizationInfo;
+		configInfo.multisampleInfo = config.multisampleInfo;
+		configInfo.colorBlendAttachment = config.colorBlendAttachment;
+		configInfo.attachmentCount = config.attachmentCount;
+		configInfo.colorBlendInfo = config.colorBlendInfo;
+		configInfo.depthStencilInfo = config.depthStencilInfo;
+		configInfo.dynamicStateEnables = config.dynamicStateEnables;
+		configInfo.dynamicStateInfo = config.dynamicStateInfo;
+		configInfo.pipelineLayout = config.pipelineLayout;
+		configInfo.renderPass = config.renderPass;
+		configInfo.subpass = config.subpass;
+		configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+
+		//Support for multiple attachements
+		colorBlendAttachments.assign(configInfo.attachmentCount, configInfo.colorBlendAttachment);
+		configInfo.colorBlendInfo.attachmentCount = configInfo.attachmentCount;
+		configInfo.colorBlendInfo.pAttachments = colorBlendAttachments.data();
+
+		compilation = vtDevice.getPipelineCompiler().submit([this](VkPipelineCache workerCache)
+			{
+				if (vtDevice.getPipelineCompiler().usesGraphicsPipelineLibrary()) linkGraphicsPipeline(workerCache);
+				else createGraphicsPipeline(workerCache);
+			});
 	}
 
 	VtPipeline::~VtPipeline() {
-		vkDestroyShaderModule(vtDevice.device(), vertShaderModule, nullptr);
-		vkDestroyShaderModule(vtDevice.device(), fragShaderModule, nullptr);
-		vkDestroyPipeline(vtDevice.device(), graphicsPipeline, nullptr);
+		//The jobs use the layout and render pass of the owner, which are destroyed right after
+		compilation.wait();
+		if (optimization.valid()) optimization.wait();
 
+		VkPipeline pipeline = graphicsPipeline.load();
+		if (linkedPipeline != pipeline) vkDestroyPipeline(vtDevice.device(), linkedPipeline, nullptr);
+		vkDestroyPipeline(vtDevice.device(), pipeline, nullptr);
 	}
 
 	std::vector<char> VtPipeline::readFile(const std::string& filepath)
@@ -44,25 +111,11 @@ namespace vt {
 		return buffer;
 	}
 
-	void VtPipeline::createGraphicsPipeline(
-		const std::string& vertFilepath,
-		const std::string& fragFilepath,
-		PipelineConfigInfo& configInfo)
+	void VtPipeline::fillCreateInfo(
+		VkGraphicsPipelineCreateInfo& pipelineInfo,
+		VkPipelineShaderStageCreateInfo* shaderStages,
+		VkPipelineVertexInputStateCreateInfo& vertexInputInfo)
 	{
-		assert(
-			configInfo.pipelineLayout != VK_NULL_HANDLE &&
-			"Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
-		assert(
-			configInfo.renderPass != VK_NULL_HANDLE &&
-			"Cannot create graphics pipeline: no renderPass provided in configInfo");
-
-		auto vertCode = readFile(vertFilepath);
-		auto fragCode = readFile(fragFilepath);
-
-		createShaderModule(vertCode, &vertShaderModule);
-		createShaderModule(fragCode, &fragShaderModule);
-
-		VkPipelineShaderStageCreateInfo shaderStages[2];
 		// Vertex Shader
 		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -72,32 +125,30 @@ namespace vt {
 		shaderStages[0].pNext = nullptr;
 		shaderStages[0].pSpecializationInfo = nullptr;
 
-		// Fragment Shader
-		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		shaderStages[1].module = fragShaderModule;
-		shaderStages[1].pName = "main";
-		shaderStages[1].flags = 0;
-		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		// Fragment Shader, optional for depth only pipelines
+		uint32_t stageCount = 1;
+		if (fragShaderModule != VK_NULL_HANDLE)
+		{
+			shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+			shaderStages[1].module = fragShaderModule;
+			shaderStages[1].pName = "main";
+			shaderStages[1].flags = 0;
+			shaderStages[1].pNext = nullptr;
+			shaderStages[1].pSpecializationInfo = nullptr;
+			stageCount = 2;
+		}
 
 		auto& bindingDescriptions = configInfo.bindingDescriptions;
 		auto& attributeDescriptions = configInfo.attributeDescriptions;
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
 		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 
-		//Support for multiple attachements
-		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(configInfo.attachmentCount, configInfo.colorBlendAttachment);
-		configInfo.colorBlendInfo.attachmentCount = configInfo.attachmentCount;
-		configInfo.colorBlendInfo.pAttachments = colorBlendAttachments.data();
-
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
+		pipelineInfo.stageCount = stageCount;
 		pipelineInfo.pStages = shaderStages;
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
 		pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
@@ -114,27 +165,204 @@ namespace vt {
 
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	}
+
+	void VtPipeline::createGraphicsPipeline(VkPipelineCache workerCache)
+	{
+		auto creationStart = std::chrono::high_resolution_clock::now();
+		vertShaderModule = vtDevice.getShaderModuleCache().getModule(vertFilepath);
+		if (!fragFilepath.empty()) fragShaderModule = vtDevice.getShaderModuleCache().getModule(fragFilepath);
+
+		VkPipelineShaderStageCreateInfo shaderStages[2];
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		fillCreateInfo(pipelineInfo, shaderStages, vertexInputInfo);
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		if (vkCreateGraphicsPipelines(vtDevice.device(), workerCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create graphics pipeline");
+		}
+		graphicsPipeline = pipeline;
+		vtDevice.getPipelineCache().recordPipelineCreation(millisecondsSince(creationStart));
+		ready = true;
+	}
 
-		if (vkCreateGraphicsPipelines(vtDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-			//throw std::runtime_error("failed to create graphics pipeline");
+	uint64_t VtPipeline::libraryKey(VkGraphicsPipelineLibraryFlagsEXT libraryFlags) const
+	{
+		PipelineStateHash hash;
+		hash.add(libraryFlags);
+		switch (libraryFlags)
+		{
+		case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+			hash.add(configInfo.bindingDescriptions)
+				.add(configInfo.attributeDescriptions)
+				.add(configInfo.inputAssemblyInfo.topology)
+				.add(configInfo.inputAssemblyInfo.primitiveRestartEnable);
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+			hash.add(vertShaderModule)
+				.add(configInfo.pipelineLayout)
+				.add(configInfo.renderPass)
+				.add(configInfo.subpass)
+				.add(configInfo.viewportInfo.viewportCount)
+				.add(configInfo.viewportInfo.scissorCount)
+				.add(configInfo.rasterizationInfo.depthClampEnable)
+				.add(configInfo.rasterizationInfo.rasterizerDiscardEnable)
+				.add(configInfo.rasterizationInfo.polygonMode)
+				.add(configInfo.rasterizationInfo.cullMode)
+				.add(configInfo.rasterizationInfo.frontFace)
+				.add(configInfo.rasterizationInfo.depthBiasEnable)
+				.add(configInfo.rasterizationInfo.depthBiasConstantFactor)
+				.add(configInfo.rasterizationInfo.depthBiasClamp)
+				.add(configInfo.rasterizationInfo.depthBiasSlopeFactor)
+				.add(configInfo.rasterizationInfo.lineWidth)
+				.add(configInfo.dynamicStateEnables);
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+			hash.add(fragShaderModule)
+				.add(configInfo.pipelineLayout)
+				.add(configInfo.renderPass)
+				.add(configInfo.subpass)
+				.add(configInfo.depthStencilInfo.depthTestEnable)
+				.add(configInfo.depthStencilInfo.depthWriteEnable)
+				.add(configInfo.depthStencilInfo.depthCompareOp)
+				.add(configInfo.depthStencilInfo.depthBoundsTestEnable)
+				.add(configInfo.depthStencilInfo.stencilTestEnable)
+				.add(configInfo.depthStencilInfo.front)
+				.add(configInfo.depthStencilInfo.back)
+				.add(configInfo.depthStencilInfo.minDepthBounds)
+				.add(configInfo.depthStencilInfo.maxDepthBounds)
+				.add(configInfo.multisampleInfo.rasterizationSamples)
+				.add(configInfo.multisampleInfo.sampleShadingEnable)
+				.add(configInfo.multisampleInfo.minSampleShading)
+				.add(configInfo.dynamicStateEnables);
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+			hash.add(configInfo.renderPass)
+				.add(configInfo.subpass)
+				.add(colorBlendAttachments)
+				.add(configInfo.colorBlendInfo.logicOpEnable)
+				.add(configInfo.colorBlendInfo.logicOp)
+				.add(configInfo.colorBlendInfo.blendConstants)
+				.add(configInfo.multisampleInfo.rasterizationSamples)
+				.add(configInfo.multisampleInfo.sampleShadingEnable)
+				.add(configInfo.multisampleInfo.minSampleShading)
+				.add(configInfo.multisampleInfo.alphaToCoverageEnable)
+				.add(configInfo.multisampleInfo.alphaToOneEnable)
+				.add(configInfo.dynamicStateEnables);
+			break;
 		}
+		return hash.get();
+	}
+
+	std::shared_ptr<VtPipelineLibrary> VtPipeline::getLibrary(VkGraphicsPipelineLibraryFlagsEXT libraryFlags, VkPipelineCache workerCache)
+	{
+		return vtDevice.getPipelineCompiler().getLibrary(libraryKey(libraryFlags), [&]()
+			{
+				VkPipelineShaderStageCreateInfo shaderStages[2];
+				VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+				VkGraphicsPipelineCreateInfo pipelineInfo{};
+				fillCreateInfo(pipelineInfo, shaderStages, vertexInputInfo);
+
+				//The state outside of the library part is ignored, but the stages must belong to it
+				switch (libraryFlags)
+				{
+				case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+					pipelineInfo.stageCount = 1;
+					break;
+				case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+					pipelineInfo.stageCount = fragShaderModule != VK_NULL_HANDLE ? 1 : 0;
+					pipelineInfo.pStages = fragShaderModule != VK_NULL_HANDLE ? &shaderStages[1] : nullptr;
+					break;
+				default:
+					pipelineInfo.stageCount = 0;
+					pipelineInfo.pStages = nullptr;
+					break;
+				}
+
+				VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+				libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+				libraryInfo.flags = libraryFlags;
+				pipelineInfo.pNext = &libraryInfo;
+				//Retained so that the optimized pipeline can be linked from the same libraries
+				pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+				VkPipeline library;
+				if (vkCreateGraphicsPipelines(vtDevice.device(), workerCache, 1, &pipelineInfo, nullptr, &library) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create graphics pipeline library");
+				}
+				return library;
+			});
 	}
 
-	void VtPipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule) 
+	void VtPipeline::linkGraphicsPipeline(VkPipelineCache workerCache)
 	{
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		auto creationStart = std::chrono::high_resolution_clock::now();
+		vertShaderModule = vtDevice.getShaderModuleCache().getModule(vertFilepath);
+		if (!fragFilepath.empty()) fragShaderModule = vtDevice.getShaderModuleCache().getModule(fragFilepath);
+
+		libraries = {
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, workerCache),
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, workerCache),
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, workerCache),
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, workerCache) };
+
+		std::vector<VkPipeline> libraryPipelines;
+		for (auto& library : libraries) libraryPipelines.push_back(library->pipeline);
+
+		VkPipelineLibraryCreateInfoKHR libraryInfo{};
+		libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+		libraryInfo.libraryCount = static_cast<uint32_t>(libraryPipelines.size());
+		libraryInfo.pLibraries = libraryPipelines.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &libraryInfo;
+		pipelineInfo.layout = configInfo.pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
 
-		if (vkCreateShaderModule(vtDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create shader module");
+		//No link time optimization, the driver only stitches the libraries together
+		VkPipeline pipeline;
+		if (vkCreateGraphicsPipelines(vtDevice.device(), workerCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+			throw std::runtime_error("failed to link graphics pipeline");
+		}
+		linkedPipeline = pipeline;
+		graphicsPipeline = pipeline;
+		vtDevice.getPipelineCache().recordPipelineCreation(millisecondsSince(creationStart));
+		ready = true;
+
+		optimization = vtDevice.getPipelineCompiler().submit([this](VkPipelineCache optimizationCache) { createOptimizedPipeline(optimizationCache); });
+	}
+
+	void VtPipeline::createOptimizedPipeline(VkPipelineCache workerCache)
+	{
+		std::vector<VkPipeline> libraryPipelines;
+		for (auto& library : libraries) libraryPipelines.push_back(library->pipeline);
+
+		VkPipelineLibraryCreateInfoKHR libraryInfo{};
+		libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+		libraryInfo.libraryCount = static_cast<uint32_t>(libraryPipelines.size());
+		libraryInfo.pLibraries = libraryPipelines.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &libraryInfo;
+		pipelineInfo.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+		pipelineInfo.layout = configInfo.pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+
+		//The linked pipeline stays in use if the optimization fails
+		VkPipeline pipeline;
+		if (vkCreateGraphicsPipelines(vtDevice.device(), workerCache, 1, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS) {
+			graphicsPipeline = pipeline;
 		}
 	}
 
 	void VtPipeline::bind(VkCommandBuffer commandBuffer)
 	{
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		//Rethrows the error of the compilation, if any
+		if (!ready.load()) compilation.get();
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.load());
 	}
 
 	void VtPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) 
@@ -226,4 +454,51 @@ namespace vt {
 		configInfo.bindingDescriptions = VtModel::Vertex::getBindingDescriptions();
 		configInfo.attributeDescriptions = VtModel::Vertex::getAttributeDescriptions();
 	}
+
+	VtComputePipeline::VtComputePipeline(
+		VtDevice& device,
+		const std::string& compFilepath,
+		VkPipelineLayout pipelineLayout) : vtDevice{ device }
+	{
+		assert(
+			pipelineLayout != VK_NULL_HANDLE &&
+			"Cannot create compute pipeline: no pipelineLayout provided");
+
+		compilation = vtDevice.getPipelineCompiler().submit([this, compFilepath, pipelineLayout](VkPipelineCache workerCache)
+			{
+				createComputePipeline(workerCache, compFilepath, pipelineLayout);
+			});
+	}
+
+	void VtComputePipeline::createComputePipeline(VkPipelineCache workerCache, const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+	{
+		auto creationStart = std::chrono::high_resolution_clock::now();
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = vtDevice.getShaderModuleCache().getModule(compFilepath);
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		if (vkCreateComputePipelines(vtDevice.device(), workerCache, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute pipeline");
+		}
+		vtDevice.getPipelineCache().recordPipelineCreation(millisecondsSince(creationStart));
+		ready = true;
+	}
+
+	VtComputePipeline::~VtComputePipeline() {
+		compilation.wait();
+		vkDestroyPipeline(vtDevice.device(), computePipeline, nullptr);
+	}
+
+	void VtComputePipeline::bind(VkCommandBuffer commandBuffer)
+	{
+		if (!ready.load()) compilation.get();
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	}
 }
\ No newline at end of file
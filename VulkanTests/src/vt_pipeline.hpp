@@ -1,8 +1,12 @@
 #pragma once
 
 #include "vt_device.hpp"
+#include "vt_pipeline_compiler.hpp"
 
 // std
+#include <atomic>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -31,34 +35,73 @@ namespace vt {
 	};
 
 
+	// Pipelines are compiled by the device's VtPipelineCompiler, the constructors only queue them. bind() waits for a
+	// pipeline that isn't compiled yet, optional pipelines check isReady() and bind a fallback meanwhile
 	class VtPipeline {
 	public:
+		// An empty fragFilepath creates a pipeline without fragment stage (depth only passes).
+		// configInfo is copied, the caller can change it and create the next pipeline right away
 		VtPipeline(
 			VtDevice &device, 
 			const std::string& vertFilepath, 
 			const std::string& fragFilepath, 
-			PipelineConfigInfo& configInfo);
+			const PipelineConfigInfo& configInfo);
 		~VtPipeline();
 
 		VtPipeline(const VtPipeline&) = delete;
 		VtPipeline& operator=(const VtPipeline&) = delete;
 
 		void bind(VkCommandBuffer commandBuffer);
+		bool isReady() const { return ready.load(); }
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+		static std::vector<char> readFile(const std::string& filepath);
 
 	private:
-		static std::vector<char> readFile(const std::string& filepath);
+		// Compilation thread
+		void createGraphicsPipeline(VkPipelineCache workerCache);
+		// Graphics pipeline library path: fast link first, the optimized pipeline replaces it later
+		void linkGraphicsPipeline(VkPipelineCache workerCache);
+		void createOptimizedPipeline(VkPipelineCache workerCache);
+		std::shared_ptr<VtPipelineLibrary> getLibrary(VkGraphicsPipelineLibraryFlagsEXT libraryFlags, VkPipelineCache workerCache);
+		uint64_t libraryKey(VkGraphicsPipelineLibraryFlagsEXT libraryFlags) const;
+		void fillCreateInfo(VkGraphicsPipelineCreateInfo& pipelineInfo, VkPipelineShaderStageCreateInfo* shaderStages, VkPipelineVertexInputStateCreateInfo& vertexInputInfo);
 
-		void createGraphicsPipeline(
-			const std::string& vertFilepath, 
-			const std::string& fragFilepath, 
-			PipelineConfigInfo& configInfo);
+		VtDevice& vtDevice;
+		std::string vertFilepath;
+		std::string fragFilepath;
+		PipelineConfigInfo configInfo;
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+		VkShaderModule vertShaderModule = VK_NULL_HANDLE; // owned by the shader module cache
+		VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+
+		std::atomic<VkPipeline> graphicsPipeline{ VK_NULL_HANDLE };
+		VkPipeline linkedPipeline = VK_NULL_HANDLE; // kept after the optimized one replaced it, recorded frames may still use it
+		std::vector<std::shared_ptr<VtPipelineLibrary>> libraries;
+		std::atomic<bool> ready{ false };
+		std::shared_future<void> compilation;
+		std::shared_future<void> optimization; // submitted by the compilation job, valid once compilation is done
+	};
 
-		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+	class VtComputePipeline {
+	public:
+		VtComputePipeline(
+			VtDevice& device,
+			const std::string& compFilepath,
+			VkPipelineLayout pipelineLayout);
+		~VtComputePipeline();
+
+		VtComputePipeline(const VtComputePipeline&) = delete;
+		VtComputePipeline& operator=(const VtComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+		bool isReady() const { return ready.load(); }
+
+	private:
+		void createComputePipeline(VkPipelineCache workerCache, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
 
 		VtDevice& vtDevice;
-		VkPipeline graphicsPipeline;
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
+		VkPipeline computePipeline = VK_NULL_HANDLE;
+		std::atomic<bool> ready{ false };
+		std::shared_future<void> compilation;
 	};
 }
\ No newline at end of file
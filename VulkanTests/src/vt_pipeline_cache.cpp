@@ -0,0 +1,148 @@
+#include "vt_pipeline_cache.hpp"
+
+// std
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace vt
+{
+	VtPipelineCache::VtPipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filepath)
+		: device{ device }, properties{ properties }, filepath{ filepath }
+	{
+		std::vector<char> data;
+		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+		if (file.is_open())
+		{
+			data.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(data.data(), data.size());
+			if (!file)
+			{
+				data.clear();
+			}
+		}
+
+		if (!data.empty() && !isCompatible(data))
+		{
+			std::cout << "Pipeline cache: " << filepath << " was written for another device or driver, starting cold" << std::endl;
+			data.clear();
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = data.size();
+		cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+		if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+		{
+			//The driver may still reject data whose header looked fine
+			cacheInfo.initialDataSize = 0;
+			cacheInfo.pInitialData = nullptr;
+			data.clear();
+			if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create pipeline cache!");
+			}
+		}
+		loadedSize = data.size();
+	}
+
+	VtPipelineCache::~VtPipelineCache()
+	{
+		vkDestroyPipelineCache(device, cache, nullptr);
+	}
+
+	bool VtPipelineCache::isCompatible(const std::vector<char>& data) const
+	{
+		//Version one header, the only one the driver has to understand
+		VkPipelineCacheHeaderVersionOne header{};
+		if (data.size() < sizeof(header))
+		{
+			return false;
+		}
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header)
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	VkPipelineCache VtPipelineCache::createWorkerCache()
+	{
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		VkPipelineCache workerCache;
+		if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &workerCache) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+		return workerCache;
+	}
+
+	void VtPipelineCache::mergeWorkerCache(VkPipelineCache workerCache)
+	{
+		{
+			//The destination of a merge is externally synchronized
+			std::lock_guard<std::mutex> lock{ mergeMutex };
+			vkMergePipelineCaches(device, cache, 1, &workerCache);
+		}
+		vkDestroyPipelineCache(device, workerCache, nullptr);
+	}
+
+	void VtPipelineCache::save()
+	{
+		std::lock_guard<std::mutex> lock{ mergeMutex };
+
+		size_t size = 0;
+		if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0)
+		{
+			return;
+		}
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+		{
+			return;
+		}
+
+		//Renaming replaces the previous file in one step, readers see the old cache or the new one
+		std::string temporaryPath = filepath + ".tmp";
+		{
+			std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+			file.write(data.data(), size);
+			if (!file)
+			{
+				std::cout << "Pipeline cache: failed to write " << temporaryPath << std::endl;
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, filepath, error);
+		if (error)
+		{
+			std::cout << "Pipeline cache: failed to replace " << filepath << " (" << error.message() << ")" << std::endl;
+			std::filesystem::remove(temporaryPath, error);
+		}
+	}
+
+	void VtPipelineCache::recordPipelineCreation(double milliseconds)
+	{
+		pipelineCount++;
+		creationMicroseconds += static_cast<uint64_t>(milliseconds * 1000.0);
+	}
+
+	void VtPipelineCache::printStats(std::ostream& stream) const
+	{
+		stream << "Pipeline cache: " << (loadedSize > 0 ? "warm" : "cold") << " start";
+		if (loadedSize > 0)
+		{
+			stream << " (" << loadedSize / 1024 << " KiB loaded)";
+		}
+		stream << ", " << pipelineCount.load() << " pipelines created in " << creationMicroseconds.load() / 1000.0 << " ms" << std::endl;
+	}
+}
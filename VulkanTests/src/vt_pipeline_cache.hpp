@@ -0,0 +1,60 @@
+/*
+Process wide pipeline cache owned by VtDevice, kept on disk between runs.
+Every graphics and compute pipeline is created through it, so a second launch (or a resize recreating pipelines) gets
+the driver's compiled code back instead of compiling the shaders again.
+The file is only used when its header matches the device: a cache from another GPU or driver version is ignored, not
+handed to the driver. Threads compiling pipelines on their own get a worker cache, merged back before saving.
+The cache is written to a temporary file renamed over the previous one, a crash while saving never leaves a truncated cache.
+*/
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vt
+{
+	class VtPipelineCache
+	{
+	public:
+		VtPipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filepath);
+		~VtPipelineCache();
+
+		VtPipelineCache(const VtPipelineCache&) = delete;
+		VtPipelineCache& operator=(const VtPipelineCache&) = delete;
+
+		VkPipelineCache getCache() const { return cache; }
+
+		// Empty cache for one compilation thread, handed back with mergeWorkerCache once its pipelines are created
+		VkPipelineCache createWorkerCache();
+		// Merges the worker cache into the main one and destroys it
+		void mergeWorkerCache(VkPipelineCache workerCache);
+
+		// Written atomically, VtDevice saves it before destroying the device
+		void save();
+
+		// Time spent in vkCreate*Pipelines, to compare a cold start (no usable file) with a warm one
+		void recordPipelineCreation(double milliseconds);
+		void printStats(std::ostream& stream) const;
+
+	private:
+		bool isCompatible(const std::vector<char>& data) const;
+
+		VkDevice device;
+		VkPhysicalDeviceProperties properties;
+		std::string filepath;
+		VkPipelineCache cache = VK_NULL_HANDLE;
+
+		std::mutex mergeMutex;
+		size_t loadedSize = 0; // 0 on a cold start
+		std::atomic<uint32_t> pipelineCount{ 0 };
+		std::atomic<uint64_t> creationMicroseconds{ 0 };
+	};
+}
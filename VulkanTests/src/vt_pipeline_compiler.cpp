@@ -0,0 +1,78 @@
+#include "vt_pipeline_compiler.hpp"
+
+// std
+#include <thread>
+
+namespace vt
+{
+	static uint32_t compilationThreadCount(uint32_t threadCount)
+	{
+		if (threadCount != 0) return threadCount;
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	VtPipelineCompiler::VtPipelineCompiler(VkDevice device, VtPipelineCache& pipelineCache, bool graphicsPipelineLibrarySupported, uint32_t threadCount)
+		: device{ device }, pipelineCache{ pipelineCache }, graphicsPipelineLibrarySupported{ graphicsPipelineLibrarySupported },
+		threadPool{ compilationThreadCount(threadCount) }
+	{
+	}
+
+	VtPipelineCompiler::~VtPipelineCompiler()
+	{
+		//The pool stops its threads without draining the queue, pipelines may still be waiting on these jobs
+		waitIdle();
+	}
+
+	std::shared_future<void> VtPipelineCompiler::submit(std::function<void(VkPipelineCache)> job)
+	{
+		//std::function has to be copyable, the promise is shared with the job
+		auto done = std::make_shared<std::promise<void>>();
+		std::shared_future<void> future = done->get_future().share();
+
+		pendingJobs++;
+		threadPool.submit([this, job = std::move(job), done]()
+			{
+				VkPipelineCache workerCache = pipelineCache.createWorkerCache();
+				try
+				{
+					job(workerCache);
+					done->set_value();
+				}
+				catch (...)
+				{
+					done->set_exception(std::current_exception());
+				}
+				pipelineCache.mergeWorkerCache(workerCache);
+				pendingJobs--;
+			});
+		return future;
+	}
+
+	void VtPipelineCompiler::waitIdle()
+	{
+		threadPool.wait();
+	}
+
+	std::shared_ptr<VtPipelineLibrary> VtPipelineCompiler::getLibrary(uint64_t key, const std::function<VkPipeline()>& create)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ libraryMutex };
+			auto found = libraries.find(key);
+			if (found != libraries.end())
+			{
+				if (auto library = found->second.lock()) return library;
+			}
+		}
+
+		//Created outside of the lock so that other jobs keep linking. Two jobs missing the same key both compile it and
+		//the second one drops its copy
+		auto created = std::make_shared<VtPipelineLibrary>(device, create());
+
+		std::lock_guard<std::mutex> lock{ libraryMutex };
+		auto& entry = libraries[key];
+		if (auto library = entry.lock()) return library;
+		entry = created;
+		return created;
+	}
+}
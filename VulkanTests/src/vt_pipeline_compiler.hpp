@@ -0,0 +1,77 @@
+/*
+Background pipeline compilation, owned by VtDevice.
+VtPipeline and VtComputePipeline hand their creation to this pool instead of compiling in their constructors: the render
+passes and systems built at startup queue all their pipelines at once and the worker threads compile them side by side.
+Each job gets a worker pipeline cache of its own, merged into the device cache once the job is done.
+With VK_EXT_graphics_pipeline_library the graphics pipelines are linked from four libraries (vertex input, pre-rasterization,
+fragment shader, fragment output). The libraries are shared between the pipelines that use the same state, so a permutation
+that only changes the blending or the fragment shader links in a fraction of a full compilation. The optimized pipeline is
+then compiled in the background and replaces the linked one once it is done.
+*/
+
+#pragma once
+
+#include "vt_pipeline_cache.hpp"
+#include "vt_thread_pool.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace vt
+{
+	// One part of a graphics pipeline, destroyed with the last pipeline linked from it
+	struct VtPipelineLibrary
+	{
+		VtPipelineLibrary(VkDevice device, VkPipeline pipeline) : device{ device }, pipeline{ pipeline } {}
+		~VtPipelineLibrary() { vkDestroyPipeline(device, pipeline, nullptr); }
+
+		VtPipelineLibrary(const VtPipelineLibrary&) = delete;
+		VtPipelineLibrary& operator=(const VtPipelineLibrary&) = delete;
+
+		VkDevice device;
+		VkPipeline pipeline;
+	};
+
+	class VtPipelineCompiler
+	{
+	public:
+		// 0 leaves one hardware thread to the main thread
+		VtPipelineCompiler(VkDevice device, VtPipelineCache& pipelineCache, bool graphicsPipelineLibrarySupported, uint32_t threadCount = 0);
+		~VtPipelineCompiler();
+
+		VtPipelineCompiler(const VtPipelineCompiler&) = delete;
+		VtPipelineCompiler& operator=(const VtPipelineCompiler&) = delete;
+
+		// Runs job on a compilation thread with the worker cache it has to create its pipelines with.
+		// An exception thrown by the job is rethrown by get() on the returned future
+		std::shared_future<void> submit(std::function<void(VkPipelineCache)> job);
+		bool isIdle() const { return pendingJobs.load() == 0; }
+		// Blocks until every submitted job, and the jobs they submitted, have finished
+		void waitIdle();
+
+		bool usesGraphicsPipelineLibrary() const { return graphicsPipelineLibrarySupported; }
+		// Library for key, created by create on a miss. The key has to cover every state the library is built from,
+		// handles included: a library only outlives its layout and render pass if a pipeline using them is still alive
+		std::shared_ptr<VtPipelineLibrary> getLibrary(uint64_t key, const std::function<VkPipeline()>& create);
+
+	private:
+		VkDevice device;
+		VtPipelineCache& pipelineCache;
+		bool graphicsPipelineLibrarySupported;
+
+		std::mutex libraryMutex;
+		std::unordered_map<uint64_t, std::weak_ptr<VtPipelineLibrary>> libraries;
+
+		std::atomic<uint32_t> pendingJobs{ 0 };
+		// Last member, its threads are joined before the rest is destroyed
+		VtThreadPool threadPool;
+	};
+}
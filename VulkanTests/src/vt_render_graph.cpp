@@ -0,0 +1,1014 @@
+#include "vt_render_graph.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <stdexcept>
+
+namespace vt
+{
+	namespace
+	{
+		bool isDepthFormat(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		//Formats the passes use, others are counted as 4 bytes
+		VkDeviceSize getTexelSize(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return 8;
+			case VK_FORMAT_R8G8_UNORM:
+			case VK_FORMAT_R16_SFLOAT:
+			case VK_FORMAT_D16_UNORM:
+				return 2;
+			case VK_FORMAT_R8_UNORM:
+				return 1;
+			default:
+				return 4;
+			}
+		}
+
+		double toMegabytes(VkDeviceSize bytes)
+		{
+			return static_cast<double>(bytes) / (1024.0 * 1024.0);
+		}
+
+		bool hasStencilComponent(VkFormat format)
+		{
+			return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		}
+
+		VkAttachmentLoadOp toLoadOp(VtGraphLoad load)
+		{
+			switch (load)
+			{
+			case VtGraphLoad::Clear:
+				return VK_ATTACHMENT_LOAD_OP_CLEAR;
+			case VtGraphLoad::Load:
+				return VK_ATTACHMENT_LOAD_OP_LOAD;
+			default:
+				return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			}
+		}
+
+		void setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent)
+		{
+			VkViewport viewport{};
+			viewport.x = 0.0f;
+			viewport.y = 0.0f;
+			viewport.width = static_cast<float>(extent.width);
+			viewport.height = static_cast<float>(extent.height);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+			VkRect2D scissor{ {0, 0}, extent };
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		}
+	}
+
+	void VtRenderGraph::PassBuilder::writeColor(VtGraphResource resource, VtGraphLoad load, VkClearColorValue clearColor)
+	{
+		Access access{};
+		access.resource = resource;
+		access.type = AccessType::ColorAttachment;
+		access.load = load;
+		access.clearValue.color = clearColor;
+		graph.addAccess(pass, access);
+	}
+
+	void VtRenderGraph::PassBuilder::writeDepth(VtGraphResource resource, VtGraphLoad load, VkClearDepthStencilValue clearDepth)
+	{
+		Access access{};
+		access.resource = resource;
+		access.type = AccessType::DepthAttachment;
+		access.load = load;
+		access.clearValue.depthStencil = clearDepth;
+		graph.addAccess(pass, access);
+	}
+
+	void VtRenderGraph::PassBuilder::sample(VtGraphResource resource, VkPipelineStageFlags stages)
+	{
+		Access access{};
+		access.resource = resource;
+		access.type = AccessType::Sampled;
+		access.stages = stages;
+		graph.addAccess(pass, access);
+	}
+
+	void VtRenderGraph::PassBuilder::readInput(VtGraphResource resource)
+	{
+		Access access{};
+		access.resource = resource;
+		access.type = AccessType::InputAttachment;
+		access.stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		graph.addAccess(pass, access);
+	}
+
+	void VtRenderGraph::PassBuilder::readDepthInput(VtGraphResource resource)
+	{
+		Access access{};
+		access.resource = resource;
+		access.type = AccessType::InputAttachment;
+		access.depthTest = true;
+		access.stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		graph.addAccess(pass, access);
+	}
+
+	void VtRenderGraph::PassBuilder::nextSubpass()
+	{
+		assert(!graph.passes[pass].compute && "Compute passes have no subpass");
+		graph.passes[pass].subpassContents.push_back(VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	void VtRenderGraph::PassBuilder::setSideEffect()
+	{
+		graph.passes[pass].sideEffect = true;
+	}
+
+	void VtRenderGraph::PassBuilder::setSecondaryCommandBuffers(bool enabled)
+	{
+		graph.passes[pass].subpassContents.back() = enabled ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+	}
+
+	VtRenderGraph::VtRenderGraph(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef) : device{ deviceRef }, swapchain{ swapchainRef }, attachmentPool{ deviceRef }
+	{
+	}
+
+	VtRenderGraph::~VtRenderGraph()
+	{
+		cleanFramebuffers();
+		cleanImages();
+		for (auto& pass : passes)
+		{
+			vkDestroyRenderPass(device.device(), pass.renderPass, nullptr);
+		}
+	}
+
+	VtGraphResource VtRenderGraph::createTexture(const std::string& name, const VtGraphTextureInfo& info)
+	{
+		assert(!compiled && "Resources must be created before compiling the graph");
+
+		Resource resource{};
+		resource.name = name;
+		resource.info = info;
+		resources.push_back(resource);
+		return static_cast<VtGraphResource>(resources.size() - 1);
+	}
+
+	VtGraphResource VtRenderGraph::importSwapchain()
+	{
+		assert(!compiled && "Resources must be created before compiling the graph");
+		assert(std::none_of(resources.begin(), resources.end(), [](const Resource& resource) { return resource.imported; }) && "Swapchain already imported");
+
+		Resource resource{};
+		resource.name = "Swapchain";
+		resource.info.format = swapchain->getSwapChainImageFormat();
+		resource.imported = true;
+		resources.push_back(resource);
+		return static_cast<VtGraphResource>(resources.size() - 1);
+	}
+
+	VtGraphPass VtRenderGraph::addGraphicsPass(const std::string& name, const SetupCallback& setup, ExecuteCallback execute)
+	{
+		return addPass(name, false, setup, std::move(execute));
+	}
+
+	VtGraphPass VtRenderGraph::addComputePass(const std::string& name, const SetupCallback& setup, ExecuteCallback execute)
+	{
+		return addPass(name, true, setup, std::move(execute));
+	}
+
+	VtGraphPass VtRenderGraph::addPass(const std::string& name, bool compute, const SetupCallback& setup, ExecuteCallback execute)
+	{
+		assert(!compiled && "Passes must be added before compiling the graph");
+
+		VtGraphPass index = static_cast<VtGraphPass>(passes.size());
+		passes.emplace_back();
+		passes.back().name = name;
+		passes.back().compute = compute;
+		passes.back().execute = std::move(execute);
+
+		PassBuilder builder{ *this, index };
+		setup(builder);
+
+		assert((compute || std::any_of(passes[index].accesses.begin(), passes[index].accesses.end(), [](const Access& access) { return access.type != AccessType::Sampled; }))
+			&& "Graphics pass without attachment");
+		return index;
+	}
+
+	void VtRenderGraph::addAccess(VtGraphPass pass, const Access& passAccess)
+	{
+		assert(passAccess.resource < resources.size() && "Unknown graph resource");
+		auto& accesses = passes[pass].accesses;
+		assert((!passes[pass].compute || passAccess.type == AccessType::Sampled) && "Compute passes can only sample images");
+
+		Access access = passAccess;
+		access.subpass = static_cast<uint32_t>(passes[pass].subpassContents.size() - 1);
+		if (access.type == AccessType::InputAttachment)
+		{
+			//Same attachment as the write, the render pass makes it visible to the later subpass
+			assert(std::any_of(accesses.begin(), accesses.end(), [&](const Access& other)
+				{
+					return other.resource == access.resource && other.type != AccessType::Sampled && other.subpass < access.subpass;
+				}) && "Input attachments must be written by an earlier subpass of the pass");
+		}
+		else
+		{
+			assert(std::none_of(accesses.begin(), accesses.end(), [&](const Access& other) { return other.resource == access.resource; }) && "A pass accesses a resource once");
+		}
+		accesses.push_back(access);
+	}
+
+	VtRenderGraph::AccessInfo VtRenderGraph::getAccessInfo(const Access& access)
+	{
+		switch (access.type)
+		{
+		case AccessType::ColorAttachment:
+			return {
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+		case AccessType::DepthAttachment:
+			return {
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+		case AccessType::InputAttachment:
+			if (access.depthTest)
+			{
+				//Both uses of the attachment in the subpass need the same layout, the read-only depth one allows input reads
+				return {
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+					0 };
+			}
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT, 0 };
+		default:
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, access.stages, VK_ACCESS_SHADER_READ_BIT, 0 };
+		}
+	}
+
+	bool VtRenderGraph::isReadAfter(VtGraphResource resource, uint32_t position) const
+	{
+		for (uint32_t later = position + 1; later < executionOrder.size(); later++)
+		{
+			for (const Access& access : passes[executionOrder[later]].accesses)
+			{
+				if (access.resource != resource) continue;
+				//The first later write decides, a cleared attachment does not need the previous content
+				return access.type == AccessType::Sampled || access.load == VtGraphLoad::Load;
+			}
+		}
+		return false;
+	}
+
+	void VtRenderGraph::compile()
+	{
+		assert(!compiled && "Render graph already compiled");
+
+		cullPasses();
+		computeLifetimes();
+		planBarriers();
+		createRenderPasses();
+		createImages();
+		createFramebuffers();
+		compiled = true;
+	}
+
+	void VtRenderGraph::cullPasses()
+	{
+		//Walking back from the passes with visible results, a pass is kept when a kept pass after it reads what it writes
+		std::vector<bool> needed(resources.size(), false);
+		for (size_t i = passes.size(); i-- > 0;)
+		{
+			Pass& pass = passes[i];
+			bool alive = pass.sideEffect;
+			for (const Access& access : pass.accesses)
+			{
+				if (access.type == AccessType::Sampled || access.type == AccessType::InputAttachment) continue;
+				if (needed[access.resource] || resources[access.resource].imported) alive = true;
+			}
+			pass.culled = !alive;
+			if (!alive) continue;
+
+			//Content written before a cleared attachment is never seen, input attachments only read the pass own writes
+			for (const Access& access : pass.accesses)
+			{
+				if (access.type == AccessType::InputAttachment) continue;
+				needed[access.resource] = access.type == AccessType::Sampled || access.load == VtGraphLoad::Load;
+			}
+		}
+
+		executionOrder.clear();
+		for (VtGraphPass i = 0; i < passes.size(); i++)
+		{
+			if (!passes[i].culled) executionOrder.push_back(i);
+		}
+	}
+
+	void VtRenderGraph::computeLifetimes()
+	{
+		for (auto& resource : resources)
+		{
+			resource.firstPass = UINT32_MAX;
+			resource.lastPass = 0;
+			resource.usage = 0;
+		}
+
+		for (uint32_t position = 0; position < executionOrder.size(); position++)
+		{
+			for (const Access& access : passes[executionOrder[position]].accesses)
+			{
+				Resource& resource = resources[access.resource];
+				resource.firstPass = std::min(resource.firstPass, position);
+				resource.lastPass = std::max(resource.lastPass, position);
+				switch (access.type)
+				{
+				case AccessType::ColorAttachment:
+					resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+					break;
+				case AccessType::DepthAttachment:
+					resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+					break;
+				case AccessType::Sampled:
+					resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+					break;
+				case AccessType::InputAttachment:
+					resource.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+					break;
+				}
+			}
+		}
+
+		//Written and read within one render pass, the content lives in tile memory only
+		for (auto& resource : resources)
+		{
+			resource.transient = !resource.imported && resource.firstPass == resource.lastPass && (resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT) == 0;
+			if (resource.transient) resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+	}
+
+	void VtRenderGraph::planBarriers()
+	{
+		//State of every image while walking through the frame, transient images start it with undefined content
+		struct ImageState
+		{
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags writeStages = 0; // last write or layout transition
+			VkAccessFlags writeAccess = 0;
+			VkPipelineStageFlags readStages = 0; // reads that already waited for it
+		};
+		std::vector<ImageState> states(resources.size());
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			//The swapchain image acquire semaphore is waited on at this stage
+			if (resources[i].imported) states[i].writeStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		}
+
+		//Everything done to images that are not used anymore, an image starting later may reuse their memory
+		VkPipelineStageFlags retiredStages = 0;
+		VkAccessFlags retiredAccess = 0;
+
+		for (uint32_t position = 0; position < executionOrder.size(); position++)
+		{
+			Pass& pass = passes[executionOrder[position]];
+			pass.srcStageMask = 0;
+			pass.dstStageMask = 0;
+			pass.barriers.clear();
+
+			for (Access& access : pass.accesses)
+			{
+				const Resource& resource = resources[access.resource];
+				ImageState& state = states[access.resource];
+				AccessInfo info = getAccessInfo(access);
+				access.discardInRenderPass = false;
+
+				if (access.type == AccessType::InputAttachment)
+				{
+					//Covered by the subpass dependency, the render pass leaves the image in the input layout
+					state.layout = info.layout;
+					//The next write waits for the input reads
+					state.writeStages |= info.stageMask;
+					continue;
+				}
+
+				ImageBarrier barrier{ access.resource, state.layout, info.layout, state.writeAccess, info.accessMask };
+				VkPipelineStageFlags srcStages = 0;
+				if (info.writeAccessMask != 0)
+				{
+					bool firstUse = !resource.imported && position == resource.firstPass;
+					assert((!firstUse || access.load != VtGraphLoad::Load) && "Transient image loaded before being written");
+
+					//Write after write and write after read
+					srcStages = state.writeStages | state.readStages;
+					if (access.load != VtGraphLoad::Load)
+					{
+						barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					}
+					if (firstUse)
+					{
+						srcStages |= retiredStages;
+						barrier.srcAccessMask |= retiredAccess;
+						//Nothing to wait for, the render pass discards the content itself
+						access.discardInRenderPass = srcStages == 0;
+					}
+
+					state.layout = info.layout;
+					state.writeStages = info.stageMask;
+					state.writeAccess = info.writeAccessMask;
+					state.readStages = 0;
+					if (access.discardInRenderPass) continue;
+				}
+				else
+				{
+					assert(state.writeStages != 0 && "Image sampled before being written");
+					if (state.layout == info.layout)
+					{
+						//Already visible to these stages
+						if ((state.readStages & info.stageMask) == info.stageMask) continue;
+						srcStages = state.writeStages;
+					}
+					else
+					{
+						//The transition also waits for the reads done in the previous layout
+						srcStages = state.writeStages | state.readStages;
+						state.readStages = 0;
+						//Later reads from other stages chain on the stages that waited for the transition
+						state.writeStages |= info.stageMask;
+					}
+					state.layout = info.layout;
+					state.readStages |= info.stageMask;
+				}
+
+				pass.srcStageMask |= srcStages;
+				pass.dstStageMask |= info.stageMask;
+				pass.barriers.push_back(barrier);
+			}
+
+			if (!pass.barriers.empty() && pass.srcStageMask == 0)
+			{
+				//Only layout transitions of discarded content
+				pass.srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			}
+
+			for (size_t i = 0; i < resources.size(); i++)
+			{
+				const Resource& resource = resources[i];
+				if (resource.imported || resource.firstPass == UINT32_MAX || resource.lastPass != position) continue;
+				retiredStages |= states[i].writeStages | states[i].readStages;
+				retiredAccess |= states[i].writeAccess;
+			}
+		}
+
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			//The render pass of its last write moves it to PRESENT_SRC
+			if (resources[i].imported && states[i].layout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+			{
+				throw std::runtime_error("the swapchain image must be last used as a color attachment!");
+			}
+		}
+	}
+
+	void VtRenderGraph::createRenderPasses()
+	{
+		for (uint32_t position = 0; position < executionOrder.size(); position++)
+		{
+			Pass& pass = passes[executionOrder[position]];
+			if (pass.compute) continue;
+
+			const uint32_t subpassCount = static_cast<uint32_t>(pass.subpassContents.size());
+			std::vector<VkAttachmentDescription> attachmentDescs;
+			std::vector<const Access*> attachmentWrites; // access declaring each attachment
+			std::vector<std::vector<VkAttachmentReference>> colorReferences(subpassCount);
+			std::vector<std::vector<VkAttachmentReference>> inputReferences(subpassCount);
+			std::vector<VkAttachmentReference> depthReferences(subpassCount, { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+			std::vector<VkSubpassDependency> dependencies;
+			pass.clearValues.clear();
+			pass.writesSwapchain = false;
+
+			for (const Access& access : pass.accesses)
+			{
+				if (access.type == AccessType::Sampled) continue;
+
+				const Resource& resource = resources[access.resource];
+				AccessInfo info = getAccessInfo(access);
+
+				if (access.type == AccessType::InputAttachment)
+				{
+					auto write = std::find_if(attachmentWrites.begin(), attachmentWrites.end(), [&](const Access* other) { return other->resource == access.resource; });
+					uint32_t attachmentIndex = static_cast<uint32_t>(write - attachmentWrites.begin());
+					AccessInfo writeInfo = getAccessInfo(**write);
+
+					inputReferences[access.subpass].push_back({ attachmentIndex, info.layout });
+					attachmentDescs[attachmentIndex].finalLayout = info.layout;
+					if (access.depthTest)
+					{
+						assert((*write)->type == AccessType::DepthAttachment && "Depth input of a color attachment");
+						assert(depthReferences[access.subpass].attachment == VK_ATTACHMENT_UNUSED && "One depth attachment per subpass");
+						depthReferences[access.subpass] = { attachmentIndex, info.layout };
+					}
+
+					//By region: a fragment only reads the pixel written at its own position, the tile is never flushed in between
+					auto dependency = std::find_if(dependencies.begin(), dependencies.end(), [&](const VkSubpassDependency& other)
+						{
+							return other.srcSubpass == (*write)->subpass && other.dstSubpass == access.subpass;
+						});
+					if (dependency == dependencies.end())
+					{
+						VkSubpassDependency newDependency{};
+						newDependency.srcSubpass = (*write)->subpass;
+						newDependency.dstSubpass = access.subpass;
+						newDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+						dependencies.push_back(newDependency);
+						dependency = dependencies.end() - 1;
+					}
+					dependency->srcStageMask |= writeInfo.stageMask;
+					dependency->srcAccessMask |= writeInfo.writeAccessMask;
+					dependency->dstStageMask |= info.stageMask;
+					dependency->dstAccessMask |= info.accessMask;
+					continue;
+				}
+
+				//Images are already in the attachment layout, transitions are done by the barriers of the graph
+				VkAttachmentDescription attachmentDesc{};
+				attachmentDesc.format = resource.info.format;
+				attachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
+				attachmentDesc.loadOp = toLoadOp(access.load);
+				//Content read by no later pass does not need to leave tile memory
+				attachmentDesc.storeOp = resource.imported || isReadAfter(access.resource, position) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachmentDesc.initialLayout = access.discardInRenderPass ? VK_IMAGE_LAYOUT_UNDEFINED : info.layout;
+				attachmentDesc.finalLayout = info.layout;
+				if (resource.imported)
+				{
+					pass.writesSwapchain = true;
+					if (position == resource.lastPass)
+					{
+						attachmentDesc.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+					}
+				}
+
+				uint32_t attachmentIndex = static_cast<uint32_t>(attachmentDescs.size());
+				attachmentDescs.push_back(attachmentDesc);
+				attachmentWrites.push_back(&access);
+				pass.clearValues.push_back(access.clearValue);
+				if (access.type == AccessType::ColorAttachment)
+				{
+					colorReferences[access.subpass].push_back({ attachmentIndex, info.layout });
+				}
+				else
+				{
+					assert(depthReferences[access.subpass].attachment == VK_ATTACHMENT_UNUSED && "One depth attachment per subpass");
+					depthReferences[access.subpass] = { attachmentIndex, info.layout };
+				}
+			}
+
+			std::vector<VkSubpassDescription> subpasses(subpassCount);
+			for (uint32_t i = 0; i < subpassCount; i++)
+			{
+				VkSubpassDescription& subpass = subpasses[i];
+				subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				subpass.inputAttachmentCount = static_cast<uint32_t>(inputReferences[i].size());
+				subpass.pInputAttachments = inputReferences[i].data();
+				subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences[i].size());
+				subpass.pColorAttachments = colorReferences[i].data();
+				subpass.pDepthStencilAttachment = depthReferences[i].attachment != VK_ATTACHMENT_UNUSED ? &depthReferences[i] : nullptr;
+			}
+
+			//No external dependency, the barrier before the pass covers everything it touches
+			VkRenderPassCreateInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
+			renderPassInfo.pAttachments = attachmentDescs.data();
+			renderPassInfo.subpassCount = subpassCount;
+			renderPassInfo.pSubpasses = subpasses.data();
+			renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+			renderPassInfo.pDependencies = dependencies.data();
+
+			VK_CHECK_RESULT(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &pass.renderPass));
+		}
+	}
+
+	void VtRenderGraph::createImages()
+	{
+		VkExtent2D swapchainExtent = swapchain->getSwapChainExtent();
+		for (auto& resource : resources)
+		{
+			//Only used by culled passes
+			if (resource.firstPass == UINT32_MAX) continue;
+
+			if (resource.imported)
+			{
+				resource.extent = swapchainExtent;
+				resource.images.resize(swapchain->imageCount());
+				resource.views.resize(swapchain->imageCount());
+				for (size_t i = 0; i < resource.images.size(); i++)
+				{
+					resource.images[i] = swapchain->getImage(static_cast<int>(i));
+					resource.views[i] = swapchain->getImageView(static_cast<int>(i));
+				}
+				continue;
+			}
+
+			resource.extent.width = std::max(1u, static_cast<uint32_t>(swapchainExtent.width * resource.info.scale));
+			resource.extent.height = std::max(1u, static_cast<uint32_t>(swapchainExtent.height * resource.info.scale));
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = resource.info.format;
+			imageInfo.extent.width = resource.extent.width;
+			imageInfo.extent.height = resource.extent.height;
+			imageInfo.extent.depth = 1;
+			imageInfo.mipLevels = resource.info.mipLevels;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = resource.usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = resource.info.format;
+			viewInfo.subresourceRange.aspectMask = isDepthFormat(resource.info.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = resource.info.mipLevels;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = 1;
+
+			resource.images.resize(device.getFramesInFlight());
+			resource.views.resize(device.getFramesInFlight());
+			for (uint32_t i = 0; i < device.getFramesInFlight(); i++)
+			{
+				resource.images[i] = attachmentPool.createImage(i, imageInfo, resource.firstPass, resource.lastPass);
+
+				viewInfo.image = resource.images[i];
+				VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.views[i]));
+			}
+		}
+	}
+
+	void VtRenderGraph::cleanImages()
+	{
+		for (auto& resource : resources)
+		{
+			//Swapchain images belong to the swapchain
+			if (!resource.imported)
+			{
+				for (VkImageView view : resource.views)
+				{
+					vkDestroyImageView(device.device(), view, nullptr);
+				}
+				for (VkImage image : resource.images)
+				{
+					attachmentPool.destroyImage(image);
+				}
+			}
+			resource.images.clear();
+			resource.views.clear();
+		}
+	}
+
+	void VtRenderGraph::createFramebuffers()
+	{
+		const uint32_t imageCount = static_cast<uint32_t>(swapchain->imageCount());
+		std::vector<VkImageView> attachments;
+		for (VtGraphPass index : executionOrder)
+		{
+			Pass& pass = passes[index];
+			if (pass.compute) continue;
+
+			//Any frame in flight can present to any swapchain image
+			const uint32_t framebufferCount = device.getFramesInFlight() * (pass.writesSwapchain ? imageCount : 1);
+			pass.framebuffers.resize(framebufferCount);
+			for (uint32_t i = 0; i < framebufferCount; i++)
+			{
+				uint32_t frameIndex = pass.writesSwapchain ? i / imageCount : i;
+				uint32_t imageIndex = pass.writesSwapchain ? i % imageCount : 0;
+
+				attachments.clear();
+				for (const Access& access : pass.accesses)
+				{
+					if (access.type == AccessType::Sampled || access.type == AccessType::InputAttachment) continue;
+
+					const Resource& resource = resources[access.resource];
+					attachments.push_back(resource.views[resource.imported ? imageIndex : frameIndex]);
+					pass.extent = resource.extent;
+				}
+
+				VkFramebufferCreateInfo framebufferInfo = {};
+				framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebufferInfo.renderPass = pass.renderPass;
+				framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+				framebufferInfo.pAttachments = attachments.data();
+				framebufferInfo.width = pass.extent.width;
+				framebufferInfo.height = pass.extent.height;
+				framebufferInfo.layers = 1;
+
+				if (vkCreateFramebuffer(
+					device.device(),
+					&framebufferInfo,
+					nullptr,
+					&pass.framebuffers[i]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create framebuffer!");
+				}
+			}
+		}
+	}
+
+	void VtRenderGraph::cleanFramebuffers()
+	{
+		for (auto& pass : passes)
+		{
+			for (auto framebuffer : pass.framebuffers)
+			{
+				vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+			}
+			pass.framebuffers.clear();
+		}
+	}
+
+	void VtRenderGraph::retireImages()
+	{
+		VkDevice vkDevice = device.device();
+		for (auto& resource : resources)
+		{
+			if (!resource.imported)
+			{
+				std::vector<VkImageView> views = resource.views;
+				device.getDeletionQueue().retire([vkDevice, views]()
+					{
+						for (VkImageView view : views)
+						{
+							vkDestroyImageView(vkDevice, view, nullptr);
+						}
+					});
+				for (VkImage image : resource.images)
+				{
+					attachmentPool.retireImage(image);
+				}
+			}
+			resource.images.clear();
+			resource.views.clear();
+		}
+	}
+
+	void VtRenderGraph::retireFramebuffers()
+	{
+		VkDevice vkDevice = device.device();
+		for (auto& pass : passes)
+		{
+			std::vector<VkFramebuffer> framebuffers = pass.framebuffers;
+			device.getDeletionQueue().retire([vkDevice, framebuffers]()
+				{
+					for (auto framebuffer : framebuffers)
+					{
+						vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+					}
+				});
+			pass.framebuffers.clear();
+		}
+	}
+
+	void VtRenderGraph::recreateSwapchain(std::shared_ptr<VtSwapChain> newSwapchain)
+	{
+		assert(compiled && "Render graph resized before compile");
+
+		//Render passes are kept, only the images and framebuffers depend on the extent and the swapchain images
+		swapchain = newSwapchain;
+		retireFramebuffers();
+		retireImages();
+		createImages();
+		createFramebuffers();
+	}
+
+	void VtRenderGraph::execute(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex)
+	{
+		assert(compiled && "Render graph executed before compile");
+
+		const uint32_t imageCount = static_cast<uint32_t>(swapchain->imageCount());
+		if (passTimer) passTimer->reset(commandBuffer, frameIndex);
+		for (uint32_t position = 0; position < executionOrder.size(); position++)
+		{
+			const Pass& pass = passes[executionOrder[position]];
+			if (passTimer) passTimer->writeTimestamp(commandBuffer, frameIndex, position, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+			recordBarrier(commandBuffer, pass, frameIndex, imageIndex);
+
+			PassContext context{ commandBuffer, frameIndex, imageIndex, pass.renderPass, 0, VK_NULL_HANDLE, pass.extent };
+			if (pass.compute)
+			{
+				pass.execute(context);
+				continue;
+			}
+
+			context.framebuffer = pass.framebuffers[pass.writesSwapchain ? frameIndex * imageCount + imageIndex : frameIndex];
+
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = pass.renderPass;
+			renderPassInfo.framebuffer = context.framebuffer;
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = pass.extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+			renderPassInfo.pClearValues = pass.clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass.subpassContents[0]);
+
+			for (uint32_t subpass = 0; subpass < pass.subpassContents.size(); subpass++)
+			{
+				if (subpass > 0) vkCmdNextSubpass(commandBuffer, pass.subpassContents[subpass]);
+
+				//Secondary command buffers set the viewport themselves, the dynamic state is undefined after them
+				if (pass.subpassContents[subpass] == VK_SUBPASS_CONTENTS_INLINE)
+				{
+					setViewportAndScissor(commandBuffer, pass.extent);
+				}
+
+				context.subpass = subpass;
+				pass.execute(context);
+			}
+
+			vkCmdEndRenderPass(commandBuffer);
+		}
+		if (passTimer) passTimer->writeTimestamp(commandBuffer, frameIndex, static_cast<uint32_t>(executionOrder.size()), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+	}
+
+	void VtRenderGraph::recordBarrier(VkCommandBuffer commandBuffer, const Pass& pass, int frameIndex, int imageIndex)
+	{
+		if (pass.barriers.empty()) return;
+
+		imageBarriers.clear();
+		for (const ImageBarrier& planned : pass.barriers)
+		{
+			const Resource& resource = resources[planned.resource];
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = planned.srcAccessMask;
+			barrier.dstAccessMask = planned.dstAccessMask;
+			barrier.oldLayout = planned.oldLayout;
+			barrier.newLayout = planned.newLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = getImage(planned.resource, frameIndex, imageIndex);
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			if (isDepthFormat(resource.info.format))
+			{
+				barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+				if (hasStencilComponent(resource.info.format))
+				{
+					barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+				}
+			}
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = resource.info.mipLevels;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+			imageBarriers.push_back(barrier);
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, pass.srcStageMask, pass.dstStageMask, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	VkImage VtRenderGraph::getImage(VtGraphResource resource, int frameIndex, int imageIndex) const
+	{
+		const Resource& graphResource = resources[resource];
+		return graphResource.images[graphResource.imported ? imageIndex : frameIndex];
+	}
+
+	bool VtRenderGraph::isCulled(VtGraphPass pass) const
+	{
+		assert(compiled && "Passes are culled when compiling");
+		return passes[pass].culled;
+	}
+
+	VkRenderPass VtRenderGraph::getRenderPass(VtGraphPass pass) const
+	{
+		assert(compiled && "Render passes are created when compiling");
+		return passes[pass].renderPass;
+	}
+
+	VkImageView VtRenderGraph::getImageView(VtGraphResource resource, uint32_t frameIndex) const
+	{
+		assert(compiled && "Images are created when compiling");
+		assert(!resources[resource].imported && "Use the swapchain image views");
+		assert(frameIndex < resources[resource].views.size() && "frameIndex out of range");
+		return resources[resource].views[frameIndex];
+	}
+
+	VtRenderGraph::Stats VtRenderGraph::getStats() const
+	{
+		Stats stats{};
+		stats.passCount = static_cast<uint32_t>(passes.size());
+		stats.culledPassCount = static_cast<uint32_t>(passes.size() - executionOrder.size());
+		for (VtGraphPass index : executionOrder)
+		{
+			if (passes[index].barriers.empty()) continue;
+			stats.barrierCount++;
+			stats.imageBarrierCount += static_cast<uint32_t>(passes[index].barriers.size());
+		}
+		for (const auto& resource : resources)
+		{
+			if (resource.transient && resource.firstPass != UINT32_MAX) stats.transientCount++;
+		}
+		stats.memory = attachmentPool.getStats();
+		return stats;
+	}
+
+	void VtRenderGraph::printStats(std::ostream& stream) const
+	{
+		Stats stats = getStats();
+
+		stream << "Render graph: " << stats.passCount - stats.culledPassCount << " passes";
+		if (stats.culledPassCount > 0)
+		{
+			stream << " (culled:";
+			for (const auto& pass : passes)
+			{
+				if (pass.culled) stream << " " << pass.name;
+			}
+			stream << ")";
+		}
+		stream << " | " << stats.barrierCount << " pipeline barriers with " << stats.imageBarrierCount << " image barriers per frame"
+			<< " | " << stats.transientCount << " transient attachments" << std::endl;
+		attachmentPool.printStats(stream);
+	}
+
+	VkDeviceSize VtRenderGraph::getImageBytes(const Resource& resource) const
+	{
+		VkDeviceSize bytes = 0;
+		VkExtent2D extent = resource.extent;
+		for (uint32_t level = 0; level < resource.info.mipLevels; level++)
+		{
+			bytes += static_cast<VkDeviceSize>(extent.width) * extent.height * getTexelSize(resource.info.format);
+			extent = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+		}
+		return bytes;
+	}
+
+	void VtRenderGraph::enablePassTimings()
+	{
+		assert(compiled && "Pass timings enabled before compile");
+		passTimer = std::make_unique<VtGpuTimer>(device, static_cast<uint32_t>(executionOrder.size()) + 1);
+	}
+
+	void VtRenderGraph::printPassTimings(std::ostream& stream, int frameIndex)
+	{
+		assert(passTimer && "Pass timings are not enabled");
+
+		std::ios_base::fmtflags flags = stream.flags();
+		stream << std::fixed << std::setprecision(2);
+		for (uint32_t position = 0; position < executionOrder.size(); position++)
+		{
+			const Pass& pass = passes[executionOrder[position]];
+
+			//Input attachments and attachments neither loaded nor stored stay in tile memory
+			VkDeviceSize readBytes = 0;
+			VkDeviceSize writeBytes = 0;
+			for (const Access& access : pass.accesses)
+			{
+				const Resource& resource = resources[access.resource];
+				if (access.type == AccessType::Sampled)
+				{
+					readBytes += getImageBytes(resource);
+				}
+				else if (access.type != AccessType::InputAttachment)
+				{
+					if (access.load == VtGraphLoad::Load) readBytes += getImageBytes(resource);
+					if (resource.imported || isReadAfter(access.resource, position)) writeBytes += getImageBytes(resource);
+				}
+			}
+
+			float milliseconds = passTimer->getElapsedMilliseconds(frameIndex, position, position + 1);
+			stream << "  " << pass.name << ": ";
+			if (milliseconds >= 0.f) stream << milliseconds << " ms GPU | ";
+			stream << toMegabytes(readBytes) << " MB read | " << toMegabytes(writeBytes) << " MB written" << std::endl;
+		}
+		stream.flags(flags);
+	}
+}
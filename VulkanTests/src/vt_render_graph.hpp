@@ -0,0 +1,246 @@
+/*
+Declarative description of the passes of a frame.
+Passes declare the images they write and read in a setup callback and record their commands in an execute callback.
+compile() culls the passes whose results are never used, plans one batched pipeline barrier before each pass, creates one
+render pass and its framebuffers per graphics pass and allocates the transient images from its own attachment pool, with the
+execution order as lifetimes so images that are never alive at the same time share memory.
+Attachments are numbered in declaration order: a pipeline built against any render pass with the same formats in the same
+order (and the same subpasses) is compatible with the graph pass.
+A graphics pass can be split in subpasses, a later subpass reading the attachments of an earlier one as input attachments
+at the same pixel. A depth input can stay bound read-only as the depth attachment of the later subpass for its depth tests. Attachments that never leave their render pass are created TRANSIENT and never stored.
+Only images are tracked, buffers shared between passes are still synchronized by the systems that own them.
+*/
+
+#pragma once
+
+#include "vt_device.hpp"
+#include "vt_gpu_timer.hpp"
+#include "vt_swap_chain.hpp"
+#include "vt_transient_attachment_pool.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vt
+{
+	using VtGraphResource = uint32_t;
+	using VtGraphPass = uint32_t;
+
+	// What a pass does with the previous content of an attachment it writes
+	enum class VtGraphLoad
+	{
+		Clear,
+		Load,
+		DontCare
+	};
+
+	// Transient image of the graph, sized relatively to the swapchain
+	struct VtGraphTextureInfo
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		float scale = 1.f;
+		uint32_t mipLevels = 1;
+	};
+
+	class VtRenderGraph
+	{
+	public:
+		struct PassContext
+		{
+			VkCommandBuffer commandBuffer;
+			int frameIndex;
+			int imageIndex;
+			// Graphics passes only, the render pass is begun before execute and ended after it
+			VkRenderPass renderPass;
+			uint32_t subpass; // execute is called once per subpass
+			VkFramebuffer framebuffer;
+			VkExtent2D extent;
+		};
+		using ExecuteCallback = std::function<void(const PassContext&)>;
+
+		class PassBuilder
+		{
+		public:
+			void writeColor(VtGraphResource resource, VtGraphLoad load, VkClearColorValue clearColor = {});
+			void writeDepth(VtGraphResource resource, VtGraphLoad load, VkClearDepthStencilValue clearDepth = { 1.f, 0 });
+			void sample(VtGraphResource resource, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			// Attachment written by an earlier subpass of the pass, read by the fragment shader at the same pixel
+			void readInput(VtGraphResource resource);
+			// Depth input attachment also bound read-only as the depth attachment of the subpass, for depth bounds tests
+			void readDepthInput(VtGraphResource resource);
+			// The following accesses belong to a new subpass of the same render pass
+			void nextSubpass();
+			// The pass is never culled, for passes writing buffers the graph does not track
+			void setSideEffect();
+			// Only secondary command buffers are executed in the current subpass, they set the viewport themselves
+			void setSecondaryCommandBuffers(bool enabled);
+
+		private:
+			friend class VtRenderGraph;
+			PassBuilder(VtRenderGraph& graph, VtGraphPass pass) : graph{ graph }, pass{ pass } {}
+
+			VtRenderGraph& graph;
+			VtGraphPass pass;
+		};
+		using SetupCallback = std::function<void(PassBuilder&)>;
+
+		struct Stats
+		{
+			uint32_t passCount = 0;
+			uint32_t culledPassCount = 0;
+			uint32_t barrierCount = 0; // vkCmdPipelineBarrier per frame
+			uint32_t imageBarrierCount = 0;
+			uint32_t transientCount = 0; // attachments never stored to memory
+			VtTransientAttachmentPool::Stats memory{};
+		};
+
+		VtRenderGraph(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain);
+		~VtRenderGraph();
+
+		VtRenderGraph(const VtRenderGraph&) = delete;
+		VtRenderGraph& operator=(const VtRenderGraph&) = delete;
+
+		VtGraphResource createTexture(const std::string& name, const VtGraphTextureInfo& info);
+		// Swapchain image of the frame, left in PRESENT_SRC after its last write
+		VtGraphResource importSwapchain();
+
+		// Passes execute in the order they are added
+		VtGraphPass addGraphicsPass(const std::string& name, const SetupCallback& setup, ExecuteCallback execute);
+		VtGraphPass addComputePass(const std::string& name, const SetupCallback& setup, ExecuteCallback execute);
+
+		void compile();
+		void execute(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex);
+		// Images and framebuffers follow the new extent, render passes and the barrier plan are kept
+		void recreateSwapchain(std::shared_ptr<VtSwapChain> swapchain);
+
+		bool isCompiled() const { return compiled; }
+		bool isCulled(VtGraphPass pass) const;
+		VkRenderPass getRenderPass(VtGraphPass pass) const;
+		VkImageView getImageView(VtGraphResource resource, uint32_t frameIndex) const;
+		VtTransientAttachmentPool& getAttachmentPool() { return attachmentPool; }
+
+		Stats getStats() const;
+		void printStats(std::ostream& stream) const;
+		// Timestamps around every executed pass, call after compile
+		void enablePassTimings();
+		// GPU time of each pass in the previous submission of frameIndex, with the bytes it moves to and from memory:
+		// loaded and stored attachments and one read of every sampled image. Call once the timeline has reached the frame
+		void printPassTimings(std::ostream& stream, int frameIndex);
+
+	private:
+		enum class AccessType
+		{
+			ColorAttachment,
+			DepthAttachment,
+			Sampled,
+			InputAttachment
+		};
+
+		struct Access
+		{
+			VtGraphResource resource;
+			AccessType type;
+			VtGraphLoad load = VtGraphLoad::Load;
+			VkClearValue clearValue{};
+			VkPipelineStageFlags stages = 0; // sampled only
+			uint32_t subpass = 0;
+			bool depthTest = false; // input attachment only, read-only depth attachment of its subpass as well
+			bool discardInRenderPass = false; // first use without a barrier, the render pass starts from UNDEFINED
+		};
+
+		// Layout, stages and accesses of an access type
+		struct AccessInfo
+		{
+			VkImageLayout layout;
+			VkPipelineStageFlags stageMask;
+			VkAccessFlags accessMask;
+			VkAccessFlags writeAccessMask;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			VtGraphTextureInfo info{};
+			bool imported = false;
+			bool transient = false; // only used within one render pass, lazily allocated when the device allows it
+			VkImageUsageFlags usage = 0;
+			uint32_t firstPass = UINT32_MAX; // position in the execution order
+			uint32_t lastPass = 0;
+			VkExtent2D extent{};
+			// One per frame in flight, one per swapchain image when imported
+			std::vector<VkImage> images;
+			std::vector<VkImageView> views;
+		};
+
+		struct ImageBarrier
+		{
+			VtGraphResource resource;
+			VkImageLayout oldLayout;
+			VkImageLayout newLayout;
+			VkAccessFlags srcAccessMask;
+			VkAccessFlags dstAccessMask;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			bool compute = false;
+			bool sideEffect = false;
+			bool culled = false;
+			std::vector<VkSubpassContents> subpassContents{ VK_SUBPASS_CONTENTS_INLINE };
+			std::vector<Access> accesses;
+			ExecuteCallback execute;
+
+			// Barrier recorded before the pass
+			VkPipelineStageFlags srcStageMask = 0;
+			VkPipelineStageFlags dstStageMask = 0;
+			std::vector<ImageBarrier> barriers;
+
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			bool writesSwapchain = false;
+			VkExtent2D extent{};
+			std::vector<VkClearValue> clearValues;
+			// Per frame in flight, per frame and swapchain image when the pass writes the swapchain
+			std::vector<VkFramebuffer> framebuffers;
+		};
+
+		VtGraphPass addPass(const std::string& name, bool compute, const SetupCallback& setup, ExecuteCallback execute);
+		void addAccess(VtGraphPass pass, const Access& access);
+		static AccessInfo getAccessInfo(const Access& access);
+		// Whether a pass executed after position reads the content of resource
+		bool isReadAfter(VtGraphResource resource, uint32_t position) const;
+		VkDeviceSize getImageBytes(const Resource& resource) const;
+
+		void cullPasses();
+		void computeLifetimes();
+		void planBarriers();
+		void createRenderPasses();
+		void createImages();
+		void createFramebuffers();
+		void cleanImages();
+		void cleanFramebuffers();
+		// Resize: frames in flight may still use the images and framebuffers, they go to the deletion queue
+		void retireImages();
+		void retireFramebuffers();
+
+		void recordBarrier(VkCommandBuffer commandBuffer, const Pass& pass, int frameIndex, int imageIndex);
+		VkImage getImage(VtGraphResource resource, int frameIndex, int imageIndex) const;
+
+		VtDevice& device;
+		std::shared_ptr<VtSwapChain> swapchain;
+		VtTransientAttachmentPool attachmentPool;
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<VtGraphPass> executionOrder;
+		bool compiled = false;
+
+		std::vector<VkImageMemoryBarrier> imageBarriers; // reused every pass
+		std::unique_ptr<VtGpuTimer> passTimer; // timestamp before each pass and after the last one
+	};
+}
@@ -19,8 +19,32 @@ namespace vt
 		}
 	}
 
-	VtRenderPass::VtRenderPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef) : device{deviceRef},
-		swapchain{swapchainRef}
+	void vt::VtRenderPass::retireFramebuffers(std::vector<VkFramebuffer>& retiredFramebuffers)
+	{
+		VkDevice vkDevice = device.device();
+		device.getDeletionQueue().retire([vkDevice, oldFramebuffers = retiredFramebuffers]()
+			{
+				for (auto framebuffer : oldFramebuffers) {
+					vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+				}
+			});
+		retiredFramebuffers.clear();
+	}
+
+	bool vt::VtRenderPass::keepsAttachments(VtSwapChain& newSwapchain) const
+	{
+		VkExtent2D extent = newSwapchain.getSwapChainExtent();
+		return !usesRenderGraph() && attachmentExtent.width == extent.width && attachmentExtent.height == extent.height;
+	}
+
+	VtRenderPass::VtRenderPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtTransientAttachmentPool& attachmentPoolRef) : device{deviceRef},
+		swapchain{swapchainRef}, attachmentPool{attachmentPoolRef}
+	{
+
+	}
+
+	VtRenderPass::VtRenderPass(VtDevice& deviceRef, std::shared_ptr<VtSwapChain> swapchainRef, VtRenderGraph& renderGraphRef) : device{ deviceRef },
+		swapchain{ swapchainRef }, attachmentPool{ renderGraphRef.getAttachmentPool() }, renderGraph{ &renderGraphRef }
 	{
 
 	}
@@ -7,26 +7,30 @@ Abstract class that manages render passes
 #include "vt_device.hpp"
 #include "vt_swap_chain.hpp"
 #include "vt_pipeline.hpp"
+#include "vt_transient_attachment_pool.hpp"
+#include "vt_render_graph.hpp"
 
 namespace vt {
 	struct VtRenderPassAttachment
 	{
 		VkImage image = VK_NULL_HANDLE;
-		VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
+		VtAllocation allocation{};
 		VkImageView imageView = VK_NULL_HANDLE;
 		VkFormat format = VK_FORMAT_UNDEFINED;
 
-		void cleanAttachment(VkDevice device) {
-			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, deviceMemory, nullptr);
-			vkDestroyImageView(device, imageView, nullptr);
+		void cleanAttachment(VtDevice& device) {
+			vkDestroyImage(device.device(), image, nullptr);
+			device.getMemoryAllocator().free(allocation);
+			vkDestroyImageView(device.device(), imageView, nullptr);
 		}
 	};
 
 	class VtRenderPass
 	{
 	public:
-		VtRenderPass(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain);
+		VtRenderPass(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtTransientAttachmentPool& attachmentPool);
+		//Render graph mode: attachments, framebuffers and barriers belong to the graph, the render pass is only kept to build compatible pipelines
+		VtRenderPass(VtDevice& device, std::shared_ptr<VtSwapChain> swapchain, VtRenderGraph& renderGraph);
 		virtual ~VtRenderPass();
 
 		VtRenderPass(const VtRenderPass&) = delete;
@@ -45,18 +49,31 @@ namespace vt {
 		void bindDefaultPipeline(VkCommandBuffer commandBuffer) {
 			vtPipeline->bind(commandBuffer);
 		}
+		VtPipeline* getDefaultPipeline() {
+			return vtPipeline.get();
+		}
 		virtual void updatePipelineRessources() = 0;
 		virtual void createPipelineRessources() = 0;
-		virtual void startRenderPass(VkCommandBuffer commandBuffer, int currentImageIndex) = 0;
-		virtual void endRenderPass(VkCommandBuffer commandBuffer, int imageIndex) = 0;
+		//Attachments are per frame in flight, imageIndex is the swapchain image presented by the frame
+		virtual void startRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex) = 0;
+		virtual void endRenderPass(VkCommandBuffer commandBuffer, int frameIndex, int imageIndex) = 0;
+		bool usesRenderGraph() const { return renderGraph != nullptr; }
 		[[nodiscard]] VkRenderPass getRenderPass();
 		[[nodiscard]] VkFramebuffer getFramebuffer(int index);
 		void cleanFramebuffer();
 	protected:
+		//Resize: the framebuffers are destroyed once the frames in flight are done with them, the vector is emptied
+		void retireFramebuffers(std::vector<VkFramebuffer>& retiredFramebuffers);
+		//True if the attachments were created for the extent of the new swapchain and can be kept
+		bool keepsAttachments(VtSwapChain& newSwapchain) const;
+
 		VtDevice& device;
 		std::shared_ptr<VtSwapChain> swapchain;
+		VtTransientAttachmentPool& attachmentPool;
+		VtRenderGraph* renderGraph = nullptr;
 		VkRenderPass renderPass = VK_NULL_HANDLE;
 		std::vector<VkFramebuffer> framebuffers;
+		VkExtent2D attachmentExtent{}; // extent the attachments were created for, fixed pass chain only
 
 		VkPipelineLayout pipelineLayout;
 		std::unique_ptr<VtPipeline> vtPipeline;
@@ -0,0 +1,225 @@
+#include "vt_render_queue.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace vt
+{
+	uint64_t VtRenderQueue::makeSortKey(uint32_t pass, uint32_t pipelineId, uint32_t materialId, float normalizedDepth, uint32_t objectId)
+	{
+		uint64_t depth = static_cast<uint64_t>(std::clamp(normalizedDepth, 0.f, 1.f) * 65535.f);
+		return (static_cast<uint64_t>(pass & 0xF) << 60)
+			| (static_cast<uint64_t>(pipelineId & 0xFF) << 52)
+			| (static_cast<uint64_t>(materialId & 0xFFFFF) << 32)
+			| (depth << 16)
+			| static_cast<uint64_t>(objectId & 0xFFFF);
+	}
+
+	uint32_t VtRenderQueue::getPipelineId(const VtPipeline* pipeline)
+	{
+		auto it = pipelineIds.find(pipeline);
+		if (it == pipelineIds.end())
+		{
+			it = pipelineIds.emplace(pipeline, static_cast<uint32_t>(pipelineIds.size())).first;
+		}
+		return it->second;
+	}
+
+	uint32_t VtRenderQueue::getMaterialId(VkDescriptorSet materialDescriptorSet)
+	{
+		auto it = materialIds.find(materialDescriptorSet);
+		if (it == materialIds.end())
+		{
+			it = materialIds.emplace(materialDescriptorSet, static_cast<uint32_t>(materialIds.size())).first;
+		}
+		return it->second;
+	}
+
+	void VtRenderQueue::sort()
+	{
+		const size_t count = packets.size();
+		keys.resize(count);
+		keysScratch.resize(count);
+		sortedOrder.resize(count);
+		orderScratch.resize(count);
+		insertionOrder.resize(count);
+		std::iota(sortedOrder.begin(), sortedOrder.end(), 0u);
+		std::iota(insertionOrder.begin(), insertionOrder.end(), 0u);
+		for (size_t i = 0; i < count; i++)
+		{
+			keys[i] = packets[i].sortKey;
+		}
+
+		//LSD radix sort, 8 bits per pass. Stable, so equal keys keep their insertion order
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			uint32_t histogram[256] = {};
+			for (size_t i = 0; i < count; i++)
+			{
+				histogram[(keys[i] >> shift) & 0xFF]++;
+			}
+
+			//Every key has the same byte here (unused key bits, single pass...), nothing to move
+			if (count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count) continue;
+
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+				keysScratch[destination] = keys[i];
+				orderScratch[destination] = sortedOrder[i];
+			}
+			keys.swap(keysScratch);
+			sortedOrder.swap(orderScratch);
+		}
+	}
+
+	VtRenderQueue::Stats VtRenderQueue::countBinds(const std::vector<uint32_t>& order) const
+	{
+		Stats result{};
+		const VtPipeline* pipeline = nullptr;
+		VkDescriptorSet material = VK_NULL_HANDLE;
+		const VtModel* model = nullptr;
+		for (uint32_t index : order)
+		{
+			const auto& packet = packets[index];
+			const auto& primitive = packet.gameObject->model->getPrimitives()[packet.primitiveIndex];
+			result.draws++;
+			if (packet.pipeline != pipeline) { result.pipelineBinds++; pipeline = packet.pipeline; }
+			if (packet.bindMaterial && primitive.material.descriptor_set != material) { result.materialBinds++; material = primitive.material.descriptor_set; }
+			if (packet.gameObject->model.get() != model) { result.bufferBinds++; model = packet.gameObject->model.get(); }
+		}
+		return result;
+	}
+
+	void VtRenderQueue::submit(
+		VkCommandBuffer commandBuffer,
+		VkDescriptorSet globalDescriptorSet,
+		VkBuffer indirectBuffer,
+		const std::function<VkDeviceSize(uint32_t)>& indirectOffset)
+	{
+		assert(sortedOrder.size() == packets.size() && "sort() must be called after adding packets");
+
+		stats = {};
+		recordRange(commandBuffer, globalDescriptorSet, 0, sortedOrder.size(), indirectBuffer, indirectOffset, stats);
+
+		unsortedStats = countBinds(insertionOrder);
+	}
+
+	void VtRenderQueue::submitParallel(
+		VkCommandBuffer commandBuffer,
+		VtSecondaryCommandRecorder& recorder,
+		int frameIndex,
+		const VtSecondaryInheritance& inheritance,
+		VkDescriptorSet globalDescriptorSet,
+		VkBuffer indirectBuffer,
+		const std::function<VkDeviceSize(uint32_t)>& indirectOffset)
+	{
+		assert(sortedOrder.size() == packets.size() && "sort() must be called after adding packets");
+
+		//Contiguous ranges keep the sorted order inside each buffer, small queues are not worth a secondary buffer per thread
+		const size_t count = sortedOrder.size();
+		uint32_t taskCount = static_cast<uint32_t>(std::min<size_t>(recorder.getThreadCount(), (count + MIN_PACKETS_PER_TASK - 1) / MIN_PACKETS_PER_TASK));
+		size_t rangeSize = taskCount > 0 ? (count + taskCount - 1) / taskCount : 0;
+
+		std::vector<Stats> taskStats(taskCount);
+		recorder.record(frameIndex, inheritance, taskCount,
+			[&](VkCommandBuffer secondaryCommandBuffer, uint32_t task)
+			{
+				size_t begin = task * rangeSize;
+				size_t end = std::min(begin + rangeSize, count);
+				recordRange(secondaryCommandBuffer, globalDescriptorSet, begin, end, indirectBuffer, indirectOffset, taskStats[task]);
+			},
+			secondaryCommandBuffers);
+
+		if (!secondaryCommandBuffers.empty())
+		{
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+		}
+
+		stats = {};
+		for (const auto& task : taskStats)
+		{
+			stats.draws += task.draws;
+			stats.pipelineBinds += task.pipelineBinds;
+			stats.materialBinds += task.materialBinds;
+			stats.bufferBinds += task.bufferBinds;
+		}
+
+		unsortedStats = countBinds(insertionOrder);
+	}
+
+	void VtRenderQueue::recordRange(
+		VkCommandBuffer commandBuffer,
+		VkDescriptorSet globalDescriptorSet,
+		size_t begin,
+		size_t end,
+		VkBuffer indirectBuffer,
+		const std::function<VkDeviceSize(uint32_t)>& indirectOffset,
+		Stats& rangeStats) const
+	{
+		const VtPipeline* boundPipeline = nullptr;
+		VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+		VkDescriptorSet boundMaterial = VK_NULL_HANDLE;
+		const VtModel* boundModel = nullptr;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const auto& packet = packets[sortedOrder[i]];
+			VtModel* model = packet.gameObject->model.get();
+			const auto& primitive = model->getPrimitives()[packet.primitiveIndex];
+
+			if (packet.pipeline != boundPipeline)
+			{
+				packet.pipeline->bind(commandBuffer);
+				boundPipeline = packet.pipeline;
+				rangeStats.pipelineBinds++;
+			}
+
+			//Everything bound through a different layout has to be bound again
+			if (packet.pipelineLayout != boundLayout)
+			{
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+				boundLayout = packet.pipelineLayout;
+				boundMaterial = VK_NULL_HANDLE;
+			}
+
+			if (packet.bindMaterial && primitive.material.descriptor_set != boundMaterial)
+			{
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipelineLayout, 1, 1, &primitive.material.descriptor_set, 0, nullptr);
+				boundMaterial = primitive.material.descriptor_set;
+				rangeStats.materialBinds++;
+			}
+
+			if (model != boundModel)
+			{
+				model->bind(commandBuffer);
+				boundModel = model;
+				rangeStats.bufferBinds++;
+			}
+
+			if (indirectBuffer != VK_NULL_HANDLE)
+			{
+				vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, indirectOffset(packet.drawIndex), 1, sizeof(VkDrawIndexedIndirectCommand));
+			}
+			else if (model->hasIndices())
+			{
+				vkCmdDrawIndexed(commandBuffer, primitive.indexCount, 1, primitive.firstIndex, primitive.firstVertex, packet.objectIndex);
+			}
+			else
+			{
+				vkCmdDraw(commandBuffer, primitive.vertexCount, 1, 0, packet.objectIndex);
+			}
+			rangeStats.draws++;
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/*
+Queue of model primitive draws sorted by a 64 bit key before being recorded.
+Key layout, most significant first: pass (4 bits), pipeline (8 bits), material (20 bits), quantized depth (16 bits), object (16 bits).
+Object data lives in the frame ring buffer, draws pass the object's slot as their first instance.
+Keys are sorted with an LSD radix sort and the recording loop only binds what changed from the previous draw.
+submitParallel splits the sorted draws in contiguous ranges recorded into secondary command buffers on worker threads.
+*/
+
+#pragma once
+
+#include "vt_game_object.hpp"
+#include "vt_model.hpp"
+#include "vt_pipeline.hpp"
+#include "vt_secondary_command_recorder.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace vt
+{
+	struct VtDrawPacket
+	{
+		uint64_t sortKey = 0;
+		VtPipeline* pipeline = nullptr;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		VtGameObject* gameObject = nullptr;
+		uint32_t primitiveIndex = 0;
+		uint32_t drawIndex = 0; // caller defined, passed back to the indirect offset callback
+		uint32_t objectIndex = 0; // slot of the object in the frame's ObjectData array, indirect commands must use it as firstInstance
+		bool bindMaterial = true; // false for pipelines that never read the material set (depth only)
+	};
+
+	class VtRenderQueue
+	{
+	public:
+		struct Stats
+		{
+			uint32_t draws = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t materialBinds = 0;
+			uint32_t bufferBinds = 0;
+		};
+
+		static uint64_t makeSortKey(uint32_t pass, uint32_t pipelineId, uint32_t materialId, float normalizedDepth, uint32_t objectId);
+
+		// Small ids for the key, stable for the lifetime of the queue
+		uint32_t getPipelineId(const VtPipeline* pipeline);
+		uint32_t getMaterialId(VkDescriptorSet materialDescriptorSet);
+
+		void clear() { packets.clear(); }
+		void add(const VtDrawPacket& packet) { packets.push_back(packet); }
+		size_t size() const { return packets.size(); }
+
+		void sort();
+		// Records the sorted packets. With an indirect buffer the draw parameters are read at indirectOffset(packet.drawIndex)
+		void submit(
+			VkCommandBuffer commandBuffer,
+			VkDescriptorSet globalDescriptorSet,
+			VkBuffer indirectBuffer = VK_NULL_HANDLE,
+			const std::function<VkDeviceSize(uint32_t)>& indirectOffset = {});
+		// Same as submit, the current render pass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+		void submitParallel(
+			VkCommandBuffer commandBuffer,
+			VtSecondaryCommandRecorder& recorder,
+			int frameIndex,
+			const VtSecondaryInheritance& inheritance,
+			VkDescriptorSet globalDescriptorSet,
+			VkBuffer indirectBuffer = VK_NULL_HANDLE,
+			const std::function<VkDeviceSize(uint32_t)>& indirectOffset = {});
+
+		// Counters of the last submit, and what recording the packets in insertion order would have cost
+		const Stats& getStats() const { return stats; }
+		const Stats& getUnsortedStats() const { return unsortedStats; }
+
+	private:
+		static constexpr size_t MIN_PACKETS_PER_TASK = 64;
+
+		Stats countBinds(const std::vector<uint32_t>& order) const;
+		// Records sortedOrder[begin, end), binds are tracked from an empty state
+		void recordRange(
+			VkCommandBuffer commandBuffer,
+			VkDescriptorSet globalDescriptorSet,
+			size_t begin,
+			size_t end,
+			VkBuffer indirectBuffer,
+			const std::function<VkDeviceSize(uint32_t)>& indirectOffset,
+			Stats& rangeStats) const;
+
+		std::vector<VtDrawPacket> packets;
+		std::vector<uint32_t> sortedOrder;
+		std::vector<uint32_t> insertionOrder;
+		std::vector<uint64_t> keys;
+		std::vector<uint64_t> keysScratch;
+		std::vector<uint32_t> orderScratch;
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
+		std::unordered_map<const VtPipeline*, uint32_t> pipelineIds;
+		std::unordered_map<VkDescriptorSet, uint32_t> materialIds;
+
+		Stats stats{};
+		Stats unsortedStats{};
+	};
+}
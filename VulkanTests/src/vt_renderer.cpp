@@ -1,15 +1,19 @@
 #include "vt_renderer.hpp"
 
 // std
+#include <algorithm>
 #include <stdexcept>
 #include <array>
 
 namespace vt
 {
-	VtRenderer::VtRenderer(VtWindow& window, VtDevice& device) : vtWindow{ window }, vtDevice{device}
+	VtRenderer::VtRenderer(VtWindow& window, VtDevice& device, VkPresentModeKHR presentMode) : vtWindow{ window }, vtDevice{device}, requestedPresentMode{ presentMode }
 	{
 		recreateSwapChain();
 		createCommandBuffers();
+		frameStartTimes.resize(vtDevice.getFramesInFlight());
+		framesPending.resize(vtDevice.getFramesInFlight(), false);
+		resetFramePacingStats();
 	}
 
 	VtRenderer::~VtRenderer()
@@ -25,20 +29,21 @@ namespace vt
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(vtDevice.device());
-
+		//No wait for idle: the new swapchain takes over the timeline values of the frames in flight and the old one is retired,
+		//the passes retire their own resources the same way
 		if (vtSwapChain == nullptr) {
-			vtSwapChain = std::make_shared<VtSwapChain>(vtDevice, extent);
+			vtSwapChain = std::make_shared<VtSwapChain>(vtDevice, extent, requestedPresentMode);
 		}
 		else
 		{
 			std::shared_ptr<VtSwapChain> oldSwapChain = std::move(vtSwapChain);
-			vtSwapChain = std::make_shared<VtSwapChain>(vtDevice, extent, oldSwapChain);
+			vtSwapChain = std::make_shared<VtSwapChain>(vtDevice, extent, requestedPresentMode, oldSwapChain);
 			
 			if (!oldSwapChain->compareSwapFormats(*vtSwapChain.get()))
 			{
 				throw std::runtime_error("Swap chain image(or depth) format has changed!");
 			}
+			vtDevice.getDeletionQueue().retire(std::move(oldSwapChain));
 		}
 		
 
@@ -47,28 +52,36 @@ namespace vt
 
 	void VtRenderer::createCommandBuffers()
 	{
-		commandBuffers.resize(VtSwapChain::MAX_FRAMES_IN_FLIGHT);
-
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = vtDevice.getCommandPool();
-		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+		//One transient pool per frame in flight, its single command buffer is reset through the pool
+		commandPools.resize(vtDevice.getFramesInFlight());
+		commandBuffers.resize(vtDevice.getFramesInFlight());
 
-		if (vkAllocateCommandBuffers(vtDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+		for (size_t i = 0; i < commandPools.size(); i++)
 		{
-			throw std::runtime_error("failed to allocate command buffers!");
+			commandPools[i] = vtDevice.createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = commandPools[i];
+			allocInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(vtDevice.device(), &allocInfo, &commandBuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
 		}
 	}
 
 	void VtRenderer::freeCommandBuffers()
 	{
-		vkFreeCommandBuffers(
-			vtDevice.device(),
-			vtDevice.getCommandPool(),
-			static_cast<uint32_t>(commandBuffers.size()),
-			commandBuffers.data());
+		//Destroying the pools frees their command buffers
+		for (auto commandPool : commandPools)
+		{
+			vkDestroyCommandPool(vtDevice.device(), commandPool, nullptr);
+		}
 
+		commandPools.clear();
 		commandBuffers.clear();
 	}
 
@@ -76,6 +89,9 @@ namespace vt
 	{
 		assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
+		currentFrameStart = std::chrono::high_resolution_clock::now();
+		pollCompletedFrames();
+
 		auto result = vtSwapChain->acquireNextImage(&currentImageIndex);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -90,9 +106,15 @@ namespace vt
 
 		isFrameStarted = true;
 
+		//acquireNextImage waited for the timeline value of this frame, everything recorded from its pool is done executing
+		if (framesPending[currentFrameIndex]) completeFrame(currentFrameIndex, std::chrono::high_resolution_clock::now());
+		vtDevice.getDeletionQueue().collect();
+		VK_CHECK_RESULT(vkResetCommandPool(vtDevice.device(), commandPools[currentFrameIndex], 0));
+
 		auto commandBuffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
 		{
@@ -116,9 +138,12 @@ namespace vt
 		}
 
 		auto result = vtSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		frameStartTimes[currentFrameIndex] = currentFrameStart;
+		framesPending[currentFrameIndex] = true;
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vtWindow.wasWindowResized()) {
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vtWindow.wasWindowResized() || presentModeChanged) {
 			vtWindow.resetWindowResizedFlag();
+			presentModeChanged = false;
 			recreateSwapChain();
 			ret = false;
 		}
@@ -128,10 +153,55 @@ namespace vt
 		}
 
 		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex + 1) % VtSwapChain::MAX_FRAMES_IN_FLIGHT;
+		currentFrameIndex = (currentFrameIndex + 1) % vtDevice.getFramesInFlight();
 		return ret;
 	}
 
+	void VtRenderer::setPresentMode(VkPresentModeKHR presentMode)
+	{
+		requestedPresentMode = presentMode;
+		presentModeChanged = true;
+	}
+
+	void VtRenderer::pollCompletedFrames()
+	{
+		auto now = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < static_cast<int>(framesPending.size()); i++)
+		{
+			if (framesPending[i] && vtSwapChain->isFrameComplete(i)) completeFrame(i, now);
+		}
+	}
+
+	void VtRenderer::completeFrame(int frameIndex, std::chrono::high_resolution_clock::time_point now)
+	{
+		float latency = std::chrono::duration<float, std::chrono::milliseconds::period>(now - frameStartTimes[frameIndex]).count();
+		framesPending[frameIndex] = false;
+		//Frames begun before the reset are not counted
+		if (frameStartTimes[frameIndex] < statsStart) return;
+
+		completedFrames++;
+		totalLatencyMilliseconds += latency;
+		maxLatencyMilliseconds = std::max(maxLatencyMilliseconds, latency);
+	}
+
+	VtRenderer::FramePacingStats VtRenderer::getFramePacingStats() const
+	{
+		FramePacingStats stats{};
+		stats.frameCount = completedFrames;
+		stats.seconds = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - statsStart).count();
+		stats.averageLatencyMilliseconds = completedFrames > 0 ? static_cast<float>(totalLatencyMilliseconds / completedFrames) : 0.f;
+		stats.maxLatencyMilliseconds = maxLatencyMilliseconds;
+		return stats;
+	}
+
+	void VtRenderer::resetFramePacingStats()
+	{
+		statsStart = std::chrono::high_resolution_clock::now();
+		completedFrames = 0;
+		totalLatencyMilliseconds = 0.0;
+		maxLatencyMilliseconds = 0.f;
+	}
+
 
 
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "vt_render_pass.hpp"
 
 // std
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <cassert>
@@ -16,7 +17,20 @@ namespace vt
 	class VtRenderer
 	{
 	public:
-		VtRenderer(VtWindow& window, VtDevice& device);
+		// Throughput and latency of the frames completed since the last reset
+		struct FramePacingStats
+		{
+			uint32_t frameCount = 0;
+			float seconds = 0.f;
+			// From the start of beginFrame, where the input of the frame has just been read, to the moment its completion
+			// is seen by the CPU. The completion is polled once per frame, so it is late by up to one CPU frame
+			float averageLatencyMilliseconds = 0.f;
+			float maxLatencyMilliseconds = 0.f;
+
+			float framesPerSecond() const { return seconds > 0.f ? frameCount / seconds : 0.f; }
+		};
+
+		VtRenderer(VtWindow& window, VtDevice& device, VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR);
 		~VtRenderer();
 
 		VtRenderer(const VtRenderer&) = delete;
@@ -47,18 +61,40 @@ namespace vt
 		VkCommandBuffer beginFrame();
 		bool endFrame();
 
+		// The swapchain is recreated at the end of the current or next frame, endFrame then returns false like on a resize
+		void setPresentMode(VkPresentModeKHR presentMode);
+		VkPresentModeKHR getPresentMode() const { return vtSwapChain->getPresentMode(); }
+
+		FramePacingStats getFramePacingStats() const;
+		void resetFramePacingStats();
+
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
 		void recreateSwapChain();
+		void pollCompletedFrames();
+		void completeFrame(int frameIndex, std::chrono::high_resolution_clock::time_point now);
 
 		VtWindow& vtWindow;
 		VtDevice& vtDevice;
 		std::shared_ptr<VtSwapChain> vtSwapChain;
+		std::vector<VkCommandPool> commandPools;
 		std::vector<VkCommandBuffer> commandBuffers;
 
 		uint32_t currentImageIndex;
 		int currentFrameIndex{0};
 		bool isFrameStarted{false};
+
+		VkPresentModeKHR requestedPresentMode;
+		bool presentModeChanged{false};
+
+		// Start of the frames submitted and not seen complete yet, per frame index
+		std::vector<std::chrono::high_resolution_clock::time_point> frameStartTimes;
+		std::vector<bool> framesPending;
+		std::chrono::high_resolution_clock::time_point currentFrameStart;
+		std::chrono::high_resolution_clock::time_point statsStart;
+		uint32_t completedFrames{0};
+		double totalLatencyMilliseconds{0.0};
+		float maxLatencyMilliseconds{0.f};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "vt_scene_bvh.hpp"
+
+// std
+#include <algorithm>
+
+namespace vt
+{
+	void VtSceneBvh::build(VtGameObject::Map& gameObjects)
+	{
+		items.clear();
+		boxes.clear();
+		for (auto& kv : gameObjects)
+		{
+			auto& obj = kv.second;
+			if (obj.model == nullptr)
+			{
+				items.push_back({ &obj, obj.getId(), NO_PRIMITIVE });
+				continue;
+			}
+
+			for (uint32_t i = 0; i < obj.model->getPrimitives().size(); i++)
+			{
+				items.push_back({ &obj, obj.getId(), i });
+			}
+		}
+
+		computeBoxes(gameObjects);
+		bvh.build(boxes);
+	}
+
+	void VtSceneBvh::update(VtGameObject::Map& gameObjects)
+	{
+		if (computeBoxes(gameObjects))
+		{
+			bvh.refit(boxes);
+		}
+		else
+		{
+			build(gameObjects);
+		}
+	}
+
+	bool VtSceneBvh::computeBoxes(VtGameObject::Map& gameObjects)
+	{
+		//Items were built in map order, which only changes when objects are added or removed
+		boxes.resize(items.size());
+		size_t itemIndex = 0;
+		for (auto& kv : gameObjects)
+		{
+			auto& obj = kv.second;
+			size_t primitiveCount = obj.model != nullptr ? obj.model->getPrimitives().size() : 1;
+			if (itemIndex + primitiveCount > items.size()) return false;
+
+			const Item& first = items[itemIndex];
+			if (first.gameObject != &obj || first.objectId != obj.getId()) return false;
+			if ((obj.model == nullptr) != (first.primitiveIndex == NO_PRIMITIVE)) return false;
+
+			if (obj.model == nullptr)
+			{
+				boxes[itemIndex++] = objectBox(obj);
+				continue;
+			}
+
+			glm::mat4 modelMatrix = obj.transform.mat4();
+			const auto& primitives = obj.model->getPrimitives();
+			for (uint32_t i = 0; i < primitives.size(); i++)
+			{
+				if (items[itemIndex].gameObject != &obj) return false;
+				boxes[itemIndex++] = primitives[i].bounds.transformed(modelMatrix);
+			}
+		}
+		return itemIndex == items.size();
+	}
+
+	VtAabb VtSceneBvh::objectBox(VtGameObject& gameObject)
+	{
+		//Point lights are drawn as a billboard of radius scale.x
+		const auto& transform = gameObject.transform;
+		float radius = std::max({ transform.scale.x, transform.scale.y, transform.scale.z });
+		return { transform.translation - glm::vec3(radius), transform.translation + glm::vec3(radius) };
+	}
+
+	VtSceneBvh::Hit VtSceneBvh::raycast(const VtRay& ray) const
+	{
+		Hit hit{};
+		VtRayHit bvhHit = bvh.raycast(ray);
+		if (!bvhHit.hit()) return hit;
+
+		hit.item = items[bvhHit.itemIndex];
+		hit.distance = bvhHit.distance;
+		return hit;
+	}
+
+	void VtSceneBvh::querySphere(const VtSphere& sphere, std::vector<uint32_t>& result) const
+	{
+		bvh.querySphere(sphere, result);
+	}
+}
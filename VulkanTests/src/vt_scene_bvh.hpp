@@ -0,0 +1,62 @@
+/*
+Spatial index of the scene: a VtBvh over one world space box per model primitive and one per object without a model
+(point lights, sized by their indicator radius).
+Built when the scene is loaded, then updated once per frame after the systems have moved their objects: while the objects
+are the same the tree is only refit to the new transforms, an object added or removed rebuilds it.
+Answers picking (closest item along a ray) and overlap queries (items touching a sphere such as the range of a light).
+*/
+
+#pragma once
+
+#include "vt_bvh.hpp"
+#include "vt_game_object.hpp"
+
+// std
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace vt
+{
+	class VtSceneBvh
+	{
+	public:
+		static constexpr uint32_t NO_PRIMITIVE = std::numeric_limits<uint32_t>::max();
+
+		struct Item
+		{
+			VtGameObject* gameObject = nullptr; // Map elements keep their address when the map grows
+			VtGameObject::id_t objectId = 0;
+			uint32_t primitiveIndex = NO_PRIMITIVE; // NO_PRIMITIVE for objects without a model
+		};
+
+		struct Hit
+		{
+			Item item{};
+			float distance = std::numeric_limits<float>::max();
+
+			bool hit() const { return item.gameObject != nullptr; }
+		};
+
+		void build(VtGameObject::Map& gameObjects);
+		// Refits to the current transforms, rebuilds when the objects or their models changed since the last build
+		void update(VtGameObject::Map& gameObjects);
+
+		size_t itemCount() const { return items.size(); }
+		const Item& getItem(uint32_t index) const { return items[index]; }
+
+		// Closest item whose box the ray enters
+		Hit raycast(const VtRay& ray) const;
+		// Indices of the items whose box touches the sphere are appended to result
+		void querySphere(const VtSphere& sphere, std::vector<uint32_t>& result) const;
+
+	private:
+		// Walks the objects in map order, false as soon as they no longer match the items of the last build
+		bool computeBoxes(VtGameObject::Map& gameObjects);
+		static VtAabb objectBox(VtGameObject& gameObject);
+
+		VtBvh bvh;
+		std::vector<Item> items;
+		std::vector<VtAabb> boxes;
+	};
+}
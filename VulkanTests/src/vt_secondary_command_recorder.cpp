@@ -0,0 +1,125 @@
+#include "vt_secondary_command_recorder.hpp"
+#include "vt_swap_chain.hpp"
+
+// std
+#include <algorithm>
+
+namespace vt
+{
+	VtSecondaryCommandRecorder::VtSecondaryCommandRecorder(VtDevice& device, VtThreadPool& threadPool) : vtDevice{ device }, threadPool{ threadPool }
+	{
+		framePools.resize(vtDevice.getFramesInFlight());
+		for (auto& pools : framePools)
+		{
+			pools.resize(threadPool.getThreadCount());
+			for (auto& pool : pools)
+			{
+				//Buffers are only ever reset together with their pool
+				pool.commandPool = vtDevice.createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+			}
+		}
+	}
+
+	VtSecondaryCommandRecorder::~VtSecondaryCommandRecorder()
+	{
+		//Destroying a pool frees its command buffers
+		for (auto& pools : framePools)
+		{
+			for (auto& pool : pools)
+			{
+				vkDestroyCommandPool(vtDevice.device(), pool.commandPool, nullptr);
+			}
+		}
+	}
+
+	void VtSecondaryCommandRecorder::beginFrame(int frameIndex)
+	{
+		for (auto& pool : framePools[frameIndex])
+		{
+			VK_CHECK_RESULT(vkResetCommandPool(vtDevice.device(), pool.commandPool, 0));
+			pool.usedCount = 0;
+		}
+	}
+
+	VkCommandBuffer VtSecondaryCommandRecorder::acquireCommandBuffer(WorkerCommandPool& pool)
+	{
+		if (pool.usedCount == pool.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = pool.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(vtDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+		return pool.commandBuffers[pool.usedCount++];
+	}
+
+	void VtSecondaryCommandRecorder::record(
+		int frameIndex,
+		const VtSecondaryInheritance& inheritance,
+		uint32_t taskCount,
+		const std::function<void(VkCommandBuffer, uint32_t)>& recordTask,
+		std::vector<VkCommandBuffer>& commandBuffers)
+	{
+		commandBuffers.resize(taskCount);
+		if (taskCount == 0) return;
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = inheritance.renderPass;
+		inheritanceInfo.subpass = inheritance.subpass;
+		inheritanceInfo.framebuffer = inheritance.framebuffer;
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(inheritance.extent.width);
+		viewport.height = static_cast<float>(inheritance.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, inheritance.extent };
+
+		//One job per slot, a slot records its tasks one after the other so its pools are never used by two threads at once
+		auto& pools = framePools[frameIndex];
+		uint32_t slotCount = std::min(taskCount, static_cast<uint32_t>(pools.size()));
+		for (uint32_t slot = 0; slot < slotCount; slot++)
+		{
+			threadPool.submit([&, slot]()
+				{
+					for (uint32_t task = slot; task < taskCount; task += slotCount)
+					{
+						VkCommandBuffer commandBuffer = acquireCommandBuffer(pools[slot]);
+
+						VkCommandBufferBeginInfo beginInfo{};
+						beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+						beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+						beginInfo.pInheritanceInfo = &inheritanceInfo;
+						if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+						{
+							throw std::runtime_error("failed to to begin recording command buffer!");
+						}
+
+						//Dynamic state is not inherited from the primary command buffer
+						vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+						vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+						recordTask(commandBuffer, task);
+
+						if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+						{
+							throw std::runtime_error("failed to record command buffer!");
+						}
+						commandBuffers[task] = commandBuffer;
+					}
+				});
+		}
+		threadPool.wait();
+	}
+}
@@ -0,0 +1,65 @@
+/*
+Records secondary command buffers on the threads of a VtThreadPool.
+Every worker slot owns one command pool per frame in flight, so pools are never shared between threads and are reset in one call once the timeline has reached the frame.
+*/
+
+#pragma once
+
+#include "vt_device.hpp"
+#include "vt_thread_pool.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace vt
+{
+	// Render pass the secondary command buffers are executed in
+	struct VtSecondaryInheritance
+	{
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+	};
+
+	class VtSecondaryCommandRecorder
+	{
+	public:
+		VtSecondaryCommandRecorder(VtDevice& device, VtThreadPool& threadPool);
+		~VtSecondaryCommandRecorder();
+
+		VtSecondaryCommandRecorder(const VtSecondaryCommandRecorder&) = delete;
+		VtSecondaryCommandRecorder& operator=(const VtSecondaryCommandRecorder&) = delete;
+
+		uint32_t getThreadCount() const { return threadPool.getThreadCount(); }
+
+		// Resets every pool of the frame, the command buffers of its previous submission must be done
+		void beginFrame(int frameIndex);
+
+		// Calls recordTask(commandBuffer, taskIndex) for each task on the worker threads and blocks until all are recorded.
+		// Buffers are begun inside the render pass with the viewport and scissor set to the extent, and returned in task order
+		void record(
+			int frameIndex,
+			const VtSecondaryInheritance& inheritance,
+			uint32_t taskCount,
+			const std::function<void(VkCommandBuffer, uint32_t)>& recordTask,
+			std::vector<VkCommandBuffer>& commandBuffers);
+
+	private:
+		struct WorkerCommandPool
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t usedCount = 0;
+		};
+
+		VkCommandBuffer acquireCommandBuffer(WorkerCommandPool& pool);
+
+		VtDevice& vtDevice;
+		VtThreadPool& threadPool;
+		// [frameIndex][slot]
+		std::vector<std::vector<WorkerCommandPool>> framePools;
+	};
+}
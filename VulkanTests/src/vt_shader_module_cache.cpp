@@ -0,0 +1,67 @@
+#include "vt_shader_module_cache.hpp"
+
+#include "vt_pipeline.hpp"
+
+// std
+#include <stdexcept>
+
+namespace vt
+{
+	VtShaderModuleCache::VtShaderModuleCache(VkDevice device) : device{ device }
+	{
+	}
+
+	VtShaderModuleCache::~VtShaderModuleCache()
+	{
+		for (auto& [hash, shaderModule] : modulesByContent)
+		{
+			vkDestroyShaderModule(device, shaderModule, nullptr);
+		}
+	}
+
+	uint64_t VtShaderModuleCache::hashCode(const std::vector<char>& code)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (char byte : code)
+		{
+			hash ^= static_cast<uint8_t>(byte);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	VkShaderModule VtShaderModuleCache::getModule(const std::string& filepath)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto found = modulesByPath.find(filepath);
+			if (found != modulesByPath.end())
+			{
+				return found->second;
+			}
+		}
+
+		//Reading and hashing outside of the lock, several threads may load different files at once
+		auto code = VtPipeline::readFile(filepath);
+		uint64_t hash = hashCode(code);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto sameContent = modulesByContent.find(hash);
+		if (sameContent == modulesByContent.end())
+		{
+			VkShaderModuleCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			createInfo.codeSize = code.size();
+			createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+			VkShaderModule shaderModule;
+			if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create shader module");
+			}
+			sameContent = modulesByContent.emplace(hash, shaderModule).first;
+		}
+		modulesByPath[filepath] = sameContent->second;
+		return sameContent->second;
+	}
+}
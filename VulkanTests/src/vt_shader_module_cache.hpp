@@ -0,0 +1,44 @@
+/*
+Shader modules shared by every pipeline of the device, owned by VtDevice.
+A .spv file is read once, its module is then handed to every pipeline naming the same path. Files are also deduplicated
+by content: permutations compiled to different files that end up with identical SPIR-V share one module.
+Modules stay alive until the device is destroyed, pipelines never destroy them. Safe to call from the compilation threads.
+*/
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vt
+{
+	class VtShaderModuleCache
+	{
+	public:
+		explicit VtShaderModuleCache(VkDevice device);
+		~VtShaderModuleCache();
+
+		VtShaderModuleCache(const VtShaderModuleCache&) = delete;
+		VtShaderModuleCache& operator=(const VtShaderModuleCache&) = delete;
+
+		// Throws if the file can't be read or the module can't be created
+		VkShaderModule getModule(const std::string& filepath);
+
+		uint32_t getModuleCount() const { return static_cast<uint32_t>(modulesByContent.size()); }
+
+	private:
+		static uint64_t hashCode(const std::vector<char>& code);
+
+		VkDevice device;
+		std::mutex mutex;
+		std::unordered_map<std::string, VkShaderModule> modulesByPath;
+		// FNV-1a of the SPIR-V, several paths can point to the same entry
+		std::unordered_map<uint64_t, VkShaderModule> modulesByContent;
+	};
+}
@@ -1,6 +1,7 @@
 #include "vt_swap_chain.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -12,18 +13,20 @@
 namespace vt
 {
 
-    VtSwapChain::VtSwapChain(VtDevice& deviceRef, VkExtent2D extent)
-        : device{ deviceRef }, windowExtent{ extent }
+    VtSwapChain::VtSwapChain(VtDevice& deviceRef, VkExtent2D extent, VkPresentModeKHR presentMode)
+        : device{ deviceRef }, windowExtent{ extent }, presentMode{ presentMode }
     {
         init();
     }
 
-    VtSwapChain::VtSwapChain(VtDevice& deviceRef, VkExtent2D extent, std::shared_ptr<VtSwapChain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous }
+    VtSwapChain::VtSwapChain(VtDevice& deviceRef, VkExtent2D extent, VkPresentModeKHR presentMode, std::shared_ptr<VtSwapChain> previous)
+        : device{ deviceRef }, windowExtent{ extent }, presentMode{ presentMode }, oldSwapChain{ previous }
     {
-        init();
+        createSwapChain();
+        createImageViews();
+        takeSyncObjects(*previous);
 
-        // Clean up old swap chain since it's no longer needed
+        // The renderer keeps the old swap chain until the frames presenting its images have completed
         oldSwapChain = nullptr;
     }
 
@@ -34,6 +37,21 @@ namespace vt
         createSyncObjects();
     }
 
+    void VtSwapChain::takeSyncObjects(VtSwapChain& previous)
+    {
+        // The timeline values of the previous swap chain are the ones of the frames still in flight, waiting on them
+        // before reusing a frame replaces waiting for the device to be idle
+        imageAvailableSemaphores = std::move(previous.imageAvailableSemaphores);
+        renderFinishedSemaphores = std::move(previous.renderFinishedSemaphores);
+        frameValues = std::move(previous.frameValues);
+        currentFrame = previous.currentFrame;
+        previous.imageAvailableSemaphores.clear();
+        previous.renderFinishedSemaphores.clear();
+        previous.frameValues.clear();
+
+        imageValues.resize(imageCount(), 0);
+    }
+
     VtSwapChain::~VtSwapChain()
     {
         for (auto imageView : swapChainImageViews)
@@ -49,23 +67,18 @@ namespace vt
         }
 
 
-        // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        // cleanup synchronization objects, unless a newer swap chain took them over
+        for (size_t i = 0; i < imageAvailableSemaphores.size(); i++)
         {
             vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
         }
     }
 
     VkResult VtSwapChain::acquireNextImage(uint32_t* imageIndex)
     {
-        vkWaitForFences(
-            device.device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        // Previous submission of this frame, its semaphores and command buffer can be reused once it is reached
+        device.getTimeline().wait(frameValues[currentFrame]);
 
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
@@ -81,11 +94,8 @@ namespace vt
     VkResult VtSwapChain::submitCommandBuffers(
         const VkCommandBuffer* buffers, uint32_t* imageIndex)
     {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
-        {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-        }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+        // Last frame rendering to this image, normally reached already: the image was presented before being acquired again
+        device.getTimeline().wait(imageValues[*imageIndex]);
 
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -103,12 +113,9 @@ namespace vt
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        // Signals the next value of the device timeline as well, nothing to reset before reusing it
+        frameValues[currentFrame] = device.getTimeline().submit(device.graphicsQueue(), submitInfo, true);
+        imageValues[*imageIndex] = frameValues[currentFrame];
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -124,20 +131,26 @@ namespace vt
 
         auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % device.getFramesInFlight();
 
         return result;
     }
 
+    bool VtSwapChain::isFrameComplete(int frameIndex)
+    {
+        return device.getTimeline().isComplete(frameValues[frameIndex]);
+    }
+
     void VtSwapChain::createSwapChain()
     {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        // Each frame in flight can hold an image, with one more for the presentation engine
+        uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, device.getFramesInFlight());
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount)
         {
@@ -222,25 +235,22 @@ namespace vt
 
     void VtSwapChain::createSyncObjects()
     {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        const uint32_t framesInFlight = device.getFramesInFlight();
+        imageAvailableSemaphores.resize(framesInFlight);
+        renderFinishedSemaphores.resize(framesInFlight);
+        // 0 is the initial value of the timeline, nothing to wait for before the first submissions
+        frameValues.resize(framesInFlight, 0);
+        imageValues.resize(imageCount(), 0);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        for (size_t i = 0; i < framesInFlight; i++)
         {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
                 vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+                VK_SUCCESS)
             {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
@@ -267,24 +277,35 @@ namespace vt
     {
         for (const auto& availablePresentMode : availablePresentModes)
         {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+            if (availablePresentMode == presentMode)
             {
-                std::cout << "Present mode: Mailbox" << std::endl;
+                std::cout << "Present mode: " << getPresentModeName(presentMode) << ", " << device.getFramesInFlight() << " frames in flight" << std::endl;
                 return availablePresentMode;
             }
         }
 
-        // for (const auto &availablePresentMode : availablePresentModes) {
-        //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //     std::cout << "Present mode: Immediate" << std::endl;
-        //     return availablePresentMode;
-        //   }
-        // }
-
-        std::cout << "Present mode: V-Sync" << std::endl;
+        std::cout << "Present mode: " << getPresentModeName(presentMode) << " not supported, falling back to " << getPresentModeName(VK_PRESENT_MODE_FIFO_KHR)
+            << ", " << device.getFramesInFlight() << " frames in flight" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    const char* VtSwapChain::getPresentModeName(VkPresentModeKHR presentMode)
+    {
+        switch (presentMode)
+        {
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "FIFO (V-Sync)";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "FIFO relaxed";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "Mailbox";
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "Immediate";
+        default:
+            return "Unknown";
+        }
+    }
+
     VkExtent2D VtSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
     {
         if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
@@ -16,21 +16,25 @@ namespace vt
     class VtSwapChain
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-        VtSwapChain(VtDevice& deviceRef, VkExtent2D windowExtent);
-        VtSwapChain(VtDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<VtSwapChain> previous);
+        // The number of frames in flight is the one of the device. presentMode falls back to FIFO, the only mode every
+        // surface supports, when the surface does not offer it
+        VtSwapChain(VtDevice& deviceRef, VkExtent2D windowExtent, VkPresentModeKHR presentMode);
+        VtSwapChain(VtDevice& deviceRef, VkExtent2D windowExtent, VkPresentModeKHR presentMode, std::shared_ptr<VtSwapChain> previous);
         ~VtSwapChain();
 
         VtSwapChain(const VtSwapChain&) = delete;
         VtSwapChain& operator=(const VtSwapChain&) = delete;
 
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
+        // Mode actually in use, may differ from the requested one
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
+        static const char* getPresentModeName(VkPresentModeKHR presentMode);
 
         float extentAspectRatio()
         {
@@ -40,6 +44,8 @@ namespace vt
 
         VkResult acquireNextImage(uint32_t* imageIndex);
         VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+        // Non blocking, true once the last submission of frameIndex has completed (or if nothing was submitted yet)
+        bool isFrameComplete(int frameIndex);
 
         bool compareSwapFormats(const VtSwapChain& swapChain) const
         {
@@ -52,6 +58,7 @@ namespace vt
         void createSwapChain();
         void createImageViews();
         void createSyncObjects();
+        void takeSyncObjects(VtSwapChain& previous);
 
         // Helper functions
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(
@@ -69,14 +76,16 @@ namespace vt
 
         VtDevice& device;
         VkExtent2D windowExtent;
+        VkPresentModeKHR presentMode; // requested one until createSwapChain picks the mode in use
 
         VkSwapchainKHR swapChain;
         std::shared_ptr<VtSwapChain> oldSwapChain;
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        // Values of the device timeline signalled by the last submission of each frame and to each image
+        std::vector<uint64_t> frameValues;
+        std::vector<uint64_t> imageValues;
         int currentFrame{0};
     };
 
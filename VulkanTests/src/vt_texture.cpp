@@ -45,7 +45,7 @@ namespace vt
         imageInfo.extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
         imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
-        vtDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+        vtDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation);
 
         transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
@@ -92,7 +92,7 @@ namespace vt
     vt::Texture::~Texture()
     {
         vkDestroyImage(vtDevice.device(), image, nullptr);
-        vkFreeMemory(vtDevice.device(), imageMemory, nullptr);
+        vtDevice.getMemoryAllocator().free(imageAllocation);
         vkDestroyImageView(vtDevice.device(), imageView, nullptr);
         vkDestroySampler(vtDevice.device(), sampler, nullptr);
     }
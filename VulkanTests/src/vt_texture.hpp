@@ -35,7 +35,7 @@ namespace vt
 
 		VtDevice& vtDevice;
 		VkImage image;
-		VkDeviceMemory imageMemory;
+		VtAllocation imageAllocation;
 		VkImageView imageView;
 		VkSampler sampler;
 		VkFormat imageFormat;
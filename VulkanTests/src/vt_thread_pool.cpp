@@ -0,0 +1,92 @@
+#include "vt_thread_pool.hpp"
+
+// std
+#include <algorithm>
+
+namespace vt
+{
+	VtThreadPool::VtThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back([this]() { workerLoop(); });
+		}
+	}
+
+	VtThreadPool::~VtThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		jobAvailable.notify_all();
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void VtThreadPool::submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			jobs.push(std::move(job));
+		}
+		jobAvailable.notify_one();
+	}
+
+	void VtThreadPool::wait()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		jobsFinished.wait(lock, [this]() { return jobs.empty() && activeJobs == 0; });
+	}
+
+	void VtThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& task)
+	{
+		if (count == 0) return;
+
+		//A few chunks per thread so that uneven work still balances
+		size_t chunkCount = std::min(count, static_cast<size_t>(getThreadCount()) * 4);
+		size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+		for (size_t begin = 0; begin < count; begin += chunkSize)
+		{
+			size_t end = std::min(begin + chunkSize, count);
+			submit([&task, begin, end]() { task(begin, end); });
+		}
+		wait();
+	}
+
+	void VtThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (stopping && jobs.empty()) return;
+
+				job = std::move(jobs.front());
+				jobs.pop();
+				activeJobs++;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				activeJobs--;
+				if (jobs.empty() && activeJobs == 0)
+				{
+					jobsFinished.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+/*
+Small fixed size pool of worker threads.
+Jobs are plain std::function, parallelFor splits a range into chunks and blocks until every chunk is done.
+*/
+
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace vt
+{
+	class VtThreadPool
+	{
+	public:
+		// 0 uses one thread per hardware thread
+		explicit VtThreadPool(uint32_t threadCount = 0);
+		~VtThreadPool();
+
+		VtThreadPool(const VtThreadPool&) = delete;
+		VtThreadPool& operator=(const VtThreadPool&) = delete;
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+		void submit(std::function<void()> job);
+		// Blocks until every submitted job has finished
+		void wait();
+		// Calls task(begin, end) on sub ranges of [0, count) from the worker threads and waits for all of them
+		void parallelFor(size_t count, const std::function<void(size_t, size_t)>& task);
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		std::condition_variable jobsFinished;
+		size_t activeJobs = 0;
+		bool stopping = false;
+	};
+}
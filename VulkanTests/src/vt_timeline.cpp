@@ -0,0 +1,115 @@
+#include "vt_timeline.hpp"
+
+// std
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace vt
+{
+	VtTimeline::VtTimeline(VkDevice device) : device{ device }
+	{
+		//The instance is Vulkan 1.0, the entry points of the extension are loaded from the device
+		getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+		waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+		if (getSemaphoreCounterValue == nullptr || waitSemaphores == nullptr)
+		{
+			throw std::runtime_error("failed to load timeline semaphore functions!");
+		}
+
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create timeline semaphore!");
+		}
+	}
+
+	VtTimeline::~VtTimeline()
+	{
+		vkDestroySemaphore(device, semaphore, nullptr);
+	}
+
+	uint64_t VtTimeline::submit(VkQueue queue, const VkSubmitInfo& submitInfo, bool endsFrame)
+	{
+		const uint64_t value = lastSubmittedValue + 1;
+
+		//Values of the binary semaphores are ignored but there has to be one per signal semaphore
+		std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+		signalSemaphores.push_back(semaphore);
+		std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+		signalValues.back() = value;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.pNext = submitInfo.pNext;
+		timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+		timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+		VkSubmitInfo timelineSubmitInfo = submitInfo;
+		timelineSubmitInfo.pNext = &timelineInfo;
+		timelineSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		timelineSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+		if (vkQueueSubmit(queue, 1, &timelineSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit command buffer!");
+		}
+		lastSubmittedValue = value;
+
+		if (endsFrame)
+		{
+			submittedFrames++;
+			pendingFrames.push_back({ submittedFrames, value });
+		}
+		return value;
+	}
+
+	uint64_t VtTimeline::getCompletedValue()
+	{
+		uint64_t value = 0;
+		if (getSemaphoreCounterValue(device, semaphore, &value) == VK_SUCCESS)
+		{
+			completedValue = value;
+		}
+		return completedValue;
+	}
+
+	bool VtTimeline::isComplete(uint64_t value)
+	{
+		return value <= completedValue || value <= getCompletedValue();
+	}
+
+	void VtTimeline::wait(uint64_t value)
+	{
+		if (value <= completedValue) return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &semaphore;
+		waitInfo.pValues = &value;
+		if (waitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to wait for timeline semaphore!");
+		}
+		completedValue = std::max(completedValue, value);
+	}
+
+	bool VtTimeline::isFrameComplete(uint64_t frameNumber)
+	{
+		if (frameNumber > submittedFrames) return false;
+
+		while (!pendingFrames.empty() && isComplete(pendingFrames.front().value))
+		{
+			pendingFrames.pop_front();
+		}
+		return pendingFrames.empty() || frameNumber < pendingFrames.front().frameNumber;
+	}
+}
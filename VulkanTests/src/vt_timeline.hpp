@@ -0,0 +1,66 @@
+/*
+Timeline semaphore of the graphics queue, owned by VtDevice, the one clock of GPU completion.
+Every submission to the queue goes through submit(), which signals the next value of the timeline along with its own
+semaphores: frames, one-shot uploads. A value is complete once the GPU has finished that submission and, the signals of a
+queue covering every earlier command, all the submissions before it.
+Frames are numbered as they are recorded. Work recorded into a frame can't know the value its submission will signal
+(an upload may be submitted while the frame is recorded), so it is tracked by frame number instead: deferred deletions
+and readbacks keep the number of the frame recording them and check isFrameComplete.
+Not thread safe, submissions and checks are made by the main thread.
+*/
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <deque>
+
+namespace vt
+{
+	class VtTimeline
+	{
+	public:
+		// The device must have VK_KHR_timeline_semaphore and its feature enabled
+		VtTimeline(VkDevice device);
+		~VtTimeline();
+
+		VtTimeline(const VtTimeline&) = delete;
+		VtTimeline& operator=(const VtTimeline&) = delete;
+
+		VkSemaphore getSemaphore() const { return semaphore; }
+
+		// Submits with the next value of the timeline added to the signal semaphores and returns that value.
+		// endsFrame marks the submission of the frame being recorded, the next frame starts recording
+		uint64_t submit(VkQueue queue, const VkSubmitInfo& submitInfo, bool endsFrame = false);
+
+		// Non blocking
+		uint64_t getCompletedValue();
+		bool isComplete(uint64_t value);
+		// Blocks the CPU until the GPU has reached value
+		void wait(uint64_t value);
+
+		// Number of the frame being recorded (or of the next one between frames), the first frame is 1
+		uint64_t getRecordingFrame() const { return submittedFrames + 1; }
+		// Non blocking, false for a frame not submitted yet
+		bool isFrameComplete(uint64_t frameNumber);
+
+	private:
+		struct SubmittedFrame
+		{
+			uint64_t frameNumber;
+			uint64_t value;
+		};
+
+		VkDevice device;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue = nullptr;
+		PFN_vkWaitSemaphoresKHR waitSemaphores = nullptr;
+
+		uint64_t lastSubmittedValue = 0;
+		uint64_t completedValue = 0; // last value read back, the counter only grows
+		uint64_t submittedFrames = 0;
+		std::deque<SubmittedFrame> pendingFrames; // submitted frames not seen complete yet, oldest first
+	};
+}
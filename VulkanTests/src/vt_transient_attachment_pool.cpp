@@ -0,0 +1,253 @@
+#include "vt_transient_attachment_pool.hpp"
+#include "vt_render_pass.hpp"
+#include "vt_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <stdexcept>
+
+namespace vt
+{
+	namespace
+	{
+		double toMegabytes(VkDeviceSize bytes)
+		{
+			return static_cast<double>(bytes) / (1024.0 * 1024.0);
+		}
+	}
+
+	VtTransientAttachmentPool::VtTransientAttachmentPool(VtDevice& device) : device{ device }
+	{
+		handle = std::make_shared<VtTransientAttachmentPool*>(this);
+	}
+
+	VtTransientAttachmentPool::~VtTransientAttachmentPool()
+	{
+		assert(imageSlots.empty() && "Transient images must be destroyed before their pool");
+		//Like the live images, the device is idle by now
+		for (auto& retired : retiredImages)
+		{
+			vkDestroyImage(device.device(), retired.first, nullptr);
+		}
+		for (auto& slot : slots)
+		{
+			device.getMemoryAllocator().free(slot->allocation);
+		}
+	}
+
+	VkImage VtTransientAttachmentPool::createImage(uint32_t frameIndex, const VkImageCreateInfo& imageInfo, VtFramePass firstPass, VtFramePass lastPass)
+	{
+		return createImage(frameIndex, imageInfo, static_cast<uint32_t>(firstPass), static_cast<uint32_t>(lastPass));
+	}
+
+	VkImage VtTransientAttachmentPool::createImage(uint32_t frameIndex, const VkImageCreateInfo& imageInfo, uint32_t firstPass, uint32_t lastPass)
+	{
+		assert(frameIndex < device.getFramesInFlight() && "frameIndex out of range");
+		assert(firstPass <= lastPass && "Transient image used before it is created");
+
+		VkImage image;
+		if (vkCreateImage(device.device(), &imageInfo, nullptr, &image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create image!");
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(device.device(), image, &requirements);
+
+		//Tile based GPUs only back such memory when an attachment has to be spilled
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		if ((imageInfo.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) &&
+			device.getMemoryAllocator().hasMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+		{
+			properties = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		}
+
+		Slot* slot = findSlot(frameIndex, requirements, properties, firstPass, lastPass);
+		if (slot == nullptr)
+		{
+			auto newSlot = std::make_unique<Slot>();
+			newSlot->id = nextSlotId++;
+			newSlot->frameIndex = frameIndex;
+			newSlot->properties = properties;
+			newSlot->allocation = device.getMemoryAllocator().allocate(
+				requirements,
+				properties,
+				VtAllocationKind::Dedicated,
+				VtMemoryCategory::RenderTarget);
+			slot = newSlot.get();
+			slots.push_back(std::move(newSlot));
+		}
+
+		if (vkBindImageMemory(device.device(), image, slot->allocation.memory, slot->allocation.offset) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to bind image memory!");
+		}
+
+		slot->lifetimes.push_back({ image, firstPass, lastPass, requirements.size });
+		imageSlots[image] = slot;
+		return image;
+	}
+
+	VtTransientAttachmentPool::Slot* VtTransientAttachmentPool::detachImage(VkImage image)
+	{
+		auto it = imageSlots.find(image);
+		assert(it != imageSlots.end() && "Image was not created by this pool");
+		Slot* slot = it->second;
+		imageSlots.erase(it);
+
+		auto& lifetimes = slot->lifetimes;
+		lifetimes.erase(std::remove_if(lifetimes.begin(), lifetimes.end(), [image](const Lifetime& lifetime) { return lifetime.image == image; }), lifetimes.end());
+		return slot;
+	}
+
+	void VtTransientAttachmentPool::freeSlot(Slot* slot)
+	{
+		//Last image of the slot, the memory goes back to the allocator (and to the driver for dedicated allocations)
+		device.getMemoryAllocator().free(slot->allocation);
+		slots.erase(std::find_if(slots.begin(), slots.end(), [slot](const std::unique_ptr<Slot>& other) { return other.get() == slot; }));
+	}
+
+	void VtTransientAttachmentPool::destroyImage(VkImage image)
+	{
+		if (image == VK_NULL_HANDLE) return;
+
+		Slot* slot = detachImage(image);
+		vkDestroyImage(device.device(), image, nullptr);
+		if (slot->lifetimes.empty()) freeSlot(slot);
+	}
+
+	void VtTransientAttachmentPool::retireImage(VkImage image)
+	{
+		if (image == VK_NULL_HANDLE) return;
+
+		//The slot stays, even empty, until the image is destroyed: the images created in the meantime can take its memory
+		retiredImages[image] = detachImage(image)->id;
+		device.getDeletionQueue().retire([pool = std::weak_ptr<VtTransientAttachmentPool*>(handle), image]()
+			{
+				if (auto owner = pool.lock()) (*owner)->destroyRetiredImage(image);
+			});
+	}
+
+	void VtTransientAttachmentPool::destroyRetiredImage(VkImage image)
+	{
+		auto it = retiredImages.find(image);
+		assert(it != retiredImages.end() && "Image was not retired by this pool");
+		uint64_t slotId = it->second;
+		retiredImages.erase(it);
+		vkDestroyImage(device.device(), image, nullptr);
+
+		auto slot = std::find_if(slots.begin(), slots.end(), [slotId](const std::unique_ptr<Slot>& other) { return other->id == slotId; });
+		if (slot != slots.end() && (*slot)->lifetimes.empty()) freeSlot(slot->get());
+	}
+
+	VtTransientAttachmentPool::Slot* VtTransientAttachmentPool::findSlot(uint32_t frameIndex, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, uint32_t firstPass, uint32_t lastPass) const
+	{
+		//Smallest memory of the frame that fits and is not used by any image alive at the same time
+		Slot* bestSlot = nullptr;
+		for (auto& slot : slots)
+		{
+			if (slot->frameIndex != frameIndex || slot->properties != properties) continue;
+
+			const VtAllocation& allocation = slot->allocation;
+			if (allocation.size < requirements.size) continue;
+			if (allocation.offset % requirements.alignment != 0) continue;
+			if ((requirements.memoryTypeBits & (1u << allocation.block->getMemoryTypeIndex())) == 0) continue;
+
+			bool overlaps = std::any_of(slot->lifetimes.begin(), slot->lifetimes.end(), [&](const Lifetime& lifetime)
+				{
+					return firstPass <= lifetime.lastPass && lifetime.firstPass <= lastPass;
+				});
+			if (overlaps) continue;
+
+			if (bestSlot == nullptr || allocation.size < bestSlot->allocation.size)
+			{
+				bestSlot = slot.get();
+			}
+		}
+		return bestSlot;
+	}
+
+	void VtTransientAttachmentPool::createAttachments(
+		const VkImageCreateInfo& imageInfo,
+		VkImageAspectFlags aspectMask,
+		VtFramePass firstPass,
+		VtFramePass lastPass,
+		std::vector<VtRenderPassAttachment>& attachments)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = imageInfo.format;
+		viewInfo.subresourceRange.aspectMask = aspectMask;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		attachments.resize(device.getFramesInFlight());
+		for (uint32_t i = 0; i < device.getFramesInFlight(); i++)
+		{
+			auto& attachment = attachments[i];
+			attachment.format = imageInfo.format;
+			attachment.image = createImage(i, imageInfo, firstPass, lastPass);
+			//The memory belongs to the pool
+			attachment.allocation = {};
+
+			viewInfo.image = attachment.image;
+			VK_CHECK_RESULT(vkCreateImageView(device.device(), &viewInfo, nullptr, &attachment.imageView));
+		}
+	}
+
+	void VtTransientAttachmentPool::cleanAttachments(std::vector<VtRenderPassAttachment>& attachments)
+	{
+		for (auto& attachment : attachments)
+		{
+			vkDestroyImageView(device.device(), attachment.imageView, nullptr);
+			destroyImage(attachment.image);
+		}
+		attachments.clear();
+	}
+
+	void VtTransientAttachmentPool::retireAttachments(std::vector<VtRenderPassAttachment>& attachments)
+	{
+		VkDevice vkDevice = device.device();
+		for (auto& attachment : attachments)
+		{
+			VkImageView imageView = attachment.imageView;
+			device.getDeletionQueue().retire([vkDevice, imageView]() { vkDestroyImageView(vkDevice, imageView, nullptr); });
+			retireImage(attachment.image);
+		}
+		attachments.clear();
+	}
+
+	VtTransientAttachmentPool::Stats VtTransientAttachmentPool::getStats() const
+	{
+		Stats stats{};
+		for (auto& slot : slots)
+		{
+			stats.memoryCount++;
+			stats.memoryBytes += slot->allocation.size;
+			if (slot->properties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) stats.lazilyAllocatedCount++;
+			for (auto& lifetime : slot->lifetimes)
+			{
+				stats.imageCount++;
+				stats.imageBytes += lifetime.size;
+			}
+		}
+		return stats;
+	}
+
+	void VtTransientAttachmentPool::printStats(std::ostream& stream) const
+	{
+		Stats stats = getStats();
+
+		std::ios_base::fmtflags flags = stream.flags();
+		stream << std::fixed << std::setprecision(2);
+		stream << "Transient attachments: " << stats.imageCount << " images for " << device.getFramesInFlight() << " frames in flight"
+			<< " | memory " << toMegabytes(stats.memoryBytes) << " MB in " << stats.memoryCount << " allocations (" << stats.lazilyAllocatedCount << " lazily allocated)"
+			<< " | without aliasing " << toMegabytes(stats.imageBytes) << " MB" << std::endl;
+		stream.flags(flags);
+	}
+}
@@ -0,0 +1,112 @@
+/*
+Owner of the screen sized images that are written and read within a single frame (G-buffer, lighting, depth pyramid...).
+They exist once per frame in flight instead of once per swapchain image: the images of a frame are only touched again once
+the timeline has reached that frame, whichever swapchain image it presents to.
+Each image declares the range of frame passes it is alive in. Images of the same frame whose ranges do not overlap share
+the same memory, so the first use of an image in a frame must discard its content (UNDEFINED old layout).
+Lifetimes are plain pass indices, VtFramePass is the order of the fixed pass chain and a render graph uses its own execution order.
+Images created with TRANSIENT_ATTACHMENT usage never leave tile memory and get lazily allocated memory where the device has some.
+On resize the old images are retired instead of destroyed: their memory is released to the new images of the same frame
+right away, which only touch it once that frame's previous submission has completed. A window that shrinks or keeps its
+size fits in the existing memory and allocates nothing, the memory nobody reclaimed is freed with the old images.
+The pool may be destroyed before the deletion queue runs its retired images: it destroys them itself and the queue entries
+find it gone.
+*/
+
+#pragma once
+
+#include "vt_device.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace vt
+{
+	struct VtRenderPassAttachment;
+
+	// Order in which the passes of a frame are recorded
+	enum class VtFramePass : uint32_t
+	{
+		GBuffer, // includes the depth pre-pass and the occlusion culling phases
+		Lighting,
+		Reflection
+	};
+
+	class VtTransientAttachmentPool
+	{
+	public:
+		struct Stats
+		{
+			uint32_t imageCount = 0;
+			uint32_t memoryCount = 0;
+			VkDeviceSize imageBytes = 0; // required by the images, what they would cost without aliasing
+			VkDeviceSize memoryBytes = 0;
+			uint32_t lazilyAllocatedCount = 0; // memories only committed if the driver needs to
+		};
+
+		VtTransientAttachmentPool(VtDevice& device);
+		~VtTransientAttachmentPool();
+
+		VtTransientAttachmentPool(const VtTransientAttachmentPool&) = delete;
+		VtTransientAttachmentPool& operator=(const VtTransientAttachmentPool&) = delete;
+
+		// Image of frameIndex alive from firstPass to lastPass included, bound to memory shared with the images it does not overlap
+		VkImage createImage(uint32_t frameIndex, const VkImageCreateInfo& imageInfo, VtFramePass firstPass, VtFramePass lastPass);
+		VkImage createImage(uint32_t frameIndex, const VkImageCreateInfo& imageInfo, uint32_t firstPass, uint32_t lastPass);
+		void destroyImage(VkImage image);
+		// Resize: the memory is reused by the next images of the same frame, the image itself is destroyed through the
+		// device's deletion queue once the frames in flight are done with it
+		void retireImage(VkImage image);
+
+		// One attachment (image and view) per frame in flight, attachments[frameIndex]
+		void createAttachments(
+			const VkImageCreateInfo& imageInfo,
+			VkImageAspectFlags aspectMask,
+			VtFramePass firstPass,
+			VtFramePass lastPass,
+			std::vector<VtRenderPassAttachment>& attachments);
+		void cleanAttachments(std::vector<VtRenderPassAttachment>& attachments);
+		void retireAttachments(std::vector<VtRenderPassAttachment>& attachments);
+
+		Stats getStats() const;
+		void printStats(std::ostream& stream) const;
+
+	private:
+		struct Lifetime
+		{
+			VkImage image;
+			uint32_t firstPass;
+			uint32_t lastPass;
+			VkDeviceSize size;
+		};
+
+		// Memory shared by images of one frame with disjoint lifetimes
+		struct Slot
+		{
+			uint64_t id; // retired images find their slot by id, the Slot may have been freed meanwhile
+			uint32_t frameIndex;
+			VkMemoryPropertyFlags properties;
+			VtAllocation allocation;
+			std::vector<Lifetime> lifetimes;
+		};
+
+		Slot* detachImage(VkImage image);
+		void freeSlot(Slot* slot);
+		void destroyRetiredImage(VkImage image);
+		Slot* findSlot(uint32_t frameIndex, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, uint32_t firstPass, uint32_t lastPass) const;
+
+		VtDevice& device;
+		std::vector<std::unique_ptr<Slot>> slots;
+		std::unordered_map<VkImage, Slot*> imageSlots;
+		uint64_t nextSlotId = 0;
+
+		// Retired images not destroyed yet and the id of their slot, the pool destroys those left when it is destroyed itself
+		std::unordered_map<VkImage, uint64_t> retiredImages;
+		// Deletion queue entries hold it weakly: once the pool is gone they have nothing left to destroy
+		std::shared_ptr<VtTransientAttachmentPool*> handle;
+	};
+}